@@ -0,0 +1,109 @@
+// Multi-threaded buffer pool stress benchmark.
+//
+// Usage: buffer_pool_bench [max_threads] [seconds_per_run]
+//
+// Every worker fetches pages under a read latch and unpins them again. 90% of the
+// fetches hit a hot set that fits in the pool and the rest go uniformly across a file
+// four times larger than the pool, so misses and dirty-free evictions are mixed in.
+// Each thread count is run against a single-shard pool and the default sharded pool.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+using namespace simpledb;
+
+namespace {
+
+constexpr size_t POOL_FRAMES = 1024;
+constexpr page_id_t NUM_PAGES = static_cast<page_id_t>(POOL_FRAMES * 4);
+constexpr page_id_t HOT_PAGES = static_cast<page_id_t>(POOL_FRAMES / 2);
+
+double RunWorkload(DiskManager *disk_manager, size_t shards, size_t threads, double seconds) {
+    BufferPoolManager bpm(POOL_FRAMES, disk_manager, DEFAULT_REPLACER, shards);
+    std::atomic<bool> stop{false};
+    std::vector<uint64_t> ops(threads, 0);
+    std::vector<std::thread> workers;
+
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937 rng(static_cast<uint32_t>(t * 7919 + 1));
+            std::uniform_int_distribution<int> pct(0, 99);
+            std::uniform_int_distribution<page_id_t> hot(0, HOT_PAGES - 1);
+            std::uniform_int_distribution<page_id_t> any(0, NUM_PAGES - 1);
+            uint64_t local_ops = 0;
+            volatile char sink = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                page_id_t page_id = pct(rng) < 90 ? hot(rng) : any(rng);
+                Page *page = bpm.FetchPage(page_id, AccessType::LOOKUP);
+                if (page == nullptr) continue;
+                page->RLatch();
+                sink = sink + page->GetData()[page_id % PAGE_SIZE];
+                page->RUnlatch();
+                bpm.UnpinPage(page_id, false);
+                local_ops++;
+            }
+            ops[t] = local_ops;
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto &w : workers) w.join();
+
+    uint64_t total = 0;
+    for (uint64_t n : ops) total += n;
+    return total / seconds;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    double seconds = 2.0;
+    if (argc > 1) max_threads = std::stoul(argv[1]);
+    if (argc > 2) seconds = std::stod(argv[2]);
+
+    const std::string db_file = "buffer_pool_bench.db";
+    std::remove(db_file.c_str());
+    {
+        DiskManager disk_manager(db_file);
+        BufferPoolManager bpm(POOL_FRAMES, &disk_manager);
+        for (page_id_t i = 0; i < NUM_PAGES; ++i) {
+            page_id_t page_id;
+            Page *page = bpm.NewPage(&page_id);
+            page->GetData()[0] = static_cast<char>(page_id);
+            bpm.UnpinPage(page_id, true);
+        }
+    }
+
+    DiskManager disk_manager(db_file);
+    std::cout << "pool=" << POOL_FRAMES << " frames, file=" << NUM_PAGES << " pages, "
+              << seconds << "s per run\n";
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(20) << "1 shard (ops/s)"
+              << std::setw(20) << std::to_string(BUFFER_POOL_SHARDS) + " shards (ops/s)" << "speedup vs 1 thread\n";
+
+    double baseline = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        double single = RunWorkload(&disk_manager, 1, threads, seconds);
+        double sharded = RunWorkload(&disk_manager, BUFFER_POOL_SHARDS, threads, seconds);
+        if (threads == 1) baseline = sharded;
+        std::cout << std::left << std::setw(10) << threads << std::setw(20) << static_cast<uint64_t>(single)
+                  << std::setw(20) << static_cast<uint64_t>(sharded) << std::fixed << std::setprecision(2)
+                  << sharded / baseline << "x\n";
+        if (threads < max_threads && threads * 2 > max_threads) threads = max_threads / 2;
+    }
+
+    std::remove(db_file.c_str());
+    return 0;
+}
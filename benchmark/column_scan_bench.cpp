@@ -0,0 +1,82 @@
+// Integer filter throughput: row-format tuples vs. column arrays.
+//
+// Usage: column_scan_bench [rows] [repetitions]
+//
+// Every run evaluates "col > literal" over one INTEGER column of a three-column table,
+// with the literal chosen so about half the rows match. The row run walks a vector of
+// Tuples the way a heap scan sees them; the column runs filter a contiguous int32_t
+// array into a selection bitmap with each kernel this CPU supports.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catalog/tuple.h"
+#include "storage/column_filter.h"
+
+using namespace simpledb;
+
+namespace {
+
+template <typename F>
+double BestSeconds(size_t reps, F run) {
+    double best = 1e30;
+    for (size_t r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+void Report(const std::string &name, size_t rows, double seconds, size_t matches) {
+    double bytes = static_cast<double>(rows) * sizeof(int32_t);
+    std::cout << std::left << std::setw(16) << name << std::setw(16) << static_cast<uint64_t>(rows / seconds)
+              << std::setw(14) << std::fixed << std::setprecision(2) << bytes / seconds / 1e9 << matches << "\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    size_t rows = 16 * 1024 * 1024;
+    size_t reps = 5;
+    if (argc > 1) rows = std::stoul(argv[1]);
+    if (argc > 2) reps = std::max<size_t>(1, std::stoul(argv[2]));
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int32_t> dist(0, 1000000);
+    std::vector<int32_t> column(rows);
+    std::vector<Tuple> tuples;
+    tuples.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        column[i] = dist(rng);
+        tuples.emplace_back(std::vector<Value>{Value(static_cast<int32_t>(i)), Value(column[i]), Value("x")});
+    }
+    const int32_t literal = 500000;
+
+    std::cout << rows << " rows, filter col > " << literal << ", best of " << reps << "\n";
+    std::cout << std::left << std::setw(16) << "layout" << std::setw(16) << "rows/s" << std::setw(14)
+              << "column GB/s" << "matches\n";
+
+    size_t matches = 0;
+    double seconds = BestSeconds(reps, [&] {
+        matches = 0;
+        for (const Tuple &tuple : tuples) matches += tuple.GetValue(nullptr, 1).GetAsInt() > literal;
+    });
+    Report("row", rows, seconds, matches);
+
+    std::vector<uint64_t> bitmap(BitmapWords(rows));
+    for (int k = 0; k <= static_cast<int>(BestFilterKernel()); ++k) {
+        FilterKernel kernel = static_cast<FilterKernel>(k);
+        seconds = BestSeconds(reps, [&] { FilterInt32(column.data(), rows, CompareOp::GT, literal, bitmap.data(), kernel); });
+        matches = 0;
+        ForEachSelected(bitmap.data(), bitmap.size(), [&](size_t) { matches++; });
+        Report(std::string("column/") + FilterKernelName(kernel), rows, seconds, matches);
+    }
+    return 0;
+}
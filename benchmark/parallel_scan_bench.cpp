@@ -0,0 +1,138 @@
+// Morsel-driven scan scaling from 1 to N threads.
+//
+// Usage: parallel_scan_bench [rows] [max_threads]
+//
+// A three-column heap is built in a buffer pool large enough to hold it, so every run is
+// bound by decoding and filtering rather than I/O. For each thread count the benchmark
+// times, on a ThreadPool of that many threads (the caller included):
+//   filter   an unordered ParallelScan with "v < 500000", about half the rows matching
+//   ordered  the same scan with batches handed out in heap order
+//   update   ScanMorsels with the same filter, rewriting each matching row in place
+//   delete   ScanMorsels with the same filter, delete-marking the matches of a fresh heap
+// Thread counts double from 1 up to max_threads, which defaults to the number of cores.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/executor.h"
+#include "execution/thread_pool.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+using namespace simpledb;
+
+namespace {
+
+// Fill table with rows rows of (i, random 0..999999, "name<i % 1000>").
+void FillTable(TableInfo *table, size_t rows) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int32_t> dist(0, 999999);
+    std::vector<Tuple> batch;
+    std::vector<RID> rids;
+    for (size_t i = 0; i < rows; ++i) {
+        batch.emplace_back(std::vector<Value>{Value(static_cast<int32_t>(i)), Value(dist(rng)),
+                                              Value("name" + std::to_string(i % 1000))});
+        if (batch.size() == 4096 || i + 1 == rows) {
+            rids.resize(batch.size());
+            table->table_->InsertTuples(batch, rids.data());
+            batch.clear();
+        }
+    }
+}
+
+template <typename F>
+double BestSeconds(size_t reps, F run) {
+    double best = 1e30;
+    for (size_t r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+size_t Drain(Executor *executor) {
+    size_t rows = 0;
+    RowBatch batch;
+    while (executor->Next(&batch)) rows += batch.Size();
+    return rows;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    size_t rows = 2 * 1024 * 1024;
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1) rows = std::stoul(argv[1]);
+    if (argc > 2) max_threads = std::max<size_t>(1, std::stoul(argv[2]));
+    const size_t reps = 3;
+
+    const std::string db_file = "parallel_scan_bench.db";
+    std::remove(db_file.c_str());
+    {
+        DiskManager disk_manager(db_file);
+        // Room for the scanned table and one fresh copy per delete run.
+        size_t pages_per_table = rows / 100 + 64;
+        BufferPoolManager bpm(pages_per_table * 8, &disk_manager);
+        Catalog catalog(&bpm, nullptr);
+        std::vector<Column> columns{Column("id", TypeId::INTEGER), Column("v", TypeId::INTEGER),
+                                    Column("name", TypeId::VARCHAR)};
+        TableInfo *table = catalog.CreateTable("bench", Schema(columns));
+        FillTable(table, rows);
+
+        Predicate pred;
+        ParsePredicate(*table->schema_, "v < 500000", &pred);
+
+        std::cout << rows << " rows, filter v < 500000, best of " << reps << "\n";
+        std::cout << std::left << std::setw(10) << "threads" << std::setw(14) << "filter/s" << std::setw(14)
+                  << "ordered/s" << std::setw(14) << "update/s" << std::setw(14) << "delete/s"
+                  << "filter speedup\n";
+
+        double base = 0;
+        for (size_t threads = 1;; threads = std::min(threads * 2, max_threads)) {
+            ThreadPool pool(threads - 1);
+            size_t matches = 0;
+            double filter = BestSeconds(reps, [&] {
+                ParallelScanExecutor scan(&pool, table->table_.get(), &pred, table->schema_.get(), false);
+                matches = Drain(&scan);
+            });
+            double ordered = BestSeconds(reps, [&] {
+                ParallelScanExecutor scan(&pool, table->table_.get(), &pred, table->schema_.get(), true);
+                Drain(&scan);
+            });
+            double update = BestSeconds(reps, [&] {
+                ScanMorsels(catalog, table, &pred, &pool, [&](size_t, RowBatch *batch) {
+                    for (size_t i = 0; i < batch->Size(); ++i) table->table_->UpdateTuple(batch->tuples[i], &batch->rids[i]);
+                });
+            });
+
+            TableInfo *victim = catalog.CreateTable("bench_delete_" + std::to_string(threads), Schema(columns));
+            FillTable(victim, rows);
+            std::atomic<size_t> deleted{0};
+            double remove = BestSeconds(1, [&] {
+                ScanMorsels(catalog, victim, &pred, &pool, [&](size_t, RowBatch *batch) {
+                    deleted += victim->table_->DeleteTuples(batch->rids);
+                });
+            });
+            if (deleted != matches) std::cout << "delete removed " << deleted << " of " << matches << " rows\n";
+
+            if (threads == 1) base = filter;
+            std::cout << std::left << std::setw(10) << threads << std::setw(14) << static_cast<uint64_t>(rows / filter)
+                      << std::setw(14) << static_cast<uint64_t>(rows / ordered) << std::setw(14)
+                      << static_cast<uint64_t>(rows / update) << std::setw(14) << static_cast<uint64_t>(rows / remove)
+                      << std::fixed << std::setprecision(2) << base / filter << "x\n";
+            if (threads == max_threads) break;
+        }
+    }
+    std::remove(db_file.c_str());
+    return 0;
+}
@@ -0,0 +1,174 @@
+// Crash-recovery check: redo on worker threads must rebuild the same database as inline redo.
+//
+// Usage: recovery_check [db_file] [workers]
+//
+// Builds a database with a table a, indexed by a B+ tree on its INTEGER key, and an
+// unindexed table b: 339 rows into a (one full leaf) and a checkpoint, then ROUNDS rounds
+// of 6000 rows into b and 200 into a, one committed statement per row. Each round splits
+// a leaf of a's index while b's heap pages are logged around it, so redo on several
+// workers allocates index pages while some of b's logged pages are still to come. The
+// files are copied as they stand, as if the process had been killed, and each copy is
+// recovered: once inline and once on workers (default RECOVERY_THREADS). Both must hold
+// the same rows, and every row of a must be found through its index. Exits non-zero on
+// a mismatch.
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+using namespace simpledb;
+
+namespace {
+
+constexpr int32_t ROUNDS = 8;
+constexpr int32_t A_ROWS_PER_ROUND = 200;
+constexpr int32_t B_ROWS_PER_ROUND = 6000;
+constexpr size_t A_ROWS = 339 + ROUNDS * A_ROWS_PER_ROUND;
+constexpr size_t B_ROWS = ROUNDS * B_ROWS_PER_ROUND;
+
+const char *DB_SUFFIXES[] = {"", ".log", ".swap", ".swap.manifest"};
+
+void RemoveDatabase(const std::string &db_file) {
+    std::error_code ec;
+    for (const char *suffix : DB_SUFFIXES) std::filesystem::remove(db_file + suffix, ec);
+}
+
+void CopyDatabase(const std::string &from, const std::string &to) {
+    RemoveDatabase(to);
+    std::error_code ec;
+    for (const char *suffix : DB_SUFFIXES) {
+        if (std::filesystem::exists(from + suffix)) std::filesystem::copy_file(from + suffix, to + suffix, ec);
+    }
+}
+
+// Build the database and copy its files to each of copies before any shutdown work runs.
+void BuildCrashedDatabase(const std::string &db_file, const std::vector<std::string> &copies) {
+    RemoveDatabase(db_file);
+    std::ofstream(db_file, std::ios::binary | std::ios::trunc);
+    DiskManager disk_manager(db_file, true);
+    BufferPoolManager bpm(BUFFER_POOL_SIZE, &disk_manager);
+    Catalog catalog(&bpm);
+    CheckpointManager checkpoints(&catalog, &bpm, &disk_manager);
+    checkpoints.LoadSnapshot();
+    LogManager log_manager(db_file + ".log", DurabilityMode::OFF);
+    catalog.SetLogManager(&log_manager);
+    checkpoints.SetLogManager(&log_manager);
+    auto commit = [&] { log_manager.Commit(log_manager.AppendRecord(LogRecord::Commit())); };
+
+    Schema schema({Column("id", TypeId::INTEGER), Column("v", TypeId::INTEGER)});
+    TableInfo *a = catalog.CreateTable("a", schema);
+    commit();
+    catalog.CreateIndex("a_id", "a", 0);
+    commit();
+    TableInfo *b = catalog.CreateTable("b", schema);
+    commit();
+
+    auto insert = [&](TableInfo *table, int32_t id) {
+        Tuple tuple({Value(id), Value(id * 7)});
+        RID rid;
+        table->table_->InsertTuple(tuple, &rid);
+        for (IndexInfo *index : catalog.GetTableIndexes(table->name_)) {
+            index->index_->InsertEntry(tuple.GetValue(&schema, index->key_col_), rid);
+        }
+        commit();
+    };
+    for (int32_t i = 0; i < 339; ++i) insert(a, i);
+    checkpoints.Checkpoint();
+    for (int32_t round = 0; round < ROUNDS; ++round) {
+        for (int32_t i = 0; i < B_ROWS_PER_ROUND; ++i) insert(b, round * B_ROWS_PER_ROUND + i);
+        for (int32_t i = 0; i < A_ROWS_PER_ROUND; ++i) insert(a, 339 + round * A_ROWS_PER_ROUND + i);
+    }
+
+    log_manager.Flush();
+    for (const std::string &copy : copies) CopyDatabase(db_file, copy);
+}
+
+struct Recovered {
+    bool chains_sound = false;
+    std::vector<std::string> rows_a;
+    std::vector<std::string> rows_b;
+    size_t unindexed = 0;   // rows of a their index does not find
+};
+
+// False if the heap's page chain runs into a page twice, which a scan would never leave.
+bool ChainIsSound(TableHeap *heap) {
+    std::unordered_set<page_id_t> seen;
+    page_id_t page_id = heap->GetFirstPageId();
+    for (; page_id != INVALID_PAGE_ID; page_id = heap->GetNextPageId(page_id)) {
+        if (!seen.insert(page_id).second) return false;
+    }
+    return true;
+}
+
+std::vector<std::string> SortedRows(TableInfo *table) {
+    std::vector<std::string> rows;
+    const Schema *schema = table->schema_.get();
+    for (auto it = table->table_->Begin(); it != table->table_->End(); ++it) {
+        rows.push_back(it->GetValue(schema, 0).ToString() + "," + it->GetValue(schema, 1).ToString());
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+Recovered Recover(const std::string &db_file, size_t workers) {
+    DiskManager disk_manager(db_file, true);
+    BufferPoolManager bpm(BUFFER_POOL_SIZE, &disk_manager);
+    Catalog catalog(&bpm);
+    CheckpointManager checkpoints(&catalog, &bpm, &disk_manager);
+    lsn_t checkpoint_lsn = checkpoints.LoadSnapshot();
+    LogRecovery recovery(&catalog, &disk_manager, workers);
+    recovery.Recover(db_file + ".log", checkpoint_lsn);
+
+    Recovered result;
+    TableInfo *a = catalog.GetTable("a");
+    TableInfo *b = catalog.GetTable("b");
+    if (a == nullptr || b == nullptr) return result;
+    result.chains_sound = ChainIsSound(a->table_.get()) && ChainIsSound(b->table_.get());
+    if (!result.chains_sound) return result;
+    result.rows_a = SortedRows(a);
+    result.rows_b = SortedRows(b);
+    const std::vector<IndexInfo *> &indexes = catalog.GetTableIndexes("a");
+    for (auto it = a->table_->Begin(); it != a->table_->End(); ++it) {
+        std::vector<RID> rids;
+        if (!indexes.empty()) indexes[0]->index_->ScanKey(it->GetValue(a->schema_.get(), 0), &rids);
+        if (std::find(rids.begin(), rids.end(), it.GetRID()) == rids.end()) result.unindexed++;
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string db_file = argc > 1 ? argv[1] : "recovery_check.db";
+    size_t workers = argc > 2 ? std::stoul(argv[2]) : RECOVERY_THREADS;
+
+    std::string inline_copy = db_file + ".inline";
+    std::string parallel_copy = db_file + ".parallel";
+    BuildCrashedDatabase(db_file, {inline_copy, parallel_copy});
+    Recovered expected = Recover(inline_copy, 0);
+    Recovered actual = Recover(parallel_copy, workers);
+
+    if (!expected.chains_sound || !actual.chains_sound) std::cout << "a heap page chain loops\n";
+    std::cout << "inline:   " << expected.rows_a.size() << " rows in a, " << expected.rows_b.size()
+              << " rows in b, " << expected.unindexed << " rows of a missing from its index\n";
+    std::cout << workers << " workers: " << actual.rows_a.size() << " rows in a, " << actual.rows_b.size()
+              << " rows in b, " << actual.unindexed << " rows of a missing from its index\n";
+    bool ok = expected.chains_sound && actual.chains_sound && expected.rows_a.size() == A_ROWS &&
+              expected.rows_b.size() == B_ROWS && expected.unindexed == 0 && actual.rows_a == expected.rows_a &&
+              actual.rows_b == expected.rows_b && actual.unindexed == 0;
+    std::cout << (ok ? "OK" : "MISMATCH") << std::endl;
+
+    for (const std::string &file : {db_file, inline_copy, parallel_copy}) RemoveDatabase(file);
+    return ok ? 0 : 1;
+}
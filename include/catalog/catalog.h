@@ -3,32 +3,97 @@
 #include <unordered_map>
 #include <memory>
 #include <vector>
+#include <algorithm>
 #include "catalog/schema.h"
+#include "catalog/table_stats.h"
 #include "catalog/tuple.h"
+#include "storage/column_store.h"
+#include "storage/table_heap.h"
+#include "index/b_plus_tree.h"
+#include "index/extendible_hash_index.h"
 
 namespace simpledb {
 
 struct TableInfo {
     std::string name_;
+    table_oid_t oid_;
     std::unique_ptr<Schema> schema_;
-    std::vector<Tuple> tuples_; // In-memory storage for simplicity in this demo
+    std::unique_ptr<TableHeap> table_;
+    std::unique_ptr<ColumnStore> column_store_;   // optional column-major copy used by scans
+    std::unique_ptr<TableStats> stats_;           // set by analyze; lasts for the session
 
-    TableInfo(std::string name, std::unique_ptr<Schema> schema)
-        : name_(std::move(name)), schema_(std::move(schema)) {}
+    // A new table with an empty heap
+    TableInfo(std::string name, table_oid_t oid, std::unique_ptr<Schema> schema, BufferPoolManager *bpm,
+              LogManager *log_manager)
+        : name_(std::move(name)), oid_(oid), schema_(std::move(schema)),
+          table_(std::make_unique<TableHeap>(bpm, schema_.get(), oid_, log_manager)) {}
+
+    // A table whose heap already exists on disk, or is being rebuilt by recovery
+    TableInfo(std::string name, table_oid_t oid, std::unique_ptr<Schema> schema, BufferPoolManager *bpm,
+              page_id_t first_page_id)
+        : name_(std::move(name)), oid_(oid), schema_(std::move(schema)),
+          table_(std::make_unique<TableHeap>(bpm, schema_.get(), oid_, first_page_id)) {}
+};
+
+struct IndexInfo {
+    std::string name_;
+    std::string table_name_;
+    uint32_t key_col_;
+    IndexType type_;
+    std::unique_ptr<Index> index_;
+
+    // Builds a new, empty index, or reopens one rooted at root_page_id.
+    IndexInfo(std::string name, std::string table_name, uint32_t key_col, IndexType type, BufferPoolManager *bpm,
+              page_id_t root_page_id = INVALID_PAGE_ID)
+        : name_(std::move(name)), table_name_(std::move(table_name)), key_col_(key_col), type_(type) {
+        if (type_ == IndexType::HASH) {
+            index_ = std::make_unique<ExtendibleHashIndex>(bpm, root_page_id);
+        } else {
+            index_ = std::make_unique<BPlusTree>(bpm, root_page_id);
+        }
+    }
 };
 
 class Catalog {
 public:
-    Catalog() = default;
+    explicit Catalog(BufferPoolManager *bpm, LogManager *log_manager = nullptr)
+        : bpm_(bpm), log_manager_(log_manager) {}
+
+    // Start (or stop) logging catalog and table changes, e.g. once recovery has finished.
+    void SetLogManager(LogManager *log_manager) {
+        log_manager_ = log_manager;
+        for (auto &pair : tables_) pair.second->table_->SetLogManager(log_manager);
+    }
 
     TableInfo *CreateTable(const std::string &table_name, const Schema &schema) {
         if (tables_.find(table_name) != tables_.end()) {
             return nullptr;
         }
-        auto table_info = std::make_unique<TableInfo>(table_name, std::make_unique<Schema>(schema));
-        TableInfo *ptr = table_info.get();
-        tables_[table_name] = std::move(table_info);
-        return ptr;
+        table_oid_t oid = next_table_oid_++;
+        if (log_manager_ != nullptr) {
+            log_manager_->AppendRecord(LogRecord::CreateTable(oid, table_name, schema));
+        }
+        auto table_info = std::make_unique<TableInfo>(table_name, oid, std::make_unique<Schema>(schema), bpm_,
+                                                      log_manager_);
+        return AddTable(std::move(table_info));
+    }
+
+    // Register a table whose heap starts at first_page_id (invalid while recovery rebuilds it).
+    TableInfo *AttachTable(const std::string &table_name, table_oid_t oid, const Schema &schema,
+                           page_id_t first_page_id) {
+        if (tables_.find(table_name) != tables_.end() || table_oids_.find(oid) != table_oids_.end()) {
+            return nullptr;
+        }
+        next_table_oid_ = std::max(next_table_oid_, oid + 1);
+        auto table_info = std::make_unique<TableInfo>(table_name, oid, std::make_unique<Schema>(schema), bpm_,
+                                                      first_page_id);
+        table_info->table_->SetLogManager(log_manager_);
+        return AddTable(std::move(table_info));
+    }
+
+    TableInfo *GetTable(table_oid_t oid) {
+        auto it = table_oids_.find(oid);
+        return it == table_oids_.end() ? nullptr : it->second;
     }
 
     TableInfo *GetTable(const std::string &table_name) {
@@ -38,6 +103,50 @@ public:
         return tables_[table_name].get();
     }
 
+    // Create an index over key_col and populate it from the table's existing rows.
+    // INTEGER columns get a B+Tree; VARCHAR columns get an extendible hash index.
+    IndexInfo *CreateIndex(const std::string &index_name, const std::string &table_name, uint32_t key_col) {
+        TableInfo *table = GetTable(table_name);
+        if (table == nullptr || indexes_.find(index_name) != indexes_.end()) {
+            return nullptr;
+        }
+        IndexType type = table->schema_->GetColumn(key_col).GetType() == TypeId::VARCHAR ? IndexType::HASH
+                                                                                        : IndexType::BPLUS_TREE;
+        auto index_info = std::make_unique<IndexInfo>(index_name, table_name, key_col, type, bpm_);
+        TableHeap *heap = table->table_.get();
+        for (auto it = heap->Begin(); it != heap->End(); ++it) {
+            index_info->index_->InsertEntry(it->GetValue(table->schema_.get(), key_col), it.GetRID());
+        }
+        IndexInfo *ptr = index_info.get();
+        indexes_[index_name] = std::move(index_info);
+        table_indexes_[table_name].push_back(ptr);
+        if (log_manager_ != nullptr) {
+            log_manager_->AppendRecord(LogRecord::CreateIndex(table->oid_, index_name, key_col));
+        }
+        return ptr;
+    }
+
+    // Register an index saved by a checkpoint; its pages already hold the table's entries.
+    IndexInfo *AttachIndex(const std::string &index_name, const std::string &table_name, uint32_t key_col,
+                           page_id_t root_page_id) {
+        TableInfo *table = GetTable(table_name);
+        if (table == nullptr || indexes_.find(index_name) != indexes_.end() ||
+            key_col >= table->schema_->GetColumnCount()) {
+            return nullptr;
+        }
+        IndexType type = table->schema_->GetColumn(key_col).GetType() == TypeId::VARCHAR ? IndexType::HASH
+                                                                                        : IndexType::BPLUS_TREE;
+        auto index_info = std::make_unique<IndexInfo>(index_name, table_name, key_col, type, bpm_, root_page_id);
+        IndexInfo *ptr = index_info.get();
+        indexes_[index_name] = std::move(index_info);
+        table_indexes_[table_name].push_back(ptr);
+        return ptr;
+    }
+
+    const std::vector<IndexInfo *> &GetTableIndexes(const std::string &table_name) {
+        return table_indexes_[table_name];
+    }
+
     std::vector<std::string> GetTableNames() const {
         std::vector<std::string> names;
         for (const auto& pair : tables_) {
@@ -47,7 +156,20 @@ public:
     }
 
 private:
+    TableInfo *AddTable(std::unique_ptr<TableInfo> table_info) {
+        TableInfo *ptr = table_info.get();
+        table_oids_[ptr->oid_] = ptr;
+        tables_[ptr->name_] = std::move(table_info);
+        return ptr;
+    }
+
+    BufferPoolManager *bpm_;
+    LogManager *log_manager_;
+    table_oid_t next_table_oid_ = 0;
     std::unordered_map<std::string, std::unique_ptr<TableInfo>> tables_;
+    std::unordered_map<table_oid_t, TableInfo *> table_oids_;
+    std::unordered_map<std::string, std::unique_ptr<IndexInfo>> indexes_;
+    std::unordered_map<std::string, std::vector<IndexInfo *>> table_indexes_;
 };
 
 } // namespace simpledb
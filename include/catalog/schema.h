@@ -1,4 +1,5 @@
 #pragma once
+#include <string>
 #include <vector>
 #include "catalog/column.h"
 
@@ -12,11 +13,23 @@ public:
     const Column &GetColumn(uint32_t col_idx) const { return columns_[col_idx]; }
     uint32_t GetColumnCount() const { return static_cast<uint32_t>(columns_.size()); }
 
+    // Index of the column named col_name, or -1. In a joined schema, whose columns are
+    // qualified as "table.col", a bare "col" finds the one column it qualifies; a name two
+    // tables share is ambiguous and not found.
     int32_t GetColIdx(const std::string &col_name) const {
         for (uint32_t i = 0; i < columns_.size(); ++i) {
             if (columns_[i].GetName() == col_name) return i;
         }
-        return -1;
+        int32_t found = -1;
+        for (uint32_t i = 0; i < columns_.size(); ++i) {
+            const std::string name = columns_[i].GetName();
+            if (name.size() > col_name.size() && name[name.size() - col_name.size() - 1] == '.' &&
+                name.compare(name.size() - col_name.size(), col_name.size(), col_name) == 0) {
+                if (found != -1) return -1;
+                found = static_cast<int32_t>(i);
+            }
+        }
+        return found;
     }
 
 private:
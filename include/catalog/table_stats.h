@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "catalog/schema.h"
+#include "catalog/tuple.h"
+#include "catalog/value.h"
+#include "common/config.h"
+#include "storage/column_filter.h"
+#include "storage/table_heap.h"
+
+namespace simpledb {
+
+// Estimates how many distinct values were added to it from their 64-bit hashes, in
+// 2^STATS_HLL_PRECISION one-byte registers (HyperLogLog, with the small-range correction).
+class HyperLogLog {
+public:
+    HyperLogLog() : registers_(size_t{1} << STATS_HLL_PRECISION, 0) {}
+
+    void Add(uint64_t hash);
+    double Estimate() const;
+
+private:
+    std::vector<uint8_t> registers_;
+};
+
+// What analyze knows about one column. The histogram is equi-depth: each bucket holds
+// about the same share of the rows, bucket i the values in (bounds[i - 1], bounds[i]].
+struct ColumnStats {
+    HyperLogLog sketch;
+    Value min;                  // INVALID while the table has no rows
+    Value max;
+    std::vector<Value> bounds;  // ascending upper bound of each bucket
+};
+
+// Row count and per-column statistics of a table, gathered by analyze and kept roughly
+// current afterwards: row changes adjust the row count, widen min / max and feed new values
+// to the distinct counts, while the histograms describe the rows as of the last analyze.
+class TableStats {
+public:
+    explicit TableStats(uint32_t column_count) : columns_(column_count) {}
+
+    // Read every row of heap. Histograms come from a uniform sample of the rows.
+    static std::unique_ptr<TableStats> Analyze(TableHeap *heap, const Schema *schema);
+
+    void RecordInsert(const Tuple &tuple);
+    void RecordDelete(size_t rows);
+    void RecordUpdate(uint32_t col, const Value &value);
+
+    uint64_t GetRowCount() const { return row_count_; }
+    // Heap pages the rows take, at the row density seen by analyze.
+    uint64_t GetPageCount() const;
+    const ColumnStats &GetColumn(uint32_t col) const { return columns_[col]; }
+    uint64_t GetDistinctCount(uint32_t col) const;
+
+    // Estimated fraction of the rows whose value in col compares to literal as op, where
+    // literal has the column's type.
+    double EstimateSelectivity(uint32_t col, CompareOp op, const Value &literal) const;
+
+private:
+    double EqualFraction(uint32_t col, const Value &literal) const;
+    double LessFraction(uint32_t col, const Value &literal) const;
+
+    uint64_t row_count_ = 0;
+    uint64_t analyzed_rows_ = 0;
+    uint64_t analyzed_pages_ = 0;
+    std::vector<ColumnStats> columns_;
+};
+
+} // namespace simpledb
@@ -1,5 +1,7 @@
 #pragma once
 #include <vector>
+#include <cstring>
+#include <utility>
 #include "catalog/value.h"
 #include "catalog/schema.h"
 
@@ -10,15 +12,72 @@ public:
     Tuple() = default;
     explicit Tuple(std::vector<Value> values) : values_(std::move(values)) {}
 
-    Value GetValue(const Schema *schema, uint32_t column_idx) const {
+    const Value &GetValue(const Schema *schema, uint32_t column_idx) const {
         return values_[column_idx];
     }
 
     const std::vector<Value> &GetValues() const { return values_; }
 
-    void SetValue(uint32_t column_idx, const Value &value) {
+    // Hand the values over to the caller, leaving the tuple empty.
+    std::vector<Value> ReleaseValues() { return std::move(values_); }
+
+    // Approximate bytes the decoded tuple occupies in memory.
+    size_t GetFootprint() const {
+        size_t bytes = sizeof(Tuple);
+        for (const Value &value : values_) bytes += sizeof(Value) + value.GetHeapSize();
+        return bytes;
+    }
+
+    void SetValue(uint32_t column_idx, Value value) {
         if (column_idx < values_.size()) {
-            values_[column_idx] = value;
+            values_[column_idx] = std::move(value);
+        }
+    }
+
+    // On-page layout: INTEGER as 4 raw bytes, VARCHAR as a 4 byte length followed by its bytes.
+    uint32_t GetSerializedSize(const Schema &schema) const {
+        uint32_t size = 0;
+        for (uint32_t i = 0; i < schema.GetColumnCount(); ++i) {
+            if (schema.GetColumn(i).GetType() == TypeId::INTEGER) {
+                size += sizeof(int32_t);
+            } else {
+                size += sizeof(uint32_t) + static_cast<uint32_t>(values_[i].GetAsString().size());
+            }
+        }
+        return size;
+    }
+
+    void SerializeTo(const Schema &schema, char *dest) const {
+        for (uint32_t i = 0; i < schema.GetColumnCount(); ++i) {
+            if (schema.GetColumn(i).GetType() == TypeId::INTEGER) {
+                int32_t v = values_[i].GetAsInt();
+                memcpy(dest, &v, sizeof(int32_t));
+                dest += sizeof(int32_t);
+            } else {
+                std::string_view s = values_[i].GetAsString();
+                uint32_t len = static_cast<uint32_t>(s.size());
+                memcpy(dest, &len, sizeof(uint32_t));
+                memcpy(dest + sizeof(uint32_t), s.data(), len);
+                dest += sizeof(uint32_t) + len;
+            }
+        }
+    }
+
+    void DeserializeFrom(const Schema &schema, const char *src) {
+        values_.clear();
+        values_.reserve(schema.GetColumnCount());
+        for (uint32_t i = 0; i < schema.GetColumnCount(); ++i) {
+            if (schema.GetColumn(i).GetType() == TypeId::INTEGER) {
+                int32_t v;
+                memcpy(&v, src, sizeof(int32_t));
+                values_.emplace_back(v);
+                src += sizeof(int32_t);
+            } else {
+                uint32_t len;
+                memcpy(&len, src, sizeof(uint32_t));
+                values_.emplace_back(std::string_view(src + sizeof(uint32_t), len));
+                src += sizeof(uint32_t) + len;
+            }
         }
     }
 
@@ -1,7 +1,8 @@
 #pragma once
+#include <cstdint>
 
 namespace simpledb {
 
-enum class TypeId { INVALID = 0, INTEGER, VARCHAR };
+enum class TypeId : uint8_t { INVALID = 0, INTEGER, VARCHAR };
 
 } // namespace simpledb
@@ -1,30 +1,98 @@
 #pragma once
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include "catalog/type_id.h"
 
 namespace simpledb {
 
+// A NULL, INTEGER or VARCHAR in 24 bytes. A string of up to INLINE_CAPACITY bytes is kept
+// inside the value; a longer one gets a heap buffer of its own. GetAsString returns a view
+// that stays valid as long as the value is neither changed nor destroyed.
 class Value {
 public:
-    Value() : type_id_(TypeId::INVALID) {}
-    explicit Value(int32_t val) : type_id_(TypeId::INTEGER), int_val_(val) {}
-    explicit Value(const std::string &val) : type_id_(TypeId::VARCHAR), varchar_val_(val) {}
+    static constexpr uint32_t INLINE_CAPACITY = 16;
+
+    Value() : type_id_(TypeId::INVALID) { int_val_ = 0; }
+    explicit Value(int32_t val) : type_id_(TypeId::INTEGER) { int_val_ = val; }
+    explicit Value(std::string_view val) : type_id_(TypeId::VARCHAR), size_(static_cast<uint32_t>(val.size())) {
+        char *dest = IsOnHeap() ? (heap_ = new char[size_]) : inline_;
+        if (size_ > 0) memcpy(dest, val.data(), size_);
+    }
+
+    Value(const Value &other) : type_id_(other.type_id_), size_(other.size_) {
+        if (IsOnHeap()) {
+            heap_ = new char[size_];
+            memcpy(heap_, other.heap_, size_);
+        } else {
+            memcpy(inline_, other.inline_, INLINE_CAPACITY);
+        }
+    }
+
+    // The moved-from value keeps its type; a string is left empty.
+    Value(Value &&other) noexcept : type_id_(other.type_id_), size_(other.size_) {
+        memcpy(inline_, other.inline_, INLINE_CAPACITY);
+        other.size_ = 0;
+    }
+
+    Value &operator=(const Value &other) {
+        if (this != &other) *this = Value(other);
+        return *this;
+    }
+
+    Value &operator=(Value &&other) noexcept {
+        if (this != &other) {
+            Release();
+            type_id_ = other.type_id_;
+            size_ = other.size_;
+            memcpy(inline_, other.inline_, INLINE_CAPACITY);
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~Value() { Release(); }
 
     TypeId GetTypeId() const { return type_id_; }
-    int32_t GetAsInt() const { return int_val_; }
-    std::string GetAsString() const { return varchar_val_; }
+    int32_t GetAsInt() const { return type_id_ == TypeId::INTEGER ? int_val_ : 0; }
+    std::string_view GetAsString() const { return std::string_view(IsOnHeap() ? heap_ : inline_, size_); }
+
+    // Bytes of heap memory the value owns besides itself.
+    size_t GetHeapSize() const { return IsOnHeap() ? size_ : 0; }
+
+    bool operator==(const Value &other) const {
+        if (type_id_ != other.type_id_) return false;
+        if (type_id_ == TypeId::INTEGER) return int_val_ == other.int_val_;
+        return GetAsString() == other.GetAsString();
+    }
+    bool operator!=(const Value &other) const { return !(*this == other); }
 
     // For simplicity, serialize to a string representation
     std::string ToString() const {
         if (type_id_ == TypeId::INTEGER) return std::to_string(int_val_);
-        if (type_id_ == TypeId::VARCHAR) return varchar_val_;
+        if (type_id_ == TypeId::VARCHAR) return std::string(GetAsString());
         return "NULL";
     }
 
 private:
+    // Only strings have a size, so INTEGER and NULL values are never on the heap.
+    bool IsOnHeap() const { return size_ > INLINE_CAPACITY; }
+
+    void Release() {
+        if (IsOnHeap()) delete[] heap_;
+        size_ = 0;
+    }
+
     TypeId type_id_;
-    int32_t int_val_ = 0;
-    std::string varchar_val_;
+    uint32_t size_ = 0;                    // VARCHAR length
+    union {
+        int32_t int_val_;
+        char inline_[INLINE_CAPACITY];
+        char *heap_;
+    };
 };
 
+static_assert(sizeof(Value) == 24, "Value should stay compact");
+
 } // namespace simpledb
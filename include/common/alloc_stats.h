@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+
+namespace simpledb {
+
+// Heap allocations made by the whole process while counting was on, counted per thread by
+// the replacement operator new and delete in alloc_stats.cpp. Allocations that bypass
+// operator new (malloc, and over-aligned new) are not seen. The counters are updated
+// without ordering, so a reading taken while other threads allocate may lag them slightly.
+struct AllocStats {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t frees = 0;
+
+    AllocStats operator-(const AllocStats &since) const {
+        return {allocations - since.allocations, bytes - since.bytes, frees - since.frees};
+    }
+};
+
+// Counting is off by default; while off, operator new and delete only test a flag.
+void SetAllocCounting(bool on);
+
+AllocStats GetAllocStats();
+
+} // namespace simpledb
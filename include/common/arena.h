@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include "common/config.h"
+
+namespace simpledb {
+
+// A bump allocator for memory that is all dropped at once, such as the scratch buffers of
+// one statement. Allocations are carved out of chunks of at least chunk_size bytes and are
+// never freed one by one; Reset gives them all back. Reset keeps the memory for reuse,
+// merged into a single chunk of up to ARENA_RETAINED_BYTES, so a statement that repeats
+// stops allocating once the arena has grown to fit it. Not thread-safe.
+class Arena {
+public:
+    explicit Arena(size_t chunk_size = ARENA_CHUNK_BYTES) : chunk_size_(chunk_size) {}
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // Uninitialized memory for size bytes, aligned to align (a power of two).
+    void *Allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    template <typename T>
+    T *AllocateArray(size_t count) {
+        return static_cast<T *>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Invalidate everything allocated so far.
+    void Reset();
+
+    size_t GetBytesUsed() const { return used_; }           // handed out since the last Reset
+    size_t GetBytesReserved() const { return reserved_; }   // held in chunks
+
+private:
+    void AddChunk(size_t min_size);
+
+    size_t chunk_size_;
+    std::vector<std::pair<std::unique_ptr<char[]>, size_t>> chunks_;
+    char *pos_ = nullptr;   // free space left in the newest chunk
+    char *end_ = nullptr;
+    size_t used_ = 0;
+    size_t reserved_ = 0;
+};
+
+// Lets standard containers allocate from an arena, where what they free is only reclaimed
+// by the arena's Reset. Without an arena it is a plain heap allocator.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(Arena *arena = nullptr) noexcept : arena_(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena_(other.GetArena()) {}
+
+    T *allocate(size_t n) {
+        if (arena_ != nullptr) return arena_->AllocateArray<T>(n);
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T *ptr, size_t) noexcept {
+        if (arena_ == nullptr) ::operator delete(ptr);
+    }
+
+    Arena *GetArena() const { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return arena_ == other.GetArena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return arena_ != other.GetArena(); }
+
+private:
+    Arena *arena_;
+};
+
+template <typename T>
+using ScratchVector = std::vector<T, ArenaAllocator<T>>;
+using ScratchString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+} // namespace simpledb
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
 
 namespace simpledb {
 
@@ -9,10 +10,113 @@ constexpr uint32_t PAGE_SIZE = 4096;
 // Define INVALID_PAGE_ID
 constexpr int32_t INVALID_PAGE_ID = -1;
 
+// Number of frames in the buffer pool, and how many latch-independent shards they are split into
+constexpr size_t BUFFER_POOL_SIZE = 256;
+constexpr size_t BUFFER_POOL_SHARDS = 8;
+
+// Replacement policy used by the buffer pool, and the history depth of LRU-K
+enum class ReplacerType { LRU_K = 0, CLOCK };
+constexpr ReplacerType DEFAULT_REPLACER = ReplacerType::LRU_K;
+constexpr size_t LRUK_REPLACER_K = 2;
+
+// Worker threads serving asynchronous page reads and writes (0 runs them inline)
+constexpr size_t DISK_IO_THREADS = 4;
+
+// How commits reach the write-ahead log: OFF leaves flushing to the OS, GROUP fsyncs
+// every LOG_GROUP_COMMIT_MS or LOG_GROUP_COMMIT_BYTES in the background, and SYNC
+// makes each commit wait for an fsync (shared with any concurrent committers).
+enum class DurabilityMode { OFF = 0, GROUP, SYNC };
+constexpr DurabilityMode DEFAULT_DURABILITY = DurabilityMode::GROUP;
+constexpr size_t LOG_GROUP_COMMIT_MS = 10;
+constexpr size_t LOG_GROUP_COMMIT_BYTES = 64 * 1024;
+
+// A background checkpoint is taken once the log grows past CHECKPOINT_LOG_BYTES; the
+// log size is checked every CHECKPOINT_POLL_MS
+constexpr size_t CHECKPOINT_LOG_BYTES = 16 * 1024 * 1024;
+constexpr size_t CHECKPOINT_POLL_MS = 100;
+
+// Worker threads applying log records during recovery; each table is replayed by one worker
+constexpr size_t RECOVERY_THREADS = 4;
+
+// The background vacuum compacts at most VACUUM_PAGES_PER_STEP table pages per step,
+// checking for work every VACUUM_POLL_MS
+constexpr size_t VACUUM_PAGES_PER_STEP = 32;
+constexpr size_t VACUUM_POLL_MS = 200;
+
+// Bulk loads read CSV files in chunks of LOAD_CHUNK_BYTES, parsed into pages by
+// LOAD_THREADS workers; each chunk is committed as its own statement
+constexpr size_t LOAD_CHUNK_BYTES = 4 * 1024 * 1024;
+constexpr size_t LOAD_THREADS = 4;
+
+// Column stores keep a VARCHAR column as codes into a dictionary of its distinct values
+// while it has no more than COLUMN_DICTIONARY_MAX_ENTRIES of them
+constexpr size_t COLUMN_DICTIONARY_MAX_ENTRIES = 64 * 1024;
+
+// Parsed statements kept per connection, keyed on statement text with literals lifted out
+constexpr size_t PLAN_CACHE_SIZE = 128;
+
+// Rows handed between query operators per call
+constexpr size_t EXECUTION_BATCH_SIZE = 1024;
+
+// Threads running a query's scans, filters and row changes, the calling thread included
+// (0 means one per core); see "set threads". Heap scans are split into morsels of
+// SCAN_MORSEL_PAGES pages that the threads claim one at a time.
+constexpr size_t EXECUTION_THREADS = 0;
+constexpr size_t SCAN_MORSEL_PAGES = 16;
+
+// Sorts hold up to SORT_MEMORY_BYTES of rows; past that, sorted runs are written to a
+// temporary file through a buffer pool of SORT_SPILL_POOL_PAGES pages and merged at most
+// SORT_MERGE_FAN_IN at a time, each run read SORT_READ_AHEAD_PAGES pages ahead of the merge.
+constexpr size_t SORT_MEMORY_BYTES = 64 * 1024 * 1024;
+constexpr size_t SORT_SPILL_POOL_PAGES = 256;
+constexpr size_t SORT_MERGE_FAN_IN = 64;
+constexpr size_t SORT_READ_AHEAD_PAGES = 8;
+
+// Query results are formatted into a buffer written out once it holds OUTPUT_BUFFER_BYTES
+constexpr size_t OUTPUT_BUFFER_BYTES = 1024 * 1024;
+
+// Scratch arenas grow in chunks of at least ARENA_CHUNK_BYTES. Between statements the
+// session's arena keeps up to ARENA_RETAINED_BYTES, so the next statement can reuse them.
+constexpr size_t ARENA_CHUNK_BYTES = 64 * 1024;
+constexpr size_t ARENA_RETAINED_BYTES = 4 * 1024 * 1024;
+
+// Allocation counters are kept per thread in ALLOC_STATS_SLOTS slots; threads beyond that
+// share the last one.
+constexpr size_t ALLOC_STATS_SLOTS = 256;
+
+// analyze counts each column's distinct values with a HyperLogLog sketch of
+// 2^STATS_HLL_PRECISION registers, and builds equi-depth histograms of up to
+// STATS_HISTOGRAM_BUCKETS buckets from a sample of up to STATS_SAMPLE_ROWS rows.
+constexpr uint32_t STATS_HLL_PRECISION = 12;
+constexpr size_t STATS_HISTOGRAM_BUCKETS = 100;
+constexpr size_t STATS_SAMPLE_ROWS = 30000;
+
+// Access path costs, in units of one heap page read in sequence: a page fetched for an
+// index entry, and decoding and testing one row from the heap or from a column store.
+// Random fetches are priced for pages in the OS cache, where one measured about six
+// times the cost of a row read in sequence; raise it for tables that live on cold disk.
+constexpr double COST_RANDOM_PAGE = 0.12;
+constexpr double COST_HEAP_ROW = 0.01;
+constexpr double COST_COLUMN_ROW = 0.0025;
+
+// Hash joins keep their build side in memory up to JOIN_MEMORY_BYTES; past that, both sides
+// are split into JOIN_PARTITIONS partitions in a temporary file cached by a buffer pool of
+// JOIN_SPILL_POOL_PAGES pages.
+constexpr size_t JOIN_MEMORY_BYTES = 64 * 1024 * 1024;
+constexpr size_t JOIN_PARTITIONS = 32;
+constexpr size_t JOIN_SPILL_POOL_PAGES = 256;
+
 // Define type for Page ID
 using page_id_t = int32_t;
 
 // Define type for Frame ID (used in buffer pool)
 using frame_id_t = int32_t;
 
+// Log sequence number of a write-ahead log record; real LSNs start at 1
+using lsn_t = int64_t;
+constexpr lsn_t INVALID_LSN = -1;
+
+// Identifier of a table, stable across restarts and used by log records
+using table_oid_t = uint32_t;
+
 } // namespace simpledb
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include "common/config.h"
+
+namespace simpledb {
+
+// Record identifier: the page a tuple lives on and its slot within that page.
+class RID {
+public:
+    RID() = default;
+    RID(page_id_t page_id, uint32_t slot_num) : page_id_(page_id), slot_num_(slot_num) {}
+
+    inline page_id_t GetPageId() const { return page_id_; }
+    inline uint32_t GetSlotNum() const { return slot_num_; }
+    inline void Set(page_id_t page_id, uint32_t slot_num) {
+        page_id_ = page_id;
+        slot_num_ = slot_num;
+    }
+
+    bool operator==(const RID &other) const {
+        return page_id_ == other.page_id_ && slot_num_ == other.slot_num_;
+    }
+    bool operator!=(const RID &other) const { return !(*this == other); }
+    bool operator<(const RID &other) const {
+        return page_id_ < other.page_id_ || (page_id_ == other.page_id_ && slot_num_ < other.slot_num_);
+    }
+
+private:
+    page_id_t page_id_ = INVALID_PAGE_ID;
+    uint32_t slot_num_ = 0;
+};
+
+} // namespace simpledb
+
+namespace std {
+template <>
+struct hash<simpledb::RID> {
+    size_t operator()(const simpledb::RID &rid) const {
+        return hash<int64_t>()((static_cast<int64_t>(rid.GetPageId()) << 32) | rid.GetSlotNum());
+    }
+};
+} // namespace std
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace simpledb {
+
+// Helpers for the little binary formats of the log and checkpoint metadata.
+
+template <typename T>
+inline void PutValue(std::string *out, T value) {
+    out->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+inline void PutString(std::string *out, std::string_view s) {
+    PutValue<uint32_t>(out, static_cast<uint32_t>(s.size()));
+    out->append(s);
+}
+
+// Bounds-checked cursor over a serialized buffer.
+struct ByteReader {
+    const char *pos;
+    const char *end;
+
+    template <typename T>
+    bool Get(T *value) {
+        if (static_cast<size_t>(end - pos) < sizeof(T)) return false;
+        memcpy(value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool GetString(std::string *s) {
+        uint32_t len;
+        if (!Get(&len) || static_cast<size_t>(end - pos) < len) return false;
+        s->assign(pos, len);
+        pos += len;
+        return true;
+    }
+};
+
+} // namespace simpledb
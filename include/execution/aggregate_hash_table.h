@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "catalog/tuple.h"
+#include "catalog/value.h"
+
+namespace simpledb {
+
+enum class AggregateType { COUNT, SUM, MIN, MAX, AVG };
+
+// One aggregate of a select list; col is -1 for count(*).
+struct AggregateExpr {
+    AggregateType type = AggregateType::COUNT;
+    int32_t col = -1;
+};
+
+// Groups rows by their group by values and folds each row into its group's aggregates.
+// The table is open addressing with linear probing over a flat array of 8 byte slots (a
+// hash tag and a group number), so most probes touch a single cache line; group keys and
+// running totals live in arrays indexed by group number and never move when the slot
+// array grows. Not thread-safe: each thread builds its own table and the partial tables
+// are combined with Merge.
+class AggregateHashTable {
+public:
+    AggregateHashTable(std::vector<int32_t> group_by, std::vector<AggregateExpr> aggregates);
+
+    // Fold tuple into the group its group by columns select, creating the group if new.
+    void Update(const Tuple &tuple);
+
+    // Fold every group of other into this table.
+    void Merge(const AggregateHashTable &other);
+
+    // Create the group with no key if it does not exist, so an aggregate over no rows
+    // still yields its one row.
+    void EnsureEmptyKeyGroup();
+
+    size_t GetGroupCount() const { return group_hashes_.size(); }
+
+    // Group numbers ordered by their keys.
+    std::vector<size_t> SortedGroups() const;
+
+    // A group's result row: its group by values followed by its aggregates. SUM and COUNT
+    // results outside the INT range, and every AVG, come back as text; MIN, MAX, SUM and
+    // AVG over no rows are NULL.
+    Tuple GetRow(size_t group) const;
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    struct Slot {
+        uint32_t tag = 0;                   // high half of the group's hash
+        uint32_t group = EMPTY;
+    };
+    struct Accumulator {
+        int64_t count = 0;
+        int64_t sum = 0;
+        Value extreme;                      // MIN / MAX so far
+    };
+    // Number of the group whose k-th key value is key_at(k) and whose keys hash to hash,
+    // created if absent.
+    template <typename KeyAt>
+    size_t FindOrInsert(uint64_t hash, KeyAt key_at);
+
+    void Grow();
+
+    std::vector<int32_t> group_by_;
+    std::vector<AggregateExpr> aggregates_;
+    std::vector<Slot> slots_;               // power of two in size, at most 1/2 full
+    std::vector<uint64_t> group_hashes_;
+    std::vector<Value> keys_;               // group_by_.size() values per group
+    std::vector<Accumulator> accumulators_; // aggregates_.size() per group
+};
+
+} // namespace simpledb
@@ -0,0 +1,267 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "catalog/catalog.h"
+#include "catalog/tuple.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "execution/aggregate_hash_table.h"
+#include "execution/predicate.h"
+#include "execution/result_writer.h"
+#include "execution/thread_pool.h"
+
+namespace simpledb {
+
+// Rows handed from one operator to the next. rids[i] locates tuples[i] in the table heap;
+// operators that reshape rows (Projection) keep the rid of the row they came from.
+struct RowBatch {
+    std::vector<RID> rids;
+    std::vector<Tuple> tuples;
+
+    size_t Size() const { return tuples.size(); }
+    void Clear() {
+        rids.clear();
+        tuples.clear();
+    }
+};
+
+// A pull-based query operator. Each call to Next replaces the contents of batch with the
+// next rows, about EXECUTION_BATCH_SIZE at a time, and returns false once the input is
+// exhausted; a batch returned with true is never empty. Operators are built into a tree
+// whose root is pulled until it runs dry.
+class Executor {
+public:
+    virtual ~Executor() = default;
+    virtual bool Next(RowBatch *batch) = 0;
+
+    // True if several threads may call Next at once, each getting a disjoint share of the rows.
+    virtual bool IsThreadSafe() const { return false; }
+};
+
+// Every live row of a heap, decoded a page at a time. Threads calling Next together claim
+// pages in turn and decode them in parallel.
+class SeqScanExecutor : public Executor {
+public:
+    explicit SeqScanExecutor(TableHeap *heap) : heap_(heap), page_id_(heap->GetFirstPageId()) {}
+    bool Next(RowBatch *batch) override;
+    bool IsThreadSafe() const override { return true; }
+
+private:
+    TableHeap *heap_;
+    std::mutex latch_;
+    page_id_t page_id_;   // next page to claim
+};
+
+// Hands out the pages of a heap SCAN_MORSEL_PAGES at a time, numbering the morsels in
+// heap order. Thread-safe.
+class MorselSource {
+public:
+    explicit MorselSource(TableHeap *heap) : heap_(heap), next_page_(heap->GetFirstPageId()) {}
+
+    // Claim the next morsel: its number and its pages. False once the heap is used up.
+    bool Claim(size_t *morsel, std::vector<page_id_t> *pages);
+
+private:
+    TableHeap *heap_;
+    std::mutex latch_;
+    page_id_t next_page_;
+    size_t claimed_ = 0;
+};
+
+// Rows of a heap that satisfy a predicate (every row when it is null), scanned and filtered
+// a morsel at a time by the workers of a thread pool and by the threads calling Next.
+// Ordered, batches come out in heap order, one per non-empty morsel, and the workers run
+// at most a few morsels ahead of the consumer; unordered, morsels are handed out as they
+// finish and several threads may pull at once.
+class ParallelScanExecutor : public Executor {
+public:
+    ParallelScanExecutor(ThreadPool *pool, TableHeap *heap, const Predicate *pred, const Schema *schema, bool ordered);
+    ~ParallelScanExecutor() override;
+    bool Next(RowBatch *batch) override;
+    bool IsThreadSafe() const override { return !ordered_; }
+
+private:
+    // Shared with the workers' tasks, which may start after the executor is gone.
+    struct State {
+        ThreadPool *pool;
+        TableHeap *heap;
+        const Predicate *pred;
+        const Schema *schema;
+        bool ordered;
+        size_t window;                      // most morsels claimed but not yet handed out
+        MorselSource source;
+
+        std::mutex latch;
+        std::condition_variable cv;
+        bool started = false;
+        bool exhausted = false;             // every morsel has been claimed
+        bool cancelled = false;
+        size_t claimed = 0;
+        size_t consumed = 0;                // morsels handed out, empty ones included
+        size_t workers = 0;                 // worker tasks inside the scan loop
+        std::map<size_t, RowBatch> ready;   // finished morsels by number
+
+        State(ThreadPool *pool, TableHeap *heap, const Predicate *pred, const Schema *schema, bool ordered);
+
+        // Claim and scan the next morsel if the window allows, with lock held on entry and
+        // exit. False if there was nothing to claim.
+        bool ScanNext(std::unique_lock<std::mutex> &lock);
+        void RunWorker();
+    };
+
+    bool ordered_;
+    std::shared_ptr<State> state_;
+};
+
+// Rows of a table's column store. The predicate (if any) is evaluated column-wise by the
+// filter kernels when the scan starts, and only selected rows are reassembled into tuples.
+class ColumnScanExecutor : public Executor {
+public:
+    ColumnScanExecutor(TableInfo *table, const Predicate *pred) : table_(table), pred_(pred) {}
+    bool Next(RowBatch *batch) override;
+
+private:
+    TableInfo *table_;
+    const Predicate *pred_;
+    bool started_ = false;
+    std::vector<uint64_t> selection_;
+    size_t word_ = 0;            // next word of selection_ to emit
+};
+
+// Rows an index finds for one comparison on its key column, in the order the index returns
+// them. The rest of the where clause is left to a Filter above.
+class IndexScanExecutor : public Executor {
+public:
+    IndexScanExecutor(TableHeap *heap, IndexInfo *index, const Condition &cond)
+        : heap_(heap), index_(index), cond_(cond) {}
+
+    // True if index can answer cond: B+Trees serve equality and ranges, hash indexes equality.
+    static bool CanServe(const IndexInfo &index, const Condition &cond);
+
+    bool Next(RowBatch *batch) override;
+
+private:
+    TableHeap *heap_;
+    IndexInfo *index_;
+    Condition cond_;
+    bool started_ = false;
+    std::vector<RID> rids_;
+    size_t pos_ = 0;
+};
+
+// Rows of the child that satisfy a predicate.
+class FilterExecutor : public Executor {
+public:
+    FilterExecutor(std::unique_ptr<Executor> child, const Predicate *pred, const Schema *schema)
+        : child_(std::move(child)), pred_(pred), schema_(schema) {}
+    bool Next(RowBatch *batch) override;
+    bool IsThreadSafe() const override { return child_->IsThreadSafe(); }
+
+private:
+    std::unique_ptr<Executor> child_;
+    const Predicate *pred_;
+    const Schema *schema_;
+};
+
+// Rows of the child narrowed and reordered to columns.
+class ProjectionExecutor : public Executor {
+public:
+    ProjectionExecutor(std::unique_ptr<Executor> child, std::vector<int32_t> columns);
+    bool Next(RowBatch *batch) override;
+
+private:
+    std::unique_ptr<Executor> child_;
+    std::vector<int32_t> columns_;
+    bool identity_ = true;       // columns_ is 0, 1, 2, ...: rows of that width pass through
+    bool distinct_ = true;       // no column repeats, so values can be moved rather than copied
+    RowBatch input_;
+};
+
+// The limit rows of the child that follow its first offset rows; the child is not pulled
+// again once they are out.
+class LimitExecutor : public Executor {
+public:
+    LimitExecutor(std::unique_ptr<Executor> child, size_t limit, size_t offset = 0)
+        : child_(std::move(child)), remaining_(limit), skip_(offset) {}
+    bool Next(RowBatch *batch) override;
+
+private:
+    std::unique_ptr<Executor> child_;
+    size_t remaining_;
+    size_t skip_;
+};
+
+// One row per group of the child's rows: the group by values followed by the aggregates,
+// ordered by the group by values. The child is drained on the first call through
+// pool->ParallelFor: each of the pool's workers + 1 slots folds the batches it pulls into
+// its own AggregateHashTable, and the partial tables are merged once the child runs dry.
+// Without a pool the calling thread folds alone. Pulls are serialized unless the child is
+// thread-safe, in which case the scan itself runs in parallel. With no group by columns
+// there is exactly one row, even over no input.
+class AggregationExecutor : public Executor {
+public:
+    AggregationExecutor(std::unique_ptr<Executor> child, std::vector<int32_t> group_by,
+                        std::vector<AggregateExpr> aggregates, ThreadPool *pool = nullptr);
+    bool Next(RowBatch *batch) override;
+
+private:
+    void Build();
+
+    std::unique_ptr<Executor> child_;
+    std::vector<int32_t> group_by_;
+    std::vector<AggregateExpr> aggregates_;
+    ThreadPool *pool_;
+    std::unique_ptr<AggregateHashTable> table_;
+    std::vector<size_t> groups_;   // emit order
+    size_t pos_ = 0;
+};
+
+// Prints the child's rows through a ResultWriter, under a header row written before the
+// first batch; everything is on the stream once Next returns false. Batches pass through
+// unchanged. The writer's buffer comes from scratch, if given.
+class OutputExecutor : public Executor {
+public:
+    OutputExecutor(std::unique_ptr<Executor> child, std::vector<std::string> headers, std::ostream &out,
+                   Arena *scratch = nullptr)
+        : child_(std::move(child)), headers_(std::move(headers)), writer_(out, OUTPUT_BUFFER_BYTES, scratch) {}
+    bool Next(RowBatch *batch) override;
+
+    size_t GetRowCount() const { return row_count_; }
+
+private:
+    std::unique_ptr<Executor> child_;
+    std::vector<std::string> headers_;
+    ResultWriter writer_;
+    bool header_printed_ = false;
+    size_t row_count_ = 0;
+};
+
+// Plan the access path for the rows of table matching pred (every row when pred is null).
+// A comparison ANDed into pred on an indexed column becomes an IndexScan, and a table with
+// a column store gets a ColumnScan that applies pred itself; otherwise the heap is scanned
+// sequentially: in parallel on pool when one is given (in heap order if ordered), with pred
+// applied by the scan, and otherwise one page at a time under a Filter. Index scans are
+// filtered by pred too. For an analyzed table, the comparison whose index scan is estimated
+// cheapest is used, and none if the estimate says a full scan is cheaper.
+std::unique_ptr<Executor> MakeScanExecutor(Catalog &catalog, TableInfo *table, const Predicate *pred,
+                                           ThreadPool *pool = nullptr, bool ordered = true);
+
+// Feed the rows of table matching pred to sink a morsel at a time. When the rows come from a
+// sequential heap scan, morsels are scanned, filtered and passed to sink on the workers of
+// pool and the calling thread at once, so sink must be thread-safe; the morsel number tells
+// where the rows lie in heap order. Any other access path is drained on the calling thread
+// and handed to sink as morsel 0.
+void ScanMorsels(Catalog &catalog, TableInfo *table, const Predicate *pred, ThreadPool *pool,
+                 const std::function<void(size_t, RowBatch *)> &sink);
+
+// Pull every remaining row from executor, appending them to rows.
+void DrainExecutor(Executor *executor, RowBatch *rows);
+
+} // namespace simpledb
@@ -0,0 +1,135 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "execution/executor.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+#include "storage/table_heap.h"
+
+namespace simpledb {
+
+// Equi-join of two inputs: for every pair of rows whose key columns are equal, a row
+// holding the probe row's values followed by the build row's.
+//
+// Rows are split into JOIN_PARTITIONS partitions on the high bits of their key's hash.
+// The build input is drained first. While it fits in memory_budget bytes, each partition
+// becomes an in-memory hash table that the probe input is streamed through. Once the
+// build side outgrows the budget the join turns into a Grace hash join: build rows, and
+// then probe rows as they arrive, are written to per-partition heaps in a temporary file
+// behind a buffer pool of their own, and the partitions are joined one at a time, each
+// loaded into memory alone. A partition that is still too large is not split again.
+//
+// Build, probe and the partition joins run on the calling thread and the workers of pool
+// (if given), one slot each, from inside Next. The build side is drained on the first
+// call; after that each call runs rounds in which every slot probes one probe batch, or
+// one page of a spilled partition's probe rows, until a round has produced output.
+class HashJoinExecutor : public Executor {
+public:
+    HashJoinExecutor(std::unique_ptr<Executor> probe, const Schema *probe_schema, uint32_t probe_key,
+                     std::unique_ptr<Executor> build, const Schema *build_schema, uint32_t build_key,
+                     ThreadPool *pool = nullptr, size_t memory_budget = JOIN_MEMORY_BYTES);
+    ~HashJoinExecutor() override;
+
+    bool Next(RowBatch *batch) override;
+
+private:
+    // Build rows of one partition and a chained hash table over them.
+    struct Partition {
+        std::vector<Tuple> rows;
+        std::vector<uint64_t> hashes;
+        std::vector<uint32_t> buckets;   // first row + 1 of each chain, 0 if none
+        std::vector<uint32_t> next;      // row + 1 after each row in its chain
+
+        void BuildTable();
+        void Clear();
+    };
+
+    // Rows headed for each partition, gathered by one thread before they are handed over.
+    struct LocalPartitions {
+        std::vector<std::vector<Tuple>> rows;
+        std::vector<std::vector<uint64_t>> hashes;
+        size_t bytes = 0;
+
+        LocalPartitions() : rows(JOIN_PARTITIONS), hashes(JOIN_PARTITIONS) {}
+    };
+
+    enum class Phase { BUILD, PROBE, JOIN_SPILLED, DONE };
+
+    // A slot's place in the spilled partitions: the partition loaded into memory and the
+    // next page of its probe rows, INVALID_PAGE_ID once it is joined.
+    struct SpillCursor {
+        Partition partition;
+        size_t index = 0;
+        page_id_t next_page = INVALID_PAGE_ID;
+    };
+
+    // Run the current phase for one round and move on to the next phase once it is done.
+    void Advance();
+    void BuildPhase();
+    void SpillProbeRows();
+    bool ProbeRound();
+    bool JoinSpilledRound();
+
+    // Call body(slot) for every slot, on the pool if there is one, and wait for all of them.
+    void ForEachSlot(const std::function<void(size_t)> &body);
+
+    // Next batch of child, serialized unless child is thread-safe.
+    bool Pull(Executor *child, RowBatch *batch);
+
+    // Move local's rows into the shared build partitions, or into the spill heaps once the
+    // build side has outgrown the budget.
+    void DepositBuildRows(LocalPartitions *local);
+
+    // Create the spill file and heaps and move the in-memory build partitions into them.
+    // Called with spill_latch_ held.
+    void StartSpilling();
+    void SpillRows(std::vector<std::unique_ptr<TableHeap>> &heaps, LocalPartitions *local);
+
+    // Append the joins of a probe row whose key hashes to hash with its matches in
+    // partition to out, emitting out whenever it fills up.
+    void ProbeRow(const Partition &partition, const Tuple &row, uint64_t hash, RowBatch *out);
+
+    // Queue a non-empty batch for Next.
+    void Emit(RowBatch *out);
+
+    static size_t PartitionOf(uint64_t hash);
+
+    std::unique_ptr<Executor> probe_;
+    const Schema *probe_schema_;
+    uint32_t probe_key_;
+    std::unique_ptr<Executor> build_;
+    const Schema *build_schema_;
+    uint32_t build_key_;
+    ThreadPool *pool_;
+    size_t memory_budget_;
+    size_t num_slots_;
+    Phase phase_ = Phase::BUILD;
+
+    std::mutex pull_latch_;
+    std::vector<Partition> partitions_;
+
+    // Spilling, entered once and never left
+    std::mutex spill_latch_;
+    size_t memory_used_ = 0;
+    std::atomic<bool> spilled_{false};
+    std::atomic<bool> spill_failed_{false};
+    std::string spill_file_;
+    std::unique_ptr<DiskManager> spill_disk_;
+    std::unique_ptr<BufferPoolManager> spill_pool_;
+    std::vector<std::unique_ptr<TableHeap>> build_spill_;
+    std::vector<std::unique_ptr<TableHeap>> probe_spill_;
+    std::vector<SpillCursor> spill_cursors_;
+    std::atomic<size_t> next_spilled_{0};
+
+    // Batches produced by the slots, handed out by Next
+    std::mutex queue_latch_;
+    std::deque<RowBatch> queue_;
+};
+
+} // namespace simpledb
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "catalog/value.h"
+
+namespace simpledb {
+
+constexpr uint64_t HASH_SEED = 0x9e3779b97f4a7c15ULL;
+
+// 64-bit finalizer, so both the low bits (table slots) and the high bits (partitions)
+// of a hash are well mixed.
+inline uint64_t MixHash(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Fold value into hash; chain calls to hash several values.
+inline uint64_t HashValue(const Value &value, uint64_t hash = HASH_SEED) {
+    uint64_t h = value.GetTypeId() == TypeId::INTEGER ? static_cast<uint32_t>(value.GetAsInt())
+                                                      : std::hash<std::string_view>{}(value.GetAsString());
+    return MixHash(hash ^ h);
+}
+
+} // namespace simpledb
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "catalog/schema.h"
+#include "catalog/tuple.h"
+#include "storage/column_filter.h"
+
+namespace simpledb {
+
+// A single "<col> <op> <literal>" predicate from a where clause.
+struct Condition {
+    int32_t col_idx = -1;
+    CompareOp op = CompareOp::EQ;
+    std::string literal;        // as written, quotes included
+    std::string unquoted;       // literal without surrounding quotes
+    int32_t int_literal = 0;
+    bool int_parsed = false;    // literal parses as an integer
+    bool int_exact = false;     // literal is the canonical spelling of int_literal
+};
+
+// A compiled where clause: comparisons combined with AND, OR and NOT. Nodes live in one
+// array and refer to their operands by index, so evaluating a row never allocates.
+struct Predicate {
+    enum class Kind { COMPARE, AND, OR, NOT };
+    struct Node {
+        Kind kind = Kind::COMPARE;
+        int32_t left = -1;          // operand of NOT, or left operand of AND / OR
+        int32_t right = -1;
+        Condition cond;             // COMPARE only
+    };
+    std::vector<Node> nodes;
+    int32_t root = -1;
+    std::vector<int32_t> params;    // COMPARE nodes whose literal is a ? parameter, in order
+
+    int32_t Add(Node node) {
+        nodes.push_back(std::move(node));
+        return static_cast<int32_t>(nodes.size()) - 1;
+    }
+};
+
+// Type the literal of a comparison whose column and operator are already resolved. Runs
+// once per query, or once per execution for a ? parameter.
+bool BindCondition(const Schema &schema, std::string_view literal, Condition *cond);
+
+// Compile the text of a where clause (without the "where" keyword). With allow_params, a
+// bare ? literal is a parameter, recorded in pred->params and bound later with BindCondition.
+bool ParsePredicate(const Schema &schema, std::string where_part, Predicate *pred, bool allow_params = false);
+
+bool MatchesCondition(const Tuple &tuple, const Schema &schema, const Condition &cond);
+bool MatchesPredicate(const Predicate &pred, int32_t node, const Tuple &tuple, const Schema &schema);
+bool MatchesPredicate(const Predicate &pred, const Tuple &tuple, const Schema &schema);
+
+// The comparisons a predicate is ANDed from at the top level; every matching row satisfies each.
+void CollectConjuncts(const Predicate &pred, int32_t node, std::vector<const Condition *> *conjuncts);
+
+} // namespace simpledb
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "catalog/tuple.h"
+#include "common/arena.h"
+#include "common/config.h"
+
+namespace simpledb {
+
+// Formats result rows as a text table, one cell of at least 20 characters followed by
+// " | " per value, straight into a single buffer. The buffer goes to the stream in one
+// write whenever it fills up, on Flush, and when the writer is destroyed. The buffer comes
+// from scratch when one is given, which must outlive the writer.
+class ResultWriter {
+public:
+    explicit ResultWriter(std::ostream &out, size_t capacity = OUTPUT_BUFFER_BYTES, Arena *scratch = nullptr);
+    ~ResultWriter() { Flush(); }
+
+    // The header cells and the rule beneath them.
+    void WriteHeader(const std::vector<std::string> &headers);
+    void WriteRow(const Tuple &tuple);
+    void Flush();
+
+private:
+    void AppendCell(const char *data, size_t size);
+
+    std::ostream &out_;
+    size_t capacity_;
+    ScratchString buffer_;
+};
+
+} // namespace simpledb
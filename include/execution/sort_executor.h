@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "execution/executor.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+#include "storage/disk_scheduler.h"
+
+namespace simpledb {
+
+// One column of an order by: its position in the child's rows and its direction. A numeric
+// column orders text by the number it spells, for aggregates too wide for INT.
+struct SortKey {
+    int32_t col = 0;
+    bool descending = false;
+    bool numeric = false;
+};
+
+// The child's rows ordered by keys, NULLs first and ties in input order. The child is
+// drained on the first call.
+//
+// With a limit, only that many rows are held: they are kept in a bounded heap whose top is
+// the last row so far, which each new row must beat. Otherwise rows are gathered until
+// they take memory_budget bytes, and from then on the sort is an external merge sort: each
+// time the budget fills, the rows are sorted and written as a run to a temporary file
+// through a buffer pool of its own. Once the child is drained, runs are merged
+// SORT_MERGE_FAN_IN at a time until the rest fit in one last merge, which also takes the
+// rows still in memory and feeds Next. Every run is read SORT_READ_AHEAD_PAGES pages at a
+// time, with the next pages already being read while the current ones are merged. A
+// bounded heap that outgrows the budget, under a very large limit, spills the same way.
+class SortExecutor : public Executor {
+public:
+    SortExecutor(std::unique_ptr<Executor> child, std::vector<SortKey> keys,
+                 size_t limit = std::numeric_limits<size_t>::max(), size_t memory_budget = SORT_MEMORY_BYTES);
+    ~SortExecutor() override;
+
+    bool Next(RowBatch *batch) override;
+
+private:
+    struct Row {
+        Tuple tuple;
+        RID rid;
+        size_t seq;         // position in the input, to break ties
+    };
+
+    // A sorted run in the spill file: its rows encoded back to back, cut into pages.
+    struct Run {
+        std::vector<page_id_t> pages;
+        size_t bytes = 0;
+    };
+
+    class RunReader;
+    class RunWriter;
+
+    // A k-way merge, smallest row first.
+    struct Merge {
+        std::vector<std::unique_ptr<RunReader>> readers;
+        std::vector<Row> heads;   // heap of each unfinished reader's next row, seq = reader index
+    };
+
+    // True if the row (a, seq_a) sorts before (b, seq_b).
+    bool Before(const Tuple &a, size_t seq_a, const Tuple &b, size_t seq_b) const;
+    void Build();
+
+    // Sort rows_ and write them to the spill file as a new run. If the run cannot be
+    // written, the rows stay in memory and no more runs are attempted.
+    void SpillRun();
+    void StartSpilling();
+
+    // Merge runs_ in groups of SORT_MERGE_FAN_IN, each into one run that takes its place.
+    // False if a merged run could not be written.
+    bool MergePass();
+
+    // Open a merge over runs [first, first + count), followed by memory (if given), whose
+    // rows must already be sorted.
+    bool OpenMerge(size_t first, size_t count, std::vector<Row> *memory, Merge *merge);
+    bool PopMerge(Merge *merge, Row *row);
+
+    std::unique_ptr<Executor> child_;
+    std::vector<SortKey> keys_;
+    size_t limit_;
+    size_t memory_budget_;
+    bool built_ = false;
+    std::vector<Row> rows_;
+    size_t memory_used_ = 0;
+    size_t pos_ = 0;
+
+    // Spilling
+    bool spill_failed_ = false;
+    std::string spill_file_;
+    std::unique_ptr<DiskManager> spill_disk_;
+    std::unique_ptr<BufferPoolManager> spill_pool_;
+    std::unique_ptr<DiskScheduler> spill_io_;   // read-ahead for merges
+    std::vector<Run> runs_;
+    std::unique_ptr<Merge> merge_;              // feeding Next, once runs were spilled
+    size_t emitted_ = 0;
+};
+
+} // namespace simpledb
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace simpledb {
+
+// A fixed set of worker threads running submitted tasks. Every worker owns a deque: a
+// task submitted by a worker goes to the back of its own deque, which it works through
+// newest first, and a worker whose deque is empty steals the oldest task from another's.
+// Tasks submitted from outside the pool are dealt round-robin across the deques.
+class ThreadPool {
+public:
+    // With no workers, Submit and ParallelFor run everything on the calling thread.
+    explicit ThreadPool(size_t num_workers);
+
+    // Finishes the tasks already submitted, then joins the workers.
+    ~ThreadPool();
+
+    size_t GetWorkerCount() const { return workers_.size(); }
+
+    void Submit(std::function<void()> task);
+
+    // Call body(i) for every i in [0, count) on the workers and the calling thread, and
+    // return once all calls have finished. A worker that reaches the loop only after it has
+    // been finished leaves without touching body, so loops may nest and never wait on
+    // workers busy elsewhere.
+    void ParallelFor(size_t count, const std::function<void(size_t)> &body);
+
+private:
+    struct Queue {
+        std::mutex latch;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void WorkerLoop(size_t self);
+
+    // Take the newest task of queue self or, failing that, the oldest of any other queue.
+    bool PopOrSteal(size_t self, std::function<void()> *task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_queue_{0};   // round-robin cursor for outside submissions
+
+    std::mutex sleep_latch_;
+    std::condition_variable sleep_cv_;
+    // Tasks queued and not yet taken, under sleep_latch_. Counted after the push, so a
+    // quick taker can briefly drive it below zero.
+    ptrdiff_t pending_ = 0;
+    bool stopping_ = false;
+};
+
+} // namespace simpledb
@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <shared_mutex>
+#include "common/rid.h"
+#include "index/b_plus_tree_page.h"
+#include "index/index.h"
+#include "storage/buffer_pool_manager.h"
+
+namespace simpledb {
+
+// Disk-resident B+Tree over an INTEGER column. Every node is a buffer pool page.
+// Deletes are lazy: entries are removed from their leaf but nodes are never merged,
+// so separators in internal nodes remain valid routing keys.
+class BPlusTree : public Index {
+public:
+    BPlusTree(BufferPoolManager *bpm, page_id_t root_page_id = INVALID_PAGE_ID);
+
+    bool InsertEntry(const Value &key, const RID &rid) override { return Insert(key.GetAsInt(), rid); }
+    bool DeleteEntry(const Value &key, const RID &rid) override { return Remove(key.GetAsInt(), rid); }
+    void ScanKey(const Value &key, std::vector<RID> *result) override {
+        ScanRange(key.GetAsInt(), key.GetAsInt(), result);
+    }
+    bool SupportsRange() const override { return true; }
+
+    bool Insert(int32_t key, const RID &rid);
+
+    bool Remove(int32_t key, const RID &rid);
+
+    // Append the RIDs of every entry with low <= key <= high, in key order.
+    void ScanRange(int32_t low, int32_t high, std::vector<RID> *result) override;
+
+    page_id_t GetRootPageId() const override { return root_page_id_; }
+
+private:
+    // Descend to the leaf that would hold k, recording the internal pages visited.
+    page_id_t FindLeaf(const IndexKey &k, std::vector<page_id_t> *path);
+
+    // Pin the ancestors a leaf split reaches and allocate the pages it needs; on failure
+    // releases them all and returns false.
+    bool ReserveSplit(const std::vector<page_id_t> &path, std::vector<Page *> *parents,
+                      std::vector<Page *> *spare);
+
+    // Link right in after left, splitting upward with the pages ReserveSplit set aside.
+    void InsertIntoParent(std::vector<Page *> *parents, page_id_t left, const IndexKey &key, page_id_t right,
+                          std::vector<Page *> *spare);
+
+    BufferPoolManager *bpm_;
+    std::shared_mutex latch_;   // writers exclusive, lookups shared
+    page_id_t root_page_id_;
+};
+
+} // namespace simpledb
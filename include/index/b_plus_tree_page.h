@@ -0,0 +1,165 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/page.h"
+
+namespace simpledb {
+
+// Index keys are (column value, RID) pairs so duplicate column values stay unique in the tree.
+struct IndexKey {
+    int32_t key;
+    page_id_t page_id;
+    uint32_t slot_num;
+
+    IndexKey() = default;
+    IndexKey(int32_t k, const RID &rid) : key(k), page_id(rid.GetPageId()), slot_num(rid.GetSlotNum()) {}
+
+    RID GetRID() const { return RID(page_id, slot_num); }
+
+    bool operator<(const IndexKey &o) const {
+        if (key != o.key) return key < o.key;
+        if (page_id != o.page_id) return page_id < o.page_id;
+        return slot_num < o.slot_num;
+    }
+    bool operator==(const IndexKey &o) const {
+        return key == o.key && page_id == o.page_id && slot_num == o.slot_num;
+    }
+    bool operator<=(const IndexKey &o) const { return !(o < *this); }
+};
+
+enum class BPlusTreePageType : int32_t { INVALID = 0, LEAF, INTERNAL };
+
+// Common node header shared by leaf and internal pages.
+//
+//  | page_type | size | next_page_id | reserved | entries ... |
+class BPlusTreePage {
+public:
+    explicit BPlusTreePage(Page *page) : data_(page->GetData()) {}
+
+    BPlusTreePageType GetPageType() const { return static_cast<BPlusTreePageType>(ReadInt(0)); }
+    void SetPageType(BPlusTreePageType type) { WriteInt(0, static_cast<int32_t>(type)); }
+    bool IsLeaf() const { return GetPageType() == BPlusTreePageType::LEAF; }
+
+    int32_t GetSize() const { return ReadInt(4); }
+    void SetSize(int32_t size) { WriteInt(4, size); }
+
+protected:
+    static constexpr uint32_t HEADER_SIZE = 16;
+
+    int32_t ReadInt(uint32_t offset) const {
+        int32_t v;
+        memcpy(&v, data_ + offset, sizeof(int32_t));
+        return v;
+    }
+    void WriteInt(uint32_t offset, int32_t v) { memcpy(data_ + offset, &v, sizeof(int32_t)); }
+
+    char *data_;
+};
+
+// Leaf node: sorted IndexKeys, chained to the next leaf for range scans.
+class BPlusTreeLeafPage : public BPlusTreePage {
+public:
+    // One spare entry is reserved so a node can overflow by one before it is split.
+    static constexpr int32_t MAX_SIZE = (PAGE_SIZE - HEADER_SIZE) / sizeof(IndexKey) - 1;
+
+    explicit BPlusTreeLeafPage(Page *page) : BPlusTreePage(page) {}
+
+    void Init() {
+        SetPageType(BPlusTreePageType::LEAF);
+        SetSize(0);
+        SetNextPageId(INVALID_PAGE_ID);
+    }
+
+    page_id_t GetNextPageId() const { return ReadInt(8); }
+    void SetNextPageId(page_id_t id) { WriteInt(8, id); }
+
+    IndexKey KeyAt(int32_t i) const {
+        IndexKey k;
+        memcpy(&k, data_ + HEADER_SIZE + i * sizeof(IndexKey), sizeof(IndexKey));
+        return k;
+    }
+    void SetKeyAt(int32_t i, const IndexKey &k) {
+        memcpy(data_ + HEADER_SIZE + i * sizeof(IndexKey), &k, sizeof(IndexKey));
+    }
+
+    // First position whose key is >= k.
+    int32_t LowerBound(const IndexKey &k) const {
+        int32_t lo = 0, hi = GetSize();
+        while (lo < hi) {
+            int32_t mid = (lo + hi) / 2;
+            if (KeyAt(mid) < k) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+
+    void InsertAt(int32_t pos, const IndexKey &k) {
+        char *base = data_ + HEADER_SIZE;
+        memmove(base + (pos + 1) * sizeof(IndexKey), base + pos * sizeof(IndexKey),
+                (GetSize() - pos) * sizeof(IndexKey));
+        SetKeyAt(pos, k);
+        SetSize(GetSize() + 1);
+    }
+
+    void RemoveAt(int32_t pos) {
+        char *base = data_ + HEADER_SIZE;
+        memmove(base + pos * sizeof(IndexKey), base + (pos + 1) * sizeof(IndexKey),
+                (GetSize() - pos - 1) * sizeof(IndexKey));
+        SetSize(GetSize() - 1);
+    }
+};
+
+// Internal node: child pointers separated by keys. Entry 0 carries only a child;
+// child i covers keys in [key(i), key(i + 1)).
+class BPlusTreeInternalPage : public BPlusTreePage {
+public:
+    struct Entry {
+        IndexKey key;
+        page_id_t child;
+    };
+    static constexpr int32_t MAX_SIZE = (PAGE_SIZE - HEADER_SIZE) / sizeof(Entry) - 1;
+
+    explicit BPlusTreeInternalPage(Page *page) : BPlusTreePage(page) {}
+
+    void Init() {
+        SetPageType(BPlusTreePageType::INTERNAL);
+        SetSize(0);
+    }
+
+    Entry EntryAt(int32_t i) const {
+        Entry e;
+        memcpy(&e, data_ + HEADER_SIZE + i * sizeof(Entry), sizeof(Entry));
+        return e;
+    }
+    void SetEntryAt(int32_t i, const Entry &e) {
+        memcpy(data_ + HEADER_SIZE + i * sizeof(Entry), &e, sizeof(Entry));
+    }
+
+    // Index of the child whose range contains k.
+    int32_t ChildIndex(const IndexKey &k) const {
+        int32_t lo = 1, hi = GetSize();
+        while (lo < hi) {
+            int32_t mid = (lo + hi) / 2;
+            if (EntryAt(mid).key <= k) lo = mid + 1; else hi = mid;
+        }
+        return lo - 1;
+    }
+
+    int32_t IndexOfChild(page_id_t child) const {
+        for (int32_t i = 0; i < GetSize(); ++i) {
+            if (EntryAt(i).child == child) return i;
+        }
+        return -1;
+    }
+
+    void InsertAt(int32_t pos, const Entry &e) {
+        char *base = data_ + HEADER_SIZE;
+        memmove(base + (pos + 1) * sizeof(Entry), base + pos * sizeof(Entry),
+                (GetSize() - pos) * sizeof(Entry));
+        SetEntryAt(pos, e);
+        SetSize(GetSize() + 1);
+    }
+};
+
+} // namespace simpledb
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <shared_mutex>
+#include "index/hash_table_page.h"
+#include "index/index.h"
+#include "storage/buffer_pool_manager.h"
+
+namespace simpledb {
+
+// Disk-resident extendible hash index for exact-match lookups on VARCHAR columns.
+// A header page selects a directory by the high hash bits; each directory maps the
+// low bits to bucket pages. A full bucket splits on its next hash bit, doubling its
+// directory only when the bucket is already as deep as the directory. Only hashes
+// are stored, so lookups return candidates that the caller re-checks against the row.
+class ExtendibleHashIndex : public Index {
+public:
+    ExtendibleHashIndex(BufferPoolManager *bpm, page_id_t header_page_id = INVALID_PAGE_ID);
+
+    bool InsertEntry(const Value &key, const RID &rid) override;
+    bool DeleteEntry(const Value &key, const RID &rid) override;
+    void ScanKey(const Value &key, std::vector<RID> *result) override;
+
+    page_id_t GetHeaderPageId() const { return header_page_id_; }
+    page_id_t GetRootPageId() const override { return header_page_id_; }
+
+    static uint32_t Hash(std::string_view key);
+
+private:
+    // Directory page covering hash, created on demand when `create` is set.
+    page_id_t GetDirectory(uint32_t hash, bool create);
+
+    // Split the bucket at dir_slot on its next hash bit, rehashing its whole chain.
+    bool SplitBucket(HashDirectoryPage &dir, uint32_t dir_slot);
+
+    // Make room in a full head page by moving its entries to a new overflow page
+    // linked directly behind it, so inserts never walk the chain.
+    bool PushToChain(Page *head_page);
+
+    BufferPoolManager *bpm_;
+    std::shared_mutex latch_;   // writers exclusive, lookups shared
+    page_id_t header_page_id_;
+};
+
+} // namespace simpledb
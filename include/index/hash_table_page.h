@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/page.h"
+
+namespace simpledb {
+
+// Header page of an extendible hash index: routes the top HEADER_DEPTH bits of a hash
+// to a directory page. Directories are allocated lazily on first insert.
+class HashHeaderPage {
+public:
+    static constexpr uint32_t HEADER_DEPTH = 9;
+    static constexpr uint32_t MAX_DIRECTORIES = 1u << HEADER_DEPTH;
+
+    explicit HashHeaderPage(Page *page) : data_(page->GetData()) {}
+
+    void Init() {
+        for (uint32_t i = 0; i < MAX_DIRECTORIES; ++i) SetDirectoryPageId(i, INVALID_PAGE_ID);
+    }
+
+    static uint32_t IndexOf(uint32_t hash) { return hash >> (32 - HEADER_DEPTH); }
+
+    page_id_t GetDirectoryPageId(uint32_t slot) const {
+        page_id_t id;
+        memcpy(&id, data_ + slot * sizeof(page_id_t), sizeof(page_id_t));
+        return id;
+    }
+    void SetDirectoryPageId(uint32_t slot, page_id_t id) {
+        memcpy(data_ + slot * sizeof(page_id_t), &id, sizeof(page_id_t));
+    }
+
+private:
+    char *data_;
+};
+
+// Directory page of an extendible hash index.
+//
+//  | global_depth | bucket_page_ids[1 << MAX_DEPTH] | local_depths[1 << MAX_DEPTH] |
+class HashDirectoryPage {
+public:
+    static constexpr uint32_t MAX_DEPTH = 9;
+    static constexpr uint32_t MAX_SLOTS = 1u << MAX_DEPTH;
+
+    explicit HashDirectoryPage(Page *page) : data_(page->GetData()) {}
+
+    void Init(page_id_t first_bucket) {
+        SetGlobalDepth(0);
+        SetBucketPageId(0, first_bucket);
+        SetLocalDepth(0, 0);
+    }
+
+    uint32_t GetGlobalDepth() const {
+        uint32_t d;
+        memcpy(&d, data_, sizeof(uint32_t));
+        return d;
+    }
+    void SetGlobalDepth(uint32_t d) { memcpy(data_, &d, sizeof(uint32_t)); }
+    uint32_t Size() const { return 1u << GetGlobalDepth(); }
+    uint32_t IndexOf(uint32_t hash) const { return hash & (Size() - 1); }
+
+    page_id_t GetBucketPageId(uint32_t slot) const {
+        page_id_t id;
+        memcpy(&id, data_ + OFFSET_BUCKETS + slot * sizeof(page_id_t), sizeof(page_id_t));
+        return id;
+    }
+    void SetBucketPageId(uint32_t slot, page_id_t id) {
+        memcpy(data_ + OFFSET_BUCKETS + slot * sizeof(page_id_t), &id, sizeof(page_id_t));
+    }
+
+    uint32_t GetLocalDepth(uint32_t slot) const {
+        return static_cast<uint8_t>(data_[OFFSET_DEPTHS + slot]);
+    }
+    void SetLocalDepth(uint32_t slot, uint32_t d) { data_[OFFSET_DEPTHS + slot] = static_cast<char>(d); }
+
+    // Double the directory; the new upper half mirrors the lower half.
+    void Grow() {
+        uint32_t size = Size();
+        for (uint32_t i = 0; i < size; ++i) {
+            SetBucketPageId(i + size, GetBucketPageId(i));
+            SetLocalDepth(i + size, GetLocalDepth(i));
+        }
+        SetGlobalDepth(GetGlobalDepth() + 1);
+    }
+
+private:
+    static constexpr uint32_t OFFSET_BUCKETS = 4;
+    static constexpr uint32_t OFFSET_DEPTHS = OFFSET_BUCKETS + MAX_SLOTS * sizeof(page_id_t);
+
+    char *data_;
+};
+
+// Bucket page: unordered (hash, RID) entries. Keys that collide beyond what the
+// directory can separate spill into a chain of overflow pages.
+//
+//  | size | overflow_page_id | entries ... |
+class HashBucketPage {
+public:
+    struct Entry {
+        uint32_t hash;
+        page_id_t page_id;
+        uint32_t slot_num;
+    };
+    static constexpr uint32_t HEADER_SIZE = 8;
+    static constexpr uint32_t CAPACITY = (PAGE_SIZE - HEADER_SIZE) / sizeof(Entry);
+
+    explicit HashBucketPage(Page *page) : data_(page->GetData()) {}
+
+    void Init() {
+        SetSize(0);
+        SetOverflowPageId(INVALID_PAGE_ID);
+    }
+
+    uint32_t GetSize() const {
+        uint32_t s;
+        memcpy(&s, data_, sizeof(uint32_t));
+        return s;
+    }
+    void SetSize(uint32_t s) { memcpy(data_, &s, sizeof(uint32_t)); }
+    bool IsFull() const { return GetSize() >= CAPACITY; }
+
+    page_id_t GetOverflowPageId() const {
+        page_id_t id;
+        memcpy(&id, data_ + 4, sizeof(page_id_t));
+        return id;
+    }
+    void SetOverflowPageId(page_id_t id) { memcpy(data_ + 4, &id, sizeof(page_id_t)); }
+
+    Entry EntryAt(uint32_t i) const {
+        Entry e;
+        memcpy(&e, data_ + HEADER_SIZE + i * sizeof(Entry), sizeof(Entry));
+        return e;
+    }
+
+    void Append(const Entry &e) {
+        uint32_t size = GetSize();
+        memcpy(data_ + HEADER_SIZE + size * sizeof(Entry), &e, sizeof(Entry));
+        SetSize(size + 1);
+    }
+
+    // Remove entry i by moving the last entry into its place.
+    void RemoveAt(uint32_t i) {
+        uint32_t last = GetSize() - 1;
+        if (i != last) {
+            memcpy(data_ + HEADER_SIZE + i * sizeof(Entry), data_ + HEADER_SIZE + last * sizeof(Entry), sizeof(Entry));
+        }
+        SetSize(last);
+    }
+
+private:
+    char *data_;
+};
+
+} // namespace simpledb
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include "catalog/value.h"
+#include "common/rid.h"
+
+namespace simpledb {
+
+enum class IndexType { BPLUS_TREE = 0, HASH };
+
+// Common interface for secondary indexes mapping column values to RIDs.
+class Index {
+public:
+    virtual ~Index() = default;
+
+    virtual bool InsertEntry(const Value &key, const RID &rid) = 0;
+
+    virtual bool DeleteEntry(const Value &key, const RID &rid) = 0;
+
+    // Append candidate RIDs for rows whose key equals `key`. Hash indexes may
+    // return collisions, so callers re-check the predicate on the fetched tuple.
+    virtual void ScanKey(const Value &key, std::vector<RID> *result) = 0;
+
+    // Page the index is reopened from after a restart.
+    virtual page_id_t GetRootPageId() const = 0;
+
+    // Ordered indexes also answer inclusive integer range scans.
+    virtual bool SupportsRange() const { return false; }
+    virtual void ScanRange(int32_t /*low*/, int32_t /*high*/, std::vector<RID> * /*result*/) {}
+};
+
+} // namespace simpledb
@@ -0,0 +1,65 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "catalog/catalog.h"
+#include "recovery/log_manager.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+namespace simpledb {
+
+// Writes consistent snapshots of the catalog and every table and index page into the
+// .db file, then truncates the log, so recovery only redoes what was logged since.
+// Statements hold the statement latch shared and a checkpoint takes it exclusively, so
+// a snapshot always falls between statements.
+//
+// The catalog is kept in page 0 and, when it outgrows it, a chain of overflow pages:
+//
+//  page 0:   | magic | checkpoint lsn | next page id | size | crc | next meta page | catalog bytes ... |
+//  overflow: | next meta page | catalog bytes ... |
+class CheckpointManager {
+public:
+    CheckpointManager(Catalog *catalog, BufferPoolManager *bpm, DiskManager *disk_manager);
+    ~CheckpointManager();
+
+    // False if db_file exists but was not written by a checkpoint (e.g. by an older version).
+    static bool IsSnapshotFile(const std::string &db_file);
+
+    // Register the tables and indexes of the last checkpoint with the catalog. Returns the
+    // checkpoint LSN, or 0 if the database has never been checkpointed.
+    lsn_t LoadSnapshot();
+
+    // Logging starts after recovery; checkpoints need the log to truncate it.
+    void SetLogManager(LogManager *log_manager) { log_manager_ = log_manager; }
+
+    // Take a checkpoint now, reporting how many pages reached the .db file.
+    bool Checkpoint(int *pages_written = nullptr);
+
+    // Checkpoint from a background thread whenever the log grows past log_bytes.
+    void StartBackground(size_t log_bytes = CHECKPOINT_LOG_BYTES);
+
+    std::shared_mutex &GetStatementLatch() { return statement_latch_; }
+
+private:
+    std::string SerializeCatalog();
+    bool WriteMetadata(lsn_t checkpoint_lsn, const std::string &catalog);
+    void BackgroundLoop(size_t log_bytes);
+
+    Catalog *catalog_;
+    BufferPoolManager *bpm_;
+    DiskManager *disk_manager_;
+    LogManager *log_manager_ = nullptr;
+    std::vector<page_id_t> meta_pages_;   // overflow pages of the last snapshot, reused by the next
+
+    std::shared_mutex statement_latch_;
+    std::mutex background_latch_;
+    std::condition_variable background_cv_;
+    bool stop_ = false;
+    std::thread background_thread_;
+};
+
+} // namespace simpledb
@@ -0,0 +1,72 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "common/config.h"
+#include "recovery/log_record.h"
+
+namespace simpledb {
+
+// Long-lived writer for the binary write-ahead log. Records are appended to an
+// in-memory buffer and written out in batches, so many commits share one write and
+// one fsync. Commit() blocks only as long as the durability mode requires.
+class LogManager {
+public:
+    LogManager(const std::string &log_file, DurabilityMode mode = DEFAULT_DURABILITY,
+               size_t group_ms = LOG_GROUP_COMMIT_MS, size_t group_bytes = LOG_GROUP_COMMIT_BYTES);
+    ~LogManager();
+
+    // Buffer a record and return the LSN assigned to it.
+    lsn_t AppendRecord(const LogRecord &record);
+
+    // Continue numbering after the last record found by recovery.
+    void SetNextLSN(lsn_t lsn);
+
+    // Make the record at lsn as durable as the current mode promises; false on an I/O error.
+    bool Commit(lsn_t lsn);
+
+    // Write and fsync everything appended so far.
+    bool Flush();
+
+    void SetDurability(DurabilityMode mode, size_t group_ms, size_t group_bytes);
+    DurabilityMode GetDurability() const { return mode_; }
+
+    lsn_t GetPersistentLSN();
+
+    // LSN of the most recently appended record
+    lsn_t GetLastLSN();
+
+    // Bytes in the log file plus those still buffered
+    size_t GetLogSize();
+
+    // Drop every record from the log, e.g. once a checkpoint covers them all.
+    bool Truncate();
+
+private:
+    // Write out the buffer as the single flusher, fsyncing if asked. Called with lock held;
+    // the lock is released around the I/O.
+    bool FlushLocked(std::unique_lock<std::mutex> &lock, bool sync);
+    void FlushLoop();
+
+    int fd_ = -1;
+    std::string log_file_;
+    DurabilityMode mode_;
+    size_t group_ms_;
+    size_t group_bytes_;
+
+    std::mutex latch_;
+    std::condition_variable flush_cv_;   // wakes the background flusher
+    std::condition_variable done_cv_;    // wakes committers when a flush finishes
+    std::string buffer_;
+    bool flushing_ = false;
+    bool stop_ = false;
+    lsn_t next_lsn_ = 1;
+    lsn_t buffered_lsn_ = INVALID_LSN;     // last LSN appended to buffer_
+    lsn_t written_lsn_ = INVALID_LSN;      // last LSN handed to the OS
+    lsn_t persistent_lsn_ = INVALID_LSN;   // last LSN known to be on stable storage
+    size_t file_size_ = 0;
+    std::thread flush_thread_;
+};
+
+} // namespace simpledb
@@ -0,0 +1,88 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/rid.h"
+
+namespace simpledb {
+
+// Every binary log file starts with this marker; older logs hold SQL text instead.
+constexpr char LOG_FILE_MAGIC[] = "SDBWAL01";
+constexpr size_t LOG_FILE_MAGIC_SIZE = sizeof(LOG_FILE_MAGIC) - 1;
+
+enum class LogRecordType : uint8_t {
+    INVALID = 0,
+    CREATE_TABLE,   // table oid, name, columns
+    CREATE_INDEX,   // table oid, index name, key column
+    NEW_PAGE,       // table oid, previous last page (or invalid for the first page), new page
+    INSERT,         // table oid, rid, serialized tuple
+    DELETE,         // table oid, rid
+    UPDATE,         // table oid, rid, serialized tuple
+    COMMIT,         // end of a statement; records after the last COMMIT are discarded
+    LOAD_PAGE,      // table oid, previous last page, new page, image of the page filled by a bulk load
+    INSERT_BATCH,   // table oid, page, then slot, size and serialized tuple for each tuple
+    VACUUM_PAGE,    // table oid, page whose tombstones and dead bytes were compacted away
+};
+
+// A physical, row-level change. On disk each record is framed as
+//
+//  | size (4) | crc32 (4) | lsn (8) | type (1) | payload |
+//
+// where size covers the whole record and the CRC covers everything after it.
+class LogRecord {
+public:
+    static constexpr uint32_t HEADER_SIZE = 17;
+
+    LogRecord() = default;
+
+    static LogRecord CreateTable(table_oid_t table_oid, const std::string &table_name, const Schema &schema);
+    static LogRecord CreateIndex(table_oid_t table_oid, const std::string &index_name, uint32_t key_col);
+    static LogRecord NewPage(table_oid_t table_oid, page_id_t prev_page_id, page_id_t page_id);
+    static LogRecord Insert(table_oid_t table_oid, const RID &rid, const char *data, uint32_t size);
+    static LogRecord Delete(table_oid_t table_oid, const RID &rid);
+    static LogRecord Update(table_oid_t table_oid, const RID &rid, const char *data, uint32_t size);
+    static LogRecord Commit();
+    static LogRecord InsertBatch(table_oid_t table_oid, page_id_t page_id, std::string tuples);
+    static LogRecord VacuumPage(table_oid_t table_oid, page_id_t page_id);
+    static LogRecord LoadPage(table_oid_t table_oid, page_id_t prev_page_id, page_id_t page_id, const char *image);
+
+    // Pack one tuple into the tuples argument of InsertBatch.
+    static void AppendBatchTuple(std::string *tuples, uint32_t slot, const char *data, uint32_t size);
+    // Unpack an INSERT_BATCH record into (slot, tuple) pairs.
+    std::vector<std::pair<uint32_t, std::string>> GetBatchTuples() const;
+
+    // Append the framed record, stamped with lsn, to out.
+    void SerializeTo(lsn_t lsn, std::string *out) const;
+
+    // Parse the record at the start of [data, data + size). Returns the bytes consumed,
+    // or 0 if the record is incomplete or fails its CRC.
+    static size_t DeserializeFrom(const char *data, size_t size, LogRecord *record);
+
+    LogRecordType GetType() const { return type_; }
+    lsn_t GetLSN() const { return lsn_; }
+    table_oid_t GetTableOid() const { return table_oid_; }
+    const RID &GetRID() const { return rid_; }
+    page_id_t GetPrevPageId() const { return prev_page_id_; }
+    uint32_t GetKeyCol() const { return key_col_; }
+    const std::string &GetName() const { return name_; }
+    const std::vector<Column> &GetColumns() const { return columns_; }
+    const std::string &GetTupleData() const { return data_; }   // page image for LOAD_PAGE
+
+    // Hand the tuple data over to the caller, leaving the record without it.
+    std::string ReleaseTupleData() { return std::move(data_); }
+
+private:
+    LogRecordType type_ = LogRecordType::INVALID;
+    lsn_t lsn_ = INVALID_LSN;
+    table_oid_t table_oid_ = 0;
+    RID rid_;                                    // NEW_PAGE keeps the new page id here
+    page_id_t prev_page_id_ = INVALID_PAGE_ID;
+    uint32_t key_col_ = 0;
+    std::string name_;
+    std::vector<Column> columns_;
+    std::string data_;
+};
+
+} // namespace simpledb
@@ -0,0 +1,84 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "catalog/catalog.h"
+#include "recovery/log_record.h"
+#include "storage/disk_manager.h"
+
+namespace simpledb {
+
+// Brings the catalog and table heaps up to date by redoing the records of a binary log
+// on top of the last checkpoint. Records are applied a statement at a time: anything
+// after the last COMMIT belongs to a statement that never finished and is cut from the
+// log, along with a torn or corrupt tail. Index changes are not logged; redo keeps the
+// checkpointed indexes in step with the rows it changes, and indexes created after the
+// checkpoint are built from their tables once redo is complete.
+//
+// The log is decoded once on the calling thread, and committed row changes are routed
+// to a pool of workers by table, so tables replay in parallel while each table sees its
+// records in log order. Creating a table waits for the workers to drain first. With
+// fewer than two workers, records are applied inline. A first pass over the log reserves
+// the page ids of every logged heap page before any record is applied.
+class LogRecovery {
+public:
+    LogRecovery(Catalog *catalog, DiskManager *disk_manager, size_t num_workers = RECOVERY_THREADS);
+    ~LogRecovery();
+
+    // Redo every committed record in log_file newer than checkpoint_lsn. A missing or
+    // empty log is not an error.
+    bool Recover(const std::string &log_file, lsn_t checkpoint_lsn = 0);
+
+    // LSN to continue numbering from
+    lsn_t GetNextLSN() const { return next_lsn_; }
+
+    // Records newer than the checkpoint, applied or discarded
+    size_t GetRecordCount() const { return record_count_; }
+
+    // True if log_file holds the SQL text log written by older versions.
+    static bool IsLegacyLog(const std::string &log_file);
+
+private:
+    // A row change resolved to its table on the decoding thread, so workers never
+    // touch the catalog's maps.
+    struct RedoTask {
+        TableInfo *table;
+        const std::vector<IndexInfo *> *indexes;
+        LogRecord record;
+    };
+
+    struct Worker {
+        std::mutex latch;
+        std::condition_variable cv;
+        std::deque<std::vector<RedoTask>> queue;
+        std::vector<RedoTask> batch;   // filled by the decoding thread, queued when full
+        bool busy = false;
+        bool stop = false;
+        std::thread thread;
+    };
+
+    // Apply a committed statement: catalog changes inline, row changes on the workers.
+    void Dispatch(LogRecord record);
+    void Submit(Worker *worker);
+    // Queue every partial batch and wait until all workers are idle.
+    void Drain();
+    void WorkerLoop(Worker *worker);
+    void Redo(const RedoTask &task);
+    void UpdateIndexes(TableInfo *table, const std::vector<IndexInfo *> &indexes, const std::string &old_data,
+                       const std::string &new_data, const RID &rid);
+    void IndexLoadedPage(TableInfo *table, const std::vector<IndexInfo *> &indexes, const LogRecord &record);
+
+    Catalog *catalog_;
+    DiskManager *disk_manager_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<LogRecord> pending_;
+    std::vector<LogRecord> deferred_indexes_;
+    lsn_t next_lsn_ = 1;
+    size_t record_count_ = 0;
+};
+
+} // namespace simpledb
@@ -1,44 +1,103 @@
 #pragma once
 #include <unordered_map>
+#include <unordered_set>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
 #include "storage/disk_manager.h"
+#include "storage/disk_scheduler.h"
 #include "storage/page.h"
+#include "storage/replacer.h"
 
 namespace simpledb {
 
-class BufferPoolManager {
+// One hash partition of the buffer pool. Each shard owns its frames, page table,
+// free list and replacer behind a single latch. Disk reads and write-backs run
+// with the latch released; the frame is marked io_pending meanwhile so other
+// threads wanting the same page wait on io_cv_ instead of issuing a second read.
+// A miss that evicts a dirty page overlaps the write-back with the read of the new page.
+// If either fails the call returns nullptr, and a victim that could not be written stays
+// cached and dirty.
+class BufferPoolShard {
 public:
-    BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
-    ~BufferPoolManager();
+    BufferPoolShard(size_t pool_size, DiskScheduler *disk_scheduler, ReplacerType replacer);
+    ~BufferPoolShard();
 
-    // Fetch a page; returns nullptr if it cannot be fetched
-    Page *FetchPage(page_id_t page_id);
-
-    // Unpin a page, indicating if it was modified (dirty)
+    Page *FetchPage(page_id_t page_id, AccessType access_type);
     bool UnpinPage(page_id_t page_id, bool is_dirty);
-
-    // Flush a page to disk
     bool FlushPage(page_id_t page_id);
+    Page *NewPage(page_id_t page_id);
 
-    // Create a new page in the buffer pool
-    Page *NewPage(page_id_t *page_id);
+    // Pin every dirty page and clear its dirty bit; each returned page must be passed
+    // back to EndFlush once its write has completed, saying whether it succeeded.
+    void BeginFlushAll(std::vector<Page *> *pages);
+    void EndFlush(Page *page, bool written);
 
 private:
-    bool FindVictim(frame_id_t *frame_id);
+    // Take a frame from the free list or the replacer. Called with latch_ held. The
+    // evicted page (if dirty) is recorded in writing_back_ and must be written by the caller.
+    bool AcquireFrame(frame_id_t *frame_id, page_id_t *evicted_page_id, bool *evicted_dirty);
+
+    // Drop one pin. Called with latch_ held. An unpinned frame becomes evictable, or goes
+    // back to the free list if a failed load left it without a page.
+    void ReleaseFrame(frame_id_t frame_id);
 
     size_t pool_size_;
+    DiskScheduler *disk_scheduler_;
     DiskManager *disk_manager_;
     Page *pages_;
 
+    std::mutex latch_;
+    std::condition_variable io_cv_;
     std::unordered_map<page_id_t, frame_id_t> page_table_;
+    std::unordered_set<page_id_t> writing_back_;
     std::list<frame_id_t> free_list_;
-    std::list<frame_id_t> eviction_list_;
-    
+    std::unique_ptr<Replacer> replacer_;
+
     struct FrameInfo {
         int pin_count = 0;
         bool is_dirty = false;
+        bool io_pending = false;
     };
     FrameInfo *frame_info_;
 };
 
+// Thread-safe page cache partitioned into shards by page id. Callers coordinate
+// access to page contents through the per-page reader/writer latch.
+class BufferPoolManager {
+public:
+    BufferPoolManager(size_t pool_size, DiskManager *disk_manager, ReplacerType replacer = DEFAULT_REPLACER,
+                      size_t num_shards = BUFFER_POOL_SHARDS);
+    ~BufferPoolManager();
+
+    // Fetch a page; returns nullptr if it cannot be fetched
+    Page *FetchPage(page_id_t page_id, AccessType access_type = AccessType::UNKNOWN);
+
+    // Unpin a page, indicating if it was modified (dirty)
+    bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+    // Flush a page to disk
+    bool FlushPage(page_id_t page_id);
+
+    // Create a new page in the buffer pool
+    Page *NewPage(page_id_t *page_id);
+
+    // Write every dirty page back, with all writes in flight at once; false if any write failed
+    bool FlushAllPages();
+
+    size_t GetPoolSize() const { return pool_size_; }
+
+private:
+    BufferPoolShard &ShardFor(page_id_t page_id) {
+        return *shards_[static_cast<uint32_t>(page_id) % shards_.size()];
+    }
+
+    size_t pool_size_;
+    DiskManager *disk_manager_;
+    std::unique_ptr<DiskScheduler> disk_scheduler_;
+    std::vector<std::unique_ptr<BufferPoolShard>> shards_;
+};
+
 } // namespace simpledb
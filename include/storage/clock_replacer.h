@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include "storage/replacer.h"
+
+namespace simpledb {
+
+// CLOCK (second chance) replacement. The hand clears reference bits as it sweeps and
+// evicts the first evictable frame whose bit is already clear. Scan accesses do not
+// set the bit, so pages read once by a sequential scan are the first to go.
+class ClockReplacer : public Replacer {
+public:
+    explicit ClockReplacer(size_t num_frames);
+
+    bool Victim(frame_id_t *frame_id) override;
+    void RecordAccess(frame_id_t frame_id, AccessType type) override;
+    void SetEvictable(frame_id_t frame_id, bool evictable) override;
+    void Remove(frame_id_t frame_id) override;
+    size_t Size() const override { return size_; }
+
+private:
+    struct FrameState {
+        bool present = false;
+        bool evictable = false;
+        bool referenced = false;
+    };
+
+    std::vector<FrameState> frames_;
+    size_t hand_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace simpledb
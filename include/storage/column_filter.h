@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace simpledb {
+
+enum class CompareOp { EQ, NE, LT, LE, GT, GE };
+
+// Instruction set a filter kernel runs on; the best one the CPU supports is picked at startup.
+enum class FilterKernel { SCALAR = 0, SSE2, AVX2 };
+
+FilterKernel BestFilterKernel();
+const char *FilterKernelName(FilterKernel kernel);
+
+// Words needed for a selection bitmap over n rows
+inline size_t BitmapWords(size_t n) { return (n + 63) / 64; }
+
+// Call f(i) for every set bit i of a selection bitmap of `words` words, in order.
+template <typename F>
+void ForEachSelected(const uint64_t *bitmap, size_t words, F f) {
+    for (size_t w = 0; w < words; ++w) {
+        for (uint64_t bits = bitmap[w]; bits != 0; bits &= bits - 1) {
+#if defined(__GNUC__)
+            f(w * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+#else
+            size_t bit = 0;
+            while (((bits >> bit) & 1) == 0) bit++;
+            f(w * 64 + bit);
+#endif
+        }
+    }
+}
+
+// Set bit i of bitmap (bit i % 64 of word i / 64) when data[i] <op> literal holds.
+// Bits past n are cleared.
+void FilterInt32(const int32_t *data, size_t n, CompareOp op, int32_t literal, uint64_t *bitmap,
+                 FilterKernel kernel = BestFilterKernel());
+
+// Same for a VARCHAR column stored as offsets (n + 1 entries) into chars; strings compare
+// bytewise.
+void FilterString(const uint32_t *offsets, const char *chars, size_t n, CompareOp op, std::string_view literal,
+                  uint64_t *bitmap);
+
+} // namespace simpledb
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "catalog/schema.h"
+#include "catalog/tuple.h"
+#include "common/rid.h"
+#include "storage/column_filter.h"
+#include "storage/table_heap.h"
+
+namespace simpledb {
+
+// Column-major copy of a table heap for scans. INTEGER columns are contiguous int32_t
+// arrays, so a filter over a column streams through memory instead of decoding every
+// tuple. A VARCHAR column with at most COLUMN_DICTIONARY_MAX_ENTRIES distinct values is
+// dictionary-encoded: each distinct value is stored once, the dictionary is in byte order,
+// and every row holds the int32_t code of its value, so comparisons against a literal run
+// on the codes with the integer kernels. Other VARCHAR columns are an offsets array into
+// one character buffer. The copy is rebuilt from the heap whenever the heap's version has
+// moved on since the last Refresh.
+class ColumnStore {
+public:
+    explicit ColumnStore(const Schema *schema);
+
+    // Rebuild from heap if it changed since the last call.
+    void Refresh(TableHeap *heap);
+
+    size_t GetRowCount() const { return rids_.size(); }
+    const RID &GetRID(size_t row) const { return rids_[row]; }
+
+    // Mark the rows whose col value satisfies <op> literal in bitmap (BitmapWords(rows) words).
+    // literal must match the column's type.
+    void Filter(uint32_t col, CompareOp op, const Value &literal, uint64_t *bitmap) const;
+
+    // Values of an INTEGER column, or codes of a dictionary-encoded one.
+    const int32_t *GetInts(uint32_t col) const { return columns_[col].ints.data(); }
+    std::string_view GetString(uint32_t col, size_t row) const {
+        const Column &column = columns_[col];
+        if (column.encoded) return column.dictionary[column.ints[row]].GetAsString();
+        return std::string_view(column.chars.data() + column.offsets[row], column.offsets[row + 1] - column.offsets[row]);
+    }
+
+    bool IsDictionaryEncoded(uint32_t col) const { return columns_[col].encoded; }
+
+    // Reassemble a row as a Tuple.
+    Tuple GetTuple(size_t row) const;
+
+private:
+    struct Column {
+        std::vector<int32_t> ints;      // INTEGER, or dictionary codes
+        std::vector<uint32_t> offsets;  // plain VARCHAR: row i spans chars[offsets[i], offsets[i + 1])
+        std::vector<char> chars;
+        bool encoded = false;
+        std::vector<Value> dictionary;  // encoded VARCHAR: code i stands for dictionary[i]
+    };
+
+    // Mark the rows of an encoded column whose value satisfies <op> literal.
+    void FilterDictionary(const Column &column, CompareOp op, std::string_view literal, uint64_t *bitmap) const;
+
+    const Schema *schema_;
+    std::vector<Column> columns_;
+    std::vector<RID> rids_;
+    uint64_t version_ = UINT64_MAX;
+};
+
+} // namespace simpledb
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "catalog/schema.h"
+#include "common/config.h"
+
+namespace simpledb {
+
+// Streams a CSV file into table page images for TableHeap::AppendPage. The file is read
+// in chunks of about LOAD_CHUNK_BYTES cut at row boundaries; worker threads parse each
+// chunk, check every field against the schema, serialize the rows straight into slotted
+// pages, and the finished batches are handed back in file order.
+//
+// Fields are separated by commas and may be wrapped in double quotes, with "" for a
+// literal quote. Blank lines are skipped, and so is a first line naming the columns.
+class CsvLoader {
+public:
+    struct Batch {
+        std::vector<char> pages;   // page_count page images, PAGE_SIZE bytes each
+        size_t page_count = 0;
+        size_t row_count = 0;
+
+        char *GetPage(size_t i) { return pages.data() + i * PAGE_SIZE; }
+    };
+    using BatchSink = std::function<bool(Batch &batch)>;
+
+    explicit CsvLoader(const Schema *schema, size_t num_threads = LOAD_THREADS);
+
+    // Parse path, passing each batch to sink in order. Stops at the first malformed row
+    // (reported with its line number), on a read error, or when sink returns false;
+    // batches already passed to sink stay with the caller.
+    bool Load(const std::string &path, const BatchSink &sink);
+
+private:
+    struct Chunk {
+        size_t seq;
+        size_t first_line;
+        std::string text;
+    };
+    struct Result {
+        bool ok = true;
+        std::string error;
+        Batch batch;
+    };
+
+    // Parse one chunk into result. Safe to call from several threads at once.
+    void ParseChunk(const Chunk &chunk, Result *result) const;
+
+    // True if the first count fields spell out the schema's column names.
+    bool IsHeader(const std::vector<std::string> &fields, size_t count) const;
+
+    const Schema *schema_;
+    size_t num_threads_;
+};
+
+} // namespace simpledb
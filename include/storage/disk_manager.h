@@ -1,31 +1,76 @@
 #pragma once
 #include <string>
-#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <unordered_set>
 #include "common/config.h"
 
 namespace simpledb {
 
+// Page-granular access to the database file through positional reads and writes on a
+// raw file descriptor, so concurrent I/O on different pages never contends for a shared
+// seek position. The file size is tracked in memory instead of being queried per read.
+// Page 0 is reserved for the database header written by checkpoints.
+//
+// With use_swap set, the database file only changes at a checkpoint: pages written in
+// between go to <db>.swap, and PublishSwap() copies them over atomically. A crash before
+// the copy is recorded leaves the last checkpoint's snapshot untouched; a crash during
+// the copy is finished when the file is next opened.
 class DiskManager {
 public:
-    DiskManager(const std::string &db_file);
+    DiskManager(const std::string &db_file, bool use_swap = false);
     ~DiskManager();
 
-    // Write a page to the database file.
-    void WritePage(page_id_t page_id, const char *page_data);
+    // Write a page to the database file. Returns false on an I/O error.
+    bool WritePage(page_id_t page_id, const char *page_data);
     
-    // Read a page from the database file.
-    void ReadPage(page_id_t page_id, char *page_data);
+    // Read a page from the database file; bytes past the end of the file read as zero,
+    // which is how pages that were allocated but never written come back.
+    bool ReadPage(page_id_t page_id, char *page_data);
     
     // Allocate a new page and return its page_id.
     page_id_t AllocatePage();
 
+    // Make sure page_id is never handed out by AllocatePage, e.g. because recovery rebuilt it.
+    void ReservePage(page_id_t page_id);
+
+    // Force written pages to stable storage.
+    bool Sync();
+
+    // Move every page written since the last publish into the database file, crash-safely.
+    // The caller must keep other I/O out while this runs. Returns the number of pages
+    // published, or -1 on failure.
+    int PublishSwap();
+
     // Size of the db file
     int GetNumPages() const;
 
+    // A fresh file name in the system's temporary directory, for scratch files such as the
+    // spill files of joins and sorts.
+    static std::string TempFileName(const std::string &prefix);
+
 private:
-    std::fstream db_io_;
+    bool ReadAt(int fd, char *data, size_t offset, size_t *bytes_read);
+    bool WriteAt(int fd, const char *data, size_t offset);
+
+    // Finish a publish that was interrupted by a crash, then clear the swap file.
+    void RecoverSwap();
+
+    int fd_ = -1;
+#ifdef _WIN32
+    std::mutex io_latch_;   // no pread/pwrite: lseek + read/write must not interleave
+#endif
     std::string file_name_;
-    page_id_t next_page_id_;
+    std::atomic<page_id_t> next_page_id_;
+    std::atomic<size_t> file_size_;
+
+    bool use_swap_;
+    int swap_fd_ = -1;
+    std::string swap_file_;
+    std::string manifest_file_;   // lists the swapped pages while a publish is in progress
+    std::shared_mutex swap_latch_;
+    std::unordered_set<page_id_t> swapped_;
 };
 
 } // namespace simpledb
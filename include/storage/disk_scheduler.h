@@ -0,0 +1,46 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "storage/disk_manager.h"
+
+namespace simpledb {
+
+// A single page read or write handed to the DiskScheduler. The buffer must stay valid,
+// and must not be touched by the caller, until the request's future completes.
+struct DiskRequest {
+    bool is_write;
+    page_id_t page_id;
+    char *data;
+    std::promise<bool> done;
+};
+
+// Asynchronous page I/O on a small pool of worker threads. Submit queues a request and
+// returns at once; the future completes (true on success) when the I/O has finished, so
+// a caller can keep several reads and writes in flight and wait for them together.
+class DiskScheduler {
+public:
+    // With zero workers every request runs inline on the submitting thread.
+    DiskScheduler(DiskManager *disk_manager, size_t num_workers = DISK_IO_THREADS);
+    ~DiskScheduler();
+
+    std::future<bool> Submit(bool is_write, page_id_t page_id, char *data);
+
+    DiskManager *GetDiskManager() const { return disk_manager_; }
+
+private:
+    void WorkerLoop();
+    bool Execute(const DiskRequest &request);
+
+    DiskManager *disk_manager_;
+    std::mutex latch_;
+    std::condition_variable cv_;
+    std::deque<DiskRequest> queue_;
+    bool stop_ = false;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace simpledb
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include "storage/replacer.h"
+
+namespace simpledb {
+
+// LRU-K replacement. The victim is the evictable frame whose K-th most recent access is
+// oldest, i.e. with the largest backward K-distance. Frames referenced fewer than K times
+// have an infinite distance and go first, earliest first access first. Scan accesses are
+// not counted, and frames only ever scanned go before all others, so sequential scans
+// cannot displace hot index or lookup pages. Frames sit in a binary heap in that order;
+// a pinned frame stays in it until it reaches the top, so pinning and unpinning a cached
+// page is constant-time, and accesses and victims cost O(log n) in the frames of a shard.
+class LRUKReplacer : public Replacer {
+public:
+    LRUKReplacer(size_t num_frames, size_t k);
+
+    bool Victim(frame_id_t *frame_id) override;
+    void RecordAccess(frame_id_t frame_id, AccessType type) override;
+    void SetEvictable(frame_id_t frame_id, bool evictable) override;
+    void Remove(frame_id_t frame_id) override;
+    size_t Size() const override { return size_; }
+
+private:
+    struct FrameState {
+        size_t access_count = 0;    // accesses other than scans
+        uint64_t first_access = 0;  // of any kind; 0 while untracked
+        bool evictable = false;
+        int32_t heap_index = -1;
+    };
+
+    // True if frame a should be evicted before frame b.
+    bool EvictsBefore(frame_id_t a, frame_id_t b) const;
+
+    void HeapPush(frame_id_t frame_id);
+    void HeapErase(frame_id_t frame_id);
+    void SiftUp(size_t index);
+    void SiftDown(size_t index);
+    void Place(size_t index, frame_id_t frame_id);
+
+    size_t k_;
+    uint64_t now_ = 0;
+    std::vector<FrameState> frames_;
+    std::vector<uint64_t> history_;     // per frame, a ring of its last k_ counted access times
+    std::vector<frame_id_t> heap_;     // every evictable frame, and some pinned ones
+    size_t size_ = 0;
+};
+
+} // namespace simpledb
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstring>
+#include <shared_mutex>
 #include "common/config.h"
 
 namespace simpledb {
@@ -14,9 +15,16 @@ public:
     inline void SetPageId(page_id_t page_id) { page_id_ = page_id; }
     inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
 
+    // Reader/writer latch guarding the page contents while it is pinned
+    inline void RLatch() { rwlatch_.lock_shared(); }
+    inline void RUnlatch() { rwlatch_.unlock_shared(); }
+    inline void WLatch() { rwlatch_.lock(); }
+    inline void WUnlatch() { rwlatch_.unlock(); }
+
 private:
     char data_[PAGE_SIZE]{};
     page_id_t page_id_ = INVALID_PAGE_ID;
+    std::shared_mutex rwlatch_;
 };
 
 } // namespace simpledb
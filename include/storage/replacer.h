@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include "common/config.h"
+
+namespace simpledb {
+
+// How a page is being touched. Sequential scans report SCAN so replacers can keep
+// one-pass reads from flushing pages that are accessed repeatedly.
+enum class AccessType { UNKNOWN = 0, LOOKUP, SCAN, INDEX };
+
+// Replacement policy for buffer pool frames. Only frames marked evictable
+// (unpinned) may be chosen as victims.
+class Replacer {
+public:
+    virtual ~Replacer() = default;
+
+    // Pick a frame to evict and stop tracking it. Returns false if nothing is evictable.
+    virtual bool Victim(frame_id_t *frame_id) = 0;
+
+    // Note an access to a frame that now holds (or just loaded) a page.
+    virtual void RecordAccess(frame_id_t frame_id, AccessType type) = 0;
+
+    virtual void SetEvictable(frame_id_t frame_id, bool evictable) = 0;
+
+    // Forget a frame entirely, e.g. when its page is dropped from the pool.
+    virtual void Remove(frame_id_t frame_id) = 0;
+
+    // Number of evictable frames.
+    virtual size_t Size() const = 0;
+};
+
+} // namespace simpledb
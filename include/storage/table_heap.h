@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <set>
+#include <string>
+#include "catalog/schema.h"
+#include "catalog/tuple.h"
+#include "common/arena.h"
+#include "common/rid.h"
+#include "recovery/log_manager.h"
+#include "storage/buffer_pool_manager.h"
+
+namespace simpledb {
+
+class TableIterator;
+
+// A table stored as a singly linked list of slotted pages in the buffer pool.
+// Pages are pinned only for the duration of a single call and accessed under their
+// page latch, so readers and writers on different threads may share a heap.
+// With a LogManager attached, every page change is logged as a physical record and
+// the page is stamped with its LSN; the Redo* methods apply those records again.
+class TableHeap {
+public:
+    // Create a new, empty heap starting on a freshly allocated page.
+    TableHeap(BufferPoolManager *bpm, const Schema *schema, table_oid_t table_oid, LogManager *log_manager);
+
+    // Open an existing heap rooted at first_page_id. During recovery first_page_id may be
+    // invalid until the heap's first NEW_PAGE record is redone.
+    TableHeap(BufferPoolManager *bpm, const Schema *schema, table_oid_t table_oid, page_id_t first_page_id);
+
+    void SetLogManager(LogManager *log_manager) { log_manager_ = log_manager; }
+
+    bool InsertTuple(const Tuple &tuple, RID *rid);
+
+    // Insert a batch of tuples, filling the last page before chaining new ones. Each page
+    // the batch lands on gets one INSERT_BATCH log record. rids[i] receives the rid of
+    // tuples[i]. The tuples are serialized into scratch, or into an arena of the call's own
+    // when none is given.
+    bool InsertTuples(const std::vector<Tuple> &tuples, RID *rids, Arena *scratch = nullptr);
+
+    bool DeleteTuple(const RID &rid);
+
+    // Delete many tuples, visiting each page once for a run of rids on the same page.
+    // deleted (if given) reports which rids were live. Returns the number deleted.
+    size_t DeleteTuples(const std::vector<RID> &rids, std::vector<bool> *deleted = nullptr);
+
+    // Update in place when the page has room, otherwise move the tuple; rid is updated on a move.
+    bool UpdateTuple(const Tuple &tuple, RID *rid);
+
+    bool GetTuple(const RID &rid, Tuple *tuple);
+
+    // The page that follows page_id in the heap, or INVALID_PAGE_ID after the last page.
+    page_id_t GetNextPageId(page_id_t page_id);
+
+    // Decode the live tuples of one page, appending them to rids and tuples. Returns the
+    // page that follows it in the heap, or INVALID_PAGE_ID after the last page.
+    page_id_t ScanPage(page_id_t page_id, std::vector<RID> *rids, std::vector<Tuple> *tuples);
+
+    // Chain a filled page, built outside the buffer pool, onto the end of the heap and log it
+    // as a single record. Its tuples get rids (*page_id, 0), (*page_id, 1), ...
+    bool AppendPage(const char *image, page_id_t *page_id);
+
+    page_id_t GetFirstPageId() const { return first_page_id_; }
+
+    // Compact up to max_pages of the pages that deletes and updates have left garbage on
+    // since they were last compacted. Returns the number of pages compacted.
+    size_t VacuumStep(size_t max_pages, size_t *bytes_reclaimed = nullptr);
+
+    // Compact every page of the heap that has anything to reclaim.
+    size_t VacuumAll(size_t *bytes_reclaimed = nullptr);
+
+    // True if VacuumStep has pages waiting.
+    bool NeedsVacuum();
+
+    // Bumped by every change to a row, so copies of the heap can tell they are stale.
+    uint64_t GetVersion() const { return version_.load(); }
+
+    // Redo a logged change. Each is skipped if the page already reflects lsn. *applied
+    // (if given) reports whether the page changed, and old_data receives the replaced
+    // tuple so the caller can maintain indexes.
+    // image holds the contents of a page appended by a bulk load; other new pages start empty.
+    bool RedoVacuumPage(page_id_t page_id, lsn_t lsn);
+    bool RedoNewPage(page_id_t prev_page_id, page_id_t page_id, lsn_t lsn, const char *image = nullptr,
+                     bool *applied = nullptr);
+    bool RedoInsert(const RID &rid, const std::string &tuple_data, lsn_t lsn, bool *applied = nullptr);
+    bool RedoInsertBatch(page_id_t page_id, const std::vector<std::pair<uint32_t, std::string>> &tuples, lsn_t lsn,
+                         bool *applied = nullptr);
+    bool RedoDelete(const RID &rid, lsn_t lsn, bool *applied = nullptr, std::string *old_data = nullptr);
+    bool RedoUpdate(const RID &rid, const std::string &tuple_data, lsn_t lsn, bool *applied = nullptr,
+                    std::string *old_data = nullptr);
+
+    TableIterator Begin();
+    TableIterator End();
+
+private:
+    friend class TableIterator;
+
+    // Chain a fresh page after last, which is pinned and write-latched and is released here.
+    // Returns the new last page, pinned and write-latched, or nullptr if none could be allocated.
+    Page *ChainNewPage(Page *last);
+
+    // Compact one page if it has space to reclaim, logging it as a VACUUM_PAGE record.
+    // next_page_id (if given) receives the page's successor in the heap.
+    bool CompactPage(page_id_t page_id, size_t *bytes_reclaimed, page_id_t *next_page_id = nullptr);
+    void MarkForVacuum(page_id_t page_id);
+
+    // Append record to the log (if any) and stamp page with its LSN. Called with the page write-latched.
+    lsn_t LogChange(Page *page, const LogRecord &record);
+
+    BufferPoolManager *bpm_;
+    const Schema *schema_;
+    table_oid_t table_oid_;
+    LogManager *log_manager_ = nullptr;
+    page_id_t first_page_id_;
+    page_id_t last_page_id_;
+    std::mutex append_latch_;
+    std::string batch_log_;   // INSERT_BATCH payload being built, under append_latch_
+    std::atomic<uint64_t> version_{0};
+
+    std::mutex vacuum_latch_;
+    std::set<page_id_t> vacuum_pages_;   // pages holding tombstones or shrunk tuples
+};
+
+// Forward iterator over every live tuple. Tuples are decoded one page at a time,
+// so the heap may be modified between steps without invalidating the iterator.
+class TableIterator {
+public:
+    TableIterator(TableHeap *heap, page_id_t page_id);
+
+    const Tuple &operator*() const { return page_tuples_[pos_].second; }
+    const Tuple *operator->() const { return &page_tuples_[pos_].second; }
+    const RID &GetRID() const { return page_tuples_[pos_].first; }
+
+    TableIterator &operator++();
+
+    bool operator==(const TableIterator &other) const {
+        return page_id_ == other.page_id_ && pos_ == other.pos_;
+    }
+    bool operator!=(const TableIterator &other) const { return !(*this == other); }
+
+private:
+    // Decode page_id_ into page_tuples_, skipping forward past empty pages.
+    void LoadPage();
+
+    TableHeap *heap_;
+    page_id_t page_id_;
+    page_id_t next_page_id_ = INVALID_PAGE_ID;
+    size_t pos_ = 0;
+    std::vector<std::pair<RID, Tuple>> page_tuples_;
+};
+
+} // namespace simpledb
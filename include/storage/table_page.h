@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include "common/config.h"
+#include "storage/page.h"
+
+namespace simpledb {
+
+// Slotted page view over a buffer pool Page.
+//
+//  | next_page_id | free_space_ptr | slot_count | lsn | slot[0] | slot[1] | ... free ... | tuple data |
+//
+// The slot directory grows forward from the header while tuple data grows backward
+// from the end of the page. A slot with size 0 is empty and may be reused. A deleted
+// tuple keeps its bytes and is only marked as a tombstone; Compact later squeezes out
+// tombstones and the leftovers of shrunk updates. lsn is the last log record applied to
+// the page, which makes redo idempotent.
+class TablePage {
+public:
+    explicit TablePage(Page *page) : data_(page->GetData()) {}
+    // View over a page image held outside the buffer pool, e.g. one built by a bulk load.
+    explicit TablePage(char *data) : data_(data) {}
+
+    void Init(page_id_t next_page_id = INVALID_PAGE_ID);
+
+    page_id_t GetNextPageId() const;
+    void SetNextPageId(page_id_t next_page_id);
+    uint32_t GetSlotCount() const;
+
+    lsn_t GetLSN() const;
+    void SetLSN(lsn_t lsn);
+
+    // Copy tuple bytes into the page, returning the chosen slot. Fails if there is no room.
+    bool InsertTuple(const char *tuple_data, uint32_t size, uint32_t *slot_num);
+
+    // Store a tuple under a specific slot, as recorded in the log. Fails if the slot is taken
+    // or there is no room.
+    bool InsertTupleAt(uint32_t slot_num, const char *tuple_data, uint32_t size);
+
+    // Mark the tuple as a tombstone. Its bytes and slot are reclaimed by Compact.
+    bool DeleteTuple(uint32_t slot_num);
+
+    // Replace the tuple, keeping its slot. A larger image compacts the page first if it has
+    // to; fails if even that leaves too little room.
+    bool UpdateTuple(uint32_t slot_num, const char *tuple_data, uint32_t size);
+
+    // Bytes that Compact would give back: tombstones and unused parts of the data region.
+    uint32_t GetReclaimableSpace() const;
+
+    // Rewrite the data region with only live tuples, keeping their slot numbers. Tombstoned
+    // slots become empty and reusable.
+    void Compact();
+
+    // Returns nullptr for an empty or out of range slot.
+    const char *GetTuple(uint32_t slot_num, uint32_t *size) const;
+
+    uint32_t GetFreeSpace() const;
+
+    // Largest tuple that can ever be stored on an empty page.
+    static constexpr uint32_t MAX_TUPLE_SIZE = PAGE_SIZE - 20 - 8;
+
+private:
+    static constexpr uint32_t OFFSET_NEXT_PAGE_ID = 0;
+    static constexpr uint32_t OFFSET_FREE_SPACE = 4;
+    static constexpr uint32_t OFFSET_SLOT_COUNT = 8;
+    static constexpr uint32_t OFFSET_LSN = 12;
+    static constexpr uint32_t HEADER_SIZE = 20;
+    static constexpr uint32_t SLOT_SIZE = 8;
+    static constexpr uint32_t TOMBSTONE = 1u << 31;   // set in a slot's size once deleted
+
+    uint32_t GetFreeSpacePtr() const;
+    void SetFreeSpacePtr(uint32_t ptr);
+    void SetSlotCount(uint32_t count);
+    uint32_t GetSlotOffset(uint32_t slot_num) const;
+    uint32_t GetSlotSize(uint32_t slot_num) const;
+    void SetSlot(uint32_t slot_num, uint32_t offset, uint32_t size);
+
+    char *data_;
+};
+
+} // namespace simpledb
@@ -0,0 +1,39 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include "catalog/catalog.h"
+#include "recovery/log_manager.h"
+
+namespace simpledb {
+
+// Reclaims the space deletes and updates leave on table pages, a bounded number of pages
+// at a time. A step holds the statement latch exclusively, so its VACUUM_PAGE records
+// never interleave with a statement's, and commits them as a group of their own.
+class VacuumManager {
+public:
+    VacuumManager(Catalog *catalog, LogManager *log_manager, std::shared_mutex *statement_latch);
+    ~VacuumManager();
+
+    // Compact up to max_pages pages, visiting tables in turn. Returns the pages compacted.
+    size_t Step(size_t max_pages = VACUUM_PAGES_PER_STEP);
+
+    // Run a step from a background thread every VACUUM_POLL_MS.
+    void StartBackground(size_t pages_per_step = VACUUM_PAGES_PER_STEP);
+
+private:
+    void BackgroundLoop(size_t pages_per_step);
+
+    Catalog *catalog_;
+    LogManager *log_manager_;
+    std::shared_mutex *statement_latch_;
+    size_t next_table_ = 0;   // where the next step starts, so no table is starved
+
+    std::mutex background_latch_;
+    std::condition_variable background_cv_;
+    bool stop_ = false;
+    std::thread background_thread_;
+};
+
+} // namespace simpledb
@@ -0,0 +1,167 @@
+#include "catalog/table_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "execution/hash_util.h"
+
+namespace simpledb {
+
+namespace {
+
+// Order of two values of the same column type.
+int CompareStat(const Value &a, const Value &b) {
+    if (a.GetTypeId() == TypeId::INTEGER) {
+        return a.GetAsInt() < b.GetAsInt() ? -1 : (a.GetAsInt() > b.GetAsInt() ? 1 : 0);
+    }
+    return a.GetAsString().compare(b.GetAsString());
+}
+
+bool LessStat(const Value &a, const Value &b) { return CompareStat(a, b) < 0; }
+
+// Where x falls between lo and hi, from 0 to 1. Strings are taken to sit halfway.
+double Interpolate(const Value &lo, const Value &hi, const Value &x) {
+    if (x.GetTypeId() != TypeId::INTEGER) return 0.5;
+    double low = lo.GetAsInt(), high = hi.GetAsInt();
+    if (high <= low) return 1.0;
+    return std::clamp((x.GetAsInt() - low) / (high - low), 0.0, 1.0);
+}
+
+} // namespace
+
+void HyperLogLog::Add(uint64_t hash) {
+    size_t index = hash >> (64 - STATS_HLL_PRECISION);
+    uint64_t rest = hash << STATS_HLL_PRECISION;
+    uint8_t rank;
+    if (rest == 0) {
+        rank = 64 - STATS_HLL_PRECISION + 1;
+    } else {
+#if defined(__GNUC__)
+        rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+#else
+        rank = 1;
+        while ((rest & (uint64_t{1} << 63)) == 0) {
+            rest <<= 1;
+            rank++;
+        }
+#endif
+    }
+    registers_[index] = std::max(registers_[index], rank);
+}
+
+double HyperLogLog::Estimate() const {
+    double m = static_cast<double>(registers_.size());
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : registers_) {
+        sum += std::ldexp(1.0, -r);
+        if (r == 0) zeros++;
+    }
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    // Few values: count the registers still empty instead (linear counting).
+    if (estimate <= 2.5 * m && zeros > 0) estimate = m * std::log(m / static_cast<double>(zeros));
+    return estimate;
+}
+
+std::unique_ptr<TableStats> TableStats::Analyze(TableHeap *heap, const Schema *schema) {
+    auto stats = std::make_unique<TableStats>(schema->GetColumnCount());
+
+    // Reservoir sample, seeded so that analyzing the same rows gives the same histograms.
+    std::vector<Tuple> sample;
+    std::mt19937_64 rng(HASH_SEED);
+    for (auto it = heap->Begin(); it != heap->End(); ++it) {
+        stats->RecordInsert(*it);
+        if (sample.size() < STATS_SAMPLE_ROWS) {
+            sample.push_back(*it);
+        } else {
+            uint64_t slot = rng() % stats->row_count_;
+            if (slot < STATS_SAMPLE_ROWS) sample[slot] = *it;
+        }
+    }
+
+    for (uint32_t col = 0; col < schema->GetColumnCount(); ++col) {
+        std::vector<Value> values;
+        values.reserve(sample.size());
+        for (const Tuple &tuple : sample) values.push_back(tuple.GetValue(schema, col));
+        std::sort(values.begin(), values.end(), LessStat);
+        size_t buckets = std::min(STATS_HISTOGRAM_BUCKETS, values.size());
+        std::vector<Value> &bounds = stats->columns_[col].bounds;
+        for (size_t i = 0; i < buckets; ++i) bounds.push_back(values[(i + 1) * values.size() / buckets - 1]);
+    }
+
+    for (page_id_t page_id = heap->GetFirstPageId(); page_id != INVALID_PAGE_ID; page_id = heap->GetNextPageId(page_id)) {
+        stats->analyzed_pages_++;
+    }
+    stats->analyzed_rows_ = stats->row_count_;
+    return stats;
+}
+
+void TableStats::RecordInsert(const Tuple &tuple) {
+    row_count_++;
+    const std::vector<Value> &values = tuple.GetValues();
+    for (uint32_t col = 0; col < columns_.size() && col < values.size(); ++col) RecordUpdate(col, values[col]);
+}
+
+void TableStats::RecordDelete(size_t rows) { row_count_ -= std::min<uint64_t>(rows, row_count_); }
+
+void TableStats::RecordUpdate(uint32_t col, const Value &value) {
+    ColumnStats &column = columns_[col];
+    column.sketch.Add(HashValue(value));
+    if (column.min.GetTypeId() == TypeId::INVALID || LessStat(value, column.min)) column.min = value;
+    if (column.max.GetTypeId() == TypeId::INVALID || LessStat(column.max, value)) column.max = value;
+}
+
+uint64_t TableStats::GetPageCount() const {
+    if (analyzed_rows_ == 0) return std::max<uint64_t>(analyzed_pages_, 1);
+    return std::max<uint64_t>((row_count_ * analyzed_pages_ + analyzed_rows_ - 1) / analyzed_rows_, 1);
+}
+
+uint64_t TableStats::GetDistinctCount(uint32_t col) const {
+    if (row_count_ == 0) return 0;
+    uint64_t estimate = static_cast<uint64_t>(std::llround(columns_[col].sketch.Estimate()));
+    return std::clamp<uint64_t>(estimate, 1, row_count_);
+}
+
+double TableStats::EstimateSelectivity(uint32_t col, CompareOp op, const Value &literal) const {
+    if (row_count_ == 0) return 0;
+    double equal = EqualFraction(col, literal);
+    double less = LessFraction(col, literal);
+    double fraction = 0;
+    switch (op) {
+    case CompareOp::EQ: fraction = equal; break;
+    case CompareOp::NE: fraction = 1 - equal; break;
+    case CompareOp::LT: fraction = less; break;
+    case CompareOp::LE: fraction = less + equal; break;
+    case CompareOp::GT: fraction = 1 - less - equal; break;
+    case CompareOp::GE: fraction = 1 - less; break;
+    }
+    return std::clamp(fraction, 0.0, 1.0);
+}
+
+double TableStats::EqualFraction(uint32_t col, const Value &literal) const {
+    const ColumnStats &column = columns_[col];
+    if (LessStat(literal, column.min) || LessStat(column.max, literal)) return 0;
+    double fraction = 1.0 / static_cast<double>(GetDistinctCount(col));
+    // A value that ends several buckets is common; it takes about that many buckets' rows.
+    if (!column.bounds.empty()) {
+        auto range = std::equal_range(column.bounds.begin(), column.bounds.end(), literal, LessStat);
+        double share = static_cast<double>(range.second - range.first) / static_cast<double>(column.bounds.size());
+        fraction = std::max(fraction, share);
+    }
+    return std::min(fraction, 1.0);
+}
+
+double TableStats::LessFraction(uint32_t col, const Value &literal) const {
+    const ColumnStats &column = columns_[col];
+    if (!LessStat(column.min, literal)) return 0;
+    if (LessStat(column.max, literal)) return 1;
+    const std::vector<Value> &bounds = column.bounds;
+    // No histogram (the rows all came after analyze): assume values spread evenly.
+    if (bounds.empty()) return Interpolate(column.min, column.max, literal);
+    size_t bucket = std::lower_bound(bounds.begin(), bounds.end(), literal, LessStat) - bounds.begin();
+    if (bucket == bounds.size()) return 1;
+    const Value &low = bucket == 0 ? column.min : bounds[bucket - 1];
+    double within = Interpolate(low, bounds[bucket], literal);
+    return (static_cast<double>(bucket) + within) / static_cast<double>(bounds.size());
+}
+
+} // namespace simpledb
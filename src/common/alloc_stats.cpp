@@ -0,0 +1,81 @@
+#include "common/alloc_stats.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "common/config.h"
+
+namespace simpledb {
+
+namespace {
+
+// Each thread counts into a slot of its own, on its own cache line, so counting never
+// moves a line between cores. Threads beyond the last slot share it.
+struct alignas(64) AllocCounters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> frees{0};
+};
+
+AllocCounters slots[ALLOC_STATS_SLOTS];
+std::atomic<size_t> next_slot{0};
+std::atomic<bool> counting{false};
+thread_local AllocCounters *thread_slot = nullptr;
+
+AllocCounters &ThreadSlot() {
+    if (thread_slot == nullptr) {
+        size_t slot = std::min(next_slot.fetch_add(1, std::memory_order_relaxed), ALLOC_STATS_SLOTS - 1);
+        thread_slot = &slots[slot];
+    }
+    return *thread_slot;
+}
+
+void *CountedAlloc(std::size_t size) noexcept {
+    if (counting.load(std::memory_order_relaxed)) {
+        AllocCounters &counters = ThreadSlot();
+        counters.allocations.fetch_add(1, std::memory_order_relaxed);
+        counters.bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void CountedFree(void *ptr) noexcept {
+    if (ptr == nullptr) return;
+    if (counting.load(std::memory_order_relaxed)) ThreadSlot().frees.fetch_add(1, std::memory_order_relaxed);
+    std::free(ptr);
+}
+
+} // namespace
+
+void SetAllocCounting(bool on) { counting.store(on, std::memory_order_relaxed); }
+
+AllocStats GetAllocStats() {
+    AllocStats stats;
+    size_t used = std::min(next_slot.load(std::memory_order_relaxed), ALLOC_STATS_SLOTS);
+    for (size_t i = 0; i < used; ++i) {
+        stats.allocations += slots[i].allocations.load(std::memory_order_relaxed);
+        stats.bytes += slots[i].bytes.load(std::memory_order_relaxed);
+        stats.frees += slots[i].frees.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+} // namespace simpledb
+
+// The replacements only take effect in programs that link this file in, i.e. that call
+// GetAllocStats.
+void *operator new(std::size_t size) {
+    void *ptr = simpledb::CountedAlloc(size);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return simpledb::CountedAlloc(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return simpledb::CountedAlloc(size); }
+
+void operator delete(void *ptr) noexcept { simpledb::CountedFree(ptr); }
+void operator delete[](void *ptr) noexcept { simpledb::CountedFree(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { simpledb::CountedFree(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { simpledb::CountedFree(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { simpledb::CountedFree(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { simpledb::CountedFree(ptr); }
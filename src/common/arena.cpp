@@ -0,0 +1,42 @@
+#include "common/arena.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace simpledb {
+
+void *Arena::Allocate(size_t size, size_t align) {
+    auto aligned = [align](char *p) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char *>((address + align - 1) & ~static_cast<uintptr_t>(align - 1));
+    };
+    char *start = aligned(pos_);
+    if (pos_ == nullptr || start > end_ || static_cast<size_t>(end_ - start) < size) {
+        AddChunk(size + align);
+        start = aligned(pos_);
+    }
+    pos_ = start + size;
+    used_ += size;
+    return start;
+}
+
+void Arena::Reset() {
+    if (chunks_.size() > 1 || reserved_ > ARENA_RETAINED_BYTES) {
+        size_t keep = std::min(reserved_, ARENA_RETAINED_BYTES);
+        chunks_.clear();
+        reserved_ = 0;
+        AddChunk(keep);
+    }
+    pos_ = chunks_.empty() ? nullptr : chunks_[0].first.get();
+    end_ = chunks_.empty() ? nullptr : pos_ + chunks_[0].second;
+    used_ = 0;
+}
+
+void Arena::AddChunk(size_t min_size) {
+    size_t size = std::max(chunk_size_, min_size);
+    chunks_.emplace_back(std::unique_ptr<char[]>(new char[size]), size);
+    reserved_ += size;
+    pos_ = chunks_.back().first.get();
+    end_ = pos_ + size;
+}
+
+} // namespace simpledb
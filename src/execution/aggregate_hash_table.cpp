@@ -0,0 +1,152 @@
+#include "execution/aggregate_hash_table.h"
+#include "execution/hash_util.h"
+#include <algorithm>
+#include <climits>
+#include <iomanip>
+#include <sstream>
+
+namespace simpledb {
+
+namespace {
+
+// Integers order numerically, strings bytewise.
+bool Less(const Value &a, const Value &b) {
+    if (a.GetTypeId() != b.GetTypeId()) return a.GetTypeId() < b.GetTypeId();
+    if (a.GetTypeId() == TypeId::INTEGER) return a.GetAsInt() < b.GetAsInt();
+    return a.GetAsString() < b.GetAsString();
+}
+
+// Value holds 32-bit integers; larger results are returned as their decimal text.
+Value IntegerResult(int64_t v) {
+    if (v >= INT32_MIN && v <= INT32_MAX) return Value(static_cast<int32_t>(v));
+    return Value(std::to_string(v));
+}
+
+} // namespace
+
+AggregateHashTable::AggregateHashTable(std::vector<int32_t> group_by, std::vector<AggregateExpr> aggregates)
+    : group_by_(std::move(group_by)), aggregates_(std::move(aggregates)), slots_(16) {}
+
+template <typename KeyAt>
+size_t AggregateHashTable::FindOrInsert(uint64_t hash, KeyAt key_at) {
+    if ((group_hashes_.size() + 1) * 2 > slots_.size()) Grow();
+    const size_t key_count = group_by_.size();
+    const size_t mask = slots_.size() - 1;
+    const uint32_t tag = static_cast<uint32_t>(hash >> 32);
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        Slot &slot = slots_[i];
+        if (slot.group == EMPTY) {
+            slot.tag = tag;
+            slot.group = static_cast<uint32_t>(group_hashes_.size());
+            group_hashes_.push_back(hash);
+            for (size_t k = 0; k < key_count; ++k) keys_.push_back(key_at(k));
+            accumulators_.resize(accumulators_.size() + aggregates_.size());
+            return slot.group;
+        }
+        if (slot.tag != tag || group_hashes_[slot.group] != hash) continue;
+        const Value *keys = keys_.data() + slot.group * key_count;
+        size_t k = 0;
+        while (k < key_count && keys[k] == key_at(k)) k++;
+        if (k == key_count) return slot.group;
+    }
+}
+
+void AggregateHashTable::Grow() {
+    std::vector<Slot> slots(slots_.size() * 2);
+    const size_t mask = slots.size() - 1;
+    for (size_t group = 0; group < group_hashes_.size(); ++group) {
+        uint64_t hash = group_hashes_[group];
+        size_t i = hash & mask;
+        while (slots[i].group != EMPTY) i = (i + 1) & mask;
+        slots[i].tag = static_cast<uint32_t>(hash >> 32);
+        slots[i].group = static_cast<uint32_t>(group);
+    }
+    slots_.swap(slots);
+}
+
+void AggregateHashTable::Update(const Tuple &tuple) {
+    const std::vector<Value> &values = tuple.GetValues();
+    uint64_t hash = HASH_SEED;
+    for (int32_t col : group_by_) hash = HashValue(values[col], hash);
+    size_t group = FindOrInsert(hash, [&](size_t k) -> const Value & { return values[group_by_[k]]; });
+
+    Accumulator *acc = accumulators_.data() + group * aggregates_.size();
+    for (const AggregateExpr &agg : aggregates_) {
+        switch (agg.type) {
+            case AggregateType::COUNT: break;
+            case AggregateType::SUM:
+            case AggregateType::AVG: acc->sum += values[agg.col].GetAsInt(); break;
+            case AggregateType::MIN:
+                if (acc->count == 0 || Less(values[agg.col], acc->extreme)) acc->extreme = values[agg.col];
+                break;
+            case AggregateType::MAX:
+                if (acc->count == 0 || Less(acc->extreme, values[agg.col])) acc->extreme = values[agg.col];
+                break;
+        }
+        acc->count++;
+        acc++;
+    }
+}
+
+void AggregateHashTable::Merge(const AggregateHashTable &other) {
+    const size_t key_count = group_by_.size();
+    const size_t agg_count = aggregates_.size();
+    for (size_t from = 0; from < other.GetGroupCount(); ++from) {
+        const Value *keys = other.keys_.data() + from * key_count;
+        size_t group = FindOrInsert(other.group_hashes_[from], [&](size_t k) -> const Value & { return keys[k]; });
+        for (size_t i = 0; i < agg_count; ++i) {
+            Accumulator &acc = accumulators_[group * agg_count + i];
+            const Accumulator &part = other.accumulators_[from * agg_count + i];
+            if (part.count == 0) continue;
+            bool replace = (aggregates_[i].type == AggregateType::MIN && Less(part.extreme, acc.extreme)) ||
+                           (aggregates_[i].type == AggregateType::MAX && Less(acc.extreme, part.extreme));
+            if (acc.count == 0 || replace) acc.extreme = part.extreme;
+            acc.count += part.count;
+            acc.sum += part.sum;
+        }
+    }
+}
+
+void AggregateHashTable::EnsureEmptyKeyGroup() {
+    if (!group_by_.empty()) return;
+    FindOrInsert(HASH_SEED, [&](size_t) -> const Value & { return keys_.front(); });
+}
+
+std::vector<size_t> AggregateHashTable::SortedGroups() const {
+    const size_t key_count = group_by_.size();
+    std::vector<size_t> groups(GetGroupCount());
+    for (size_t i = 0; i < groups.size(); ++i) groups[i] = i;
+    std::sort(groups.begin(), groups.end(), [&](size_t a, size_t b) {
+        const Value *ka = keys_.data() + a * key_count;
+        const Value *kb = keys_.data() + b * key_count;
+        return std::lexicographical_compare(ka, ka + key_count, kb, kb + key_count, Less);
+    });
+    return groups;
+}
+
+Tuple AggregateHashTable::GetRow(size_t group) const {
+    const size_t key_count = group_by_.size();
+    std::vector<Value> row(keys_.begin() + group * key_count, keys_.begin() + (group + 1) * key_count);
+    const Accumulator *acc = accumulators_.data() + group * aggregates_.size();
+    for (const AggregateExpr &agg : aggregates_) {
+        switch (agg.type) {
+            case AggregateType::COUNT: row.push_back(IntegerResult(acc->count)); break;
+            case AggregateType::SUM: row.push_back(acc->count == 0 ? Value() : IntegerResult(acc->sum)); break;
+            case AggregateType::MIN:
+            case AggregateType::MAX: row.push_back(acc->extreme); break;
+            case AggregateType::AVG:
+                if (acc->count == 0) {
+                    row.emplace_back();
+                } else {
+                    std::ostringstream out;
+                    out << std::setprecision(15) << static_cast<double>(acc->sum) / static_cast<double>(acc->count);
+                    row.emplace_back(out.str());
+                }
+                break;
+        }
+        acc++;
+    }
+    return Tuple(std::move(row));
+}
+
+} // namespace simpledb
@@ -0,0 +1,509 @@
+#include "execution/executor.h"
+#include "storage/column_store.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <iterator>
+#include <mutex>
+
+namespace simpledb {
+
+namespace {
+
+// Set every bit of a selection over rows rows.
+void SelectAll(uint64_t *selection, size_t rows) {
+    size_t words = BitmapWords(rows);
+    std::fill(selection, selection + words, ~uint64_t{0});
+    if (rows % 64 != 0) selection[words - 1] = (uint64_t{1} << (rows % 64)) - 1;
+}
+
+// Evaluate cond over a column store into selection.
+void FilterCondition(const ColumnStore &store, const Schema &schema, const Condition &cond, uint64_t *selection) {
+    size_t words = BitmapWords(store.GetRowCount());
+    uint32_t col = static_cast<uint32_t>(cond.col_idx);
+    if (schema.GetColumn(col).GetType() == TypeId::INTEGER) {
+        // A literal like "007" or "x" equals no integer, so = selects nothing and != everything.
+        if ((cond.op == CompareOp::EQ || cond.op == CompareOp::NE) && !cond.int_exact) {
+            if (cond.op == CompareOp::EQ) std::fill(selection, selection + words, 0);
+            else SelectAll(selection, store.GetRowCount());
+            return;
+        }
+        store.Filter(col, cond.op, Value(cond.int_literal), selection);
+        return;
+    }
+    if (cond.op != CompareOp::EQ && cond.op != CompareOp::NE) {
+        store.Filter(col, cond.op, Value(cond.unquoted), selection);
+        return;
+    }
+    // Strings match the literal with or without its quotes.
+    store.Filter(col, cond.op, Value(cond.literal), selection);
+    if (cond.unquoted == cond.literal) return;
+    std::vector<uint64_t> other(words);
+    store.Filter(col, cond.op, Value(cond.unquoted), other.data());
+    for (size_t w = 0; w < words; ++w) {
+        selection[w] = cond.op == CompareOp::EQ ? selection[w] | other[w] : selection[w] & other[w];
+    }
+}
+
+// Evaluate a predicate node over a column store: comparisons run as filter kernels and
+// AND / OR / NOT combine their bitmaps a word at a time.
+void FilterColumns(const ColumnStore &store, const Schema &schema, const Predicate &pred, int32_t node,
+                   uint64_t *selection) {
+    const Predicate::Node &n = pred.nodes[node];
+    size_t rows = store.GetRowCount();
+    size_t words = BitmapWords(rows);
+    if (n.kind == Predicate::Kind::COMPARE) {
+        FilterCondition(store, schema, n.cond, selection);
+        return;
+    }
+    FilterColumns(store, schema, pred, n.left, selection);
+    if (n.kind == Predicate::Kind::NOT) {
+        for (size_t w = 0; w < words; ++w) selection[w] = ~selection[w];
+        if (rows % 64 != 0) selection[words - 1] &= (uint64_t{1} << (rows % 64)) - 1;
+        return;
+    }
+    std::vector<uint64_t> right(words);
+    FilterColumns(store, schema, pred, n.right, right.data());
+    for (size_t w = 0; w < words; ++w) {
+        selection[w] = n.kind == Predicate::Kind::AND ? selection[w] & right[w] : selection[w] | right[w];
+    }
+}
+
+// Look up the rows that may satisfy cond through an index that can serve it.
+void ProbeIndex(IndexInfo *index, const Condition &cond, std::vector<RID> *rids) {
+    if (index->type_ == IndexType::HASH) {
+        index->index_->ScanKey(Value(cond.literal), rids);
+        if (cond.unquoted != cond.literal) {
+            index->index_->ScanKey(Value(cond.unquoted), rids);
+            std::sort(rids->begin(), rids->end());
+            rids->erase(std::unique(rids->begin(), rids->end()), rids->end());
+        }
+        return;
+    }
+    int32_t low = INT32_MIN, high = INT32_MAX;
+    int32_t v = cond.int_literal;
+    switch (cond.op) {
+        case CompareOp::EQ:
+            if (!cond.int_exact) return;
+            low = high = v;
+            break;
+        case CompareOp::LT:
+            if (v == INT32_MIN) return;
+            high = v - 1;
+            break;
+        case CompareOp::LE: high = v; break;
+        case CompareOp::GT:
+            if (v == INT32_MAX) return;
+            low = v + 1;
+            break;
+        case CompareOp::GE: low = v; break;
+        default: break;
+    }
+    index->index_->ScanRange(low, high, rids);
+}
+
+// Drop the rows of batch from keep onwards.
+void Truncate(RowBatch *batch, size_t keep) {
+    batch->rids.erase(batch->rids.begin() + keep, batch->rids.end());
+    batch->tuples.erase(batch->tuples.begin() + keep, batch->tuples.end());
+}
+
+// Keep only the rows of batch that satisfy pred.
+void FilterBatch(const Predicate &pred, const Schema &schema, RowBatch *batch) {
+    size_t kept = 0;
+    for (size_t i = 0; i < batch->Size(); ++i) {
+        if (!MatchesPredicate(pred, batch->tuples[i], schema)) continue;
+        if (kept != i) {
+            batch->rids[kept] = batch->rids[i];
+            batch->tuples[kept] = std::move(batch->tuples[i]);
+        }
+        kept++;
+    }
+    Truncate(batch, kept);
+}
+
+// Replace batch with the rows of a morsel's pages that satisfy pred (all if it is null).
+void ScanMorsel(TableHeap *heap, const std::vector<page_id_t> &pages, const Predicate *pred, const Schema &schema,
+                RowBatch *batch) {
+    batch->Clear();
+    for (page_id_t page_id : pages) heap->ScanPage(page_id, &batch->rids, &batch->tuples);
+    if (pred != nullptr) FilterBatch(*pred, schema, batch);
+}
+
+// Estimated fraction of table's rows that satisfy cond, read from the table's statistics.
+double EstimateSelectivity(const TableStats &stats, const Schema &schema, const Condition &cond) {
+    uint32_t col = static_cast<uint32_t>(cond.col_idx);
+    if (schema.GetColumn(col).GetType() != TypeId::INTEGER) {
+        return stats.EstimateSelectivity(col, cond.op, Value(std::string_view(cond.unquoted)));
+    }
+    if ((cond.op == CompareOp::EQ || cond.op == CompareOp::NE) && !cond.int_exact) {
+        return cond.op == CompareOp::EQ ? 0.0 : 1.0;
+    }
+    return stats.EstimateSelectivity(col, cond.op, Value(cond.int_literal));
+}
+
+// Costs of the access paths, in units of one heap page read in sequence. An index lookup
+// descends a few index pages and then fetches every matching row's page at random.
+double IndexScanCost(double rows) { return (3 + rows) * COST_RANDOM_PAGE + rows * COST_HEAP_ROW; }
+
+double FullScanCost(const TableInfo &table, const TableStats &stats) {
+    double rows = static_cast<double>(stats.GetRowCount());
+    if (table.column_store_ != nullptr) return rows * COST_COLUMN_ROW;
+    return static_cast<double>(stats.GetPageCount()) + rows * COST_HEAP_ROW;
+}
+
+// The index scan or column scan that serves pred over table, or null if the heap has to be
+// scanned. Without statistics the first comparison an index can answer gets the index;
+// once the table is analyzed, the cheapest index scan is picked, unless scanning the
+// whole table costs less.
+std::unique_ptr<Executor> MakeIndexOrColumnScan(Catalog &catalog, TableInfo *table, const Predicate *pred) {
+    const TableStats *stats = table->stats_.get();
+    IndexInfo *best_index = nullptr;
+    const Condition *best_cond = nullptr;
+    double best_cost = 0;
+    if (pred != nullptr) {
+        std::vector<const Condition *> conjuncts;
+        CollectConjuncts(*pred, pred->root, &conjuncts);
+        for (const Condition *cond : conjuncts) {
+            for (IndexInfo *index : catalog.GetTableIndexes(table->name_)) {
+                if (!IndexScanExecutor::CanServe(*index, *cond)) continue;
+                double cost = 0;
+                if (stats != nullptr) {
+                    double rows = static_cast<double>(stats->GetRowCount()) * EstimateSelectivity(*stats, *table->schema_, *cond);
+                    cost = IndexScanCost(rows);
+                }
+                if (best_index == nullptr || cost < best_cost) {
+                    best_index = index;
+                    best_cond = cond;
+                    best_cost = cost;
+                }
+            }
+            if (best_index != nullptr && stats == nullptr) break;
+        }
+    }
+    if (best_index != nullptr && stats != nullptr && FullScanCost(*table, *stats) < best_cost) best_index = nullptr;
+    if (best_index != nullptr) {
+        return std::make_unique<FilterExecutor>(
+            std::make_unique<IndexScanExecutor>(table->table_.get(), best_index, *best_cond), pred, table->schema_.get());
+    }
+    if (table->column_store_ != nullptr) return std::make_unique<ColumnScanExecutor>(table, pred);
+    return nullptr;
+}
+
+} // namespace
+
+bool SeqScanExecutor::Next(RowBatch *batch) {
+    batch->Clear();
+    while (batch->Size() < EXECUTION_BATCH_SIZE) {
+        page_id_t page_id;
+        {
+            std::lock_guard<std::mutex> guard(latch_);
+            if (page_id_ == INVALID_PAGE_ID) break;
+            page_id = page_id_;
+            page_id_ = heap_->GetNextPageId(page_id);
+        }
+        heap_->ScanPage(page_id, &batch->rids, &batch->tuples);
+    }
+    return batch->Size() > 0;
+}
+
+bool MorselSource::Claim(size_t *morsel, std::vector<page_id_t> *pages) {
+    pages->clear();
+    std::lock_guard<std::mutex> guard(latch_);
+    while (next_page_ != INVALID_PAGE_ID && pages->size() < SCAN_MORSEL_PAGES) {
+        pages->push_back(next_page_);
+        next_page_ = heap_->GetNextPageId(next_page_);
+    }
+    if (pages->empty()) return false;
+    *morsel = claimed_++;
+    return true;
+}
+
+ParallelScanExecutor::State::State(ThreadPool *pool, TableHeap *heap, const Predicate *pred, const Schema *schema,
+                                   bool ordered)
+    : pool(pool), heap(heap), pred(pred), schema(schema), ordered(ordered),
+      window(4 * (pool->GetWorkerCount() + 1)), source(heap) {}
+
+bool ParallelScanExecutor::State::ScanNext(std::unique_lock<std::mutex> &lock) {
+    if (exhausted || claimed - consumed >= window) return false;
+    size_t morsel;
+    std::vector<page_id_t> pages;
+    if (!source.Claim(&morsel, &pages)) {
+        exhausted = true;
+        cv.notify_all();
+        return false;
+    }
+    claimed++;
+    lock.unlock();
+    RowBatch batch;
+    ScanMorsel(heap, pages, pred, *schema, &batch);
+    lock.lock();
+    ready.emplace(morsel, std::move(batch));
+    cv.notify_all();
+    return true;
+}
+
+void ParallelScanExecutor::State::RunWorker() {
+    std::unique_lock<std::mutex> lock(latch);
+    if (cancelled) return;
+    workers++;
+    while (!cancelled && !exhausted) {
+        if (!ScanNext(lock)) cv.wait(lock, [&] { return cancelled || exhausted || claimed - consumed < window; });
+    }
+    workers--;
+    cv.notify_all();
+}
+
+ParallelScanExecutor::ParallelScanExecutor(ThreadPool *pool, TableHeap *heap, const Predicate *pred,
+                                           const Schema *schema, bool ordered)
+    : ordered_(ordered), state_(std::make_shared<State>(pool, heap, pred, schema, ordered)) {}
+
+ParallelScanExecutor::~ParallelScanExecutor() {
+    std::unique_lock<std::mutex> lock(state_->latch);
+    state_->cancelled = true;
+    state_->cv.notify_all();
+    state_->cv.wait(lock, [&] { return state_->workers == 0; });
+}
+
+bool ParallelScanExecutor::Next(RowBatch *batch) {
+    State &s = *state_;
+    std::unique_lock<std::mutex> lock(s.latch);
+    if (!s.started) {
+        s.started = true;
+        for (size_t i = 0; i < s.pool->GetWorkerCount(); ++i) {
+            s.pool->Submit([state = state_] { state->RunWorker(); });
+        }
+    }
+    while (true) {
+        auto it = s.ready.begin();
+        if (it != s.ready.end() && (!s.ordered || it->first == s.consumed)) {
+            *batch = std::move(it->second);
+            s.ready.erase(it);
+            s.consumed++;
+            s.cv.notify_all();
+            if (batch->Size() > 0) return true;
+            continue;
+        }
+        if (s.exhausted && s.consumed == s.claimed) {
+            batch->Clear();
+            return false;
+        }
+        // Scan a morsel here rather than wait for the workers; with none, this is the scan.
+        if (!s.ScanNext(lock) && !(s.exhausted && s.consumed == s.claimed)) s.cv.wait(lock);
+    }
+}
+
+bool ColumnScanExecutor::Next(RowBatch *batch) {
+    batch->Clear();
+    ColumnStore &store = *table_->column_store_;
+    if (!started_) {
+        started_ = true;
+        store.Refresh(table_->table_.get());
+        size_t rows = store.GetRowCount();
+        selection_.assign(BitmapWords(rows), 0);
+        if (pred_ != nullptr) {
+            FilterColumns(store, *table_->schema_, *pred_, pred_->root, selection_.data());
+        } else {
+            SelectAll(selection_.data(), rows);
+        }
+    }
+    while (word_ < selection_.size() && batch->Size() < EXECUTION_BATCH_SIZE) {
+        size_t base = word_ * 64;
+        ForEachSelected(&selection_[word_++], 1, [&](size_t bit) {
+            batch->rids.push_back(store.GetRID(base + bit));
+            batch->tuples.push_back(store.GetTuple(base + bit));
+        });
+    }
+    return batch->Size() > 0;
+}
+
+bool IndexScanExecutor::CanServe(const IndexInfo &index, const Condition &cond) {
+    if (cond.op == CompareOp::NE || index.key_col_ != static_cast<uint32_t>(cond.col_idx)) return false;
+    return index.index_->SupportsRange() || cond.op == CompareOp::EQ;
+}
+
+bool IndexScanExecutor::Next(RowBatch *batch) {
+    batch->Clear();
+    if (!started_) {
+        started_ = true;
+        ProbeIndex(index_, cond_, &rids_);
+    }
+    Tuple tuple;
+    while (pos_ < rids_.size() && batch->Size() < EXECUTION_BATCH_SIZE) {
+        const RID &rid = rids_[pos_++];
+        if (!heap_->GetTuple(rid, &tuple)) continue;
+        batch->rids.push_back(rid);
+        batch->tuples.push_back(std::move(tuple));
+    }
+    return batch->Size() > 0;
+}
+
+bool FilterExecutor::Next(RowBatch *batch) {
+    while (child_->Next(batch)) {
+        FilterBatch(*pred_, *schema_, batch);
+        if (batch->Size() > 0) return true;
+    }
+    return false;
+}
+
+ProjectionExecutor::ProjectionExecutor(std::unique_ptr<Executor> child, std::vector<int32_t> columns)
+    : child_(std::move(child)), columns_(std::move(columns)) {
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        if (columns_[i] != static_cast<int32_t>(i)) identity_ = false;
+        if (std::find(columns_.begin(), columns_.begin() + i, columns_[i]) != columns_.begin() + i) distinct_ = false;
+    }
+}
+
+bool ProjectionExecutor::Next(RowBatch *batch) {
+    batch->Clear();
+    if (!child_->Next(&input_)) return false;
+    batch->rids.swap(input_.rids);
+    if (identity_ && input_.tuples[0].GetValues().size() == columns_.size()) {
+        batch->tuples.swap(input_.tuples);
+        return true;
+    }
+    batch->tuples.reserve(input_.Size());
+    // Each row's old value array becomes the buffer for the next row's projection.
+    std::vector<Value> projected;
+    for (Tuple &tuple : input_.tuples) {
+        projected.clear();
+        projected.reserve(columns_.size());
+        if (distinct_) {
+            std::vector<Value> values = tuple.ReleaseValues();
+            for (int32_t idx : columns_) projected.push_back(std::move(values[idx]));
+            batch->tuples.emplace_back(std::move(projected));
+            projected = std::move(values);
+        } else {
+            for (int32_t idx : columns_) projected.push_back(tuple.GetValues()[idx]);
+            batch->tuples.emplace_back(std::move(projected));
+        }
+    }
+    return true;
+}
+
+bool LimitExecutor::Next(RowBatch *batch) {
+    while (remaining_ > 0 && child_->Next(batch)) {
+        if (skip_ >= batch->Size()) {
+            skip_ -= batch->Size();
+            continue;
+        }
+        if (skip_ > 0) {
+            batch->rids.erase(batch->rids.begin(), batch->rids.begin() + skip_);
+            batch->tuples.erase(batch->tuples.begin(), batch->tuples.begin() + skip_);
+            skip_ = 0;
+        }
+        if (batch->Size() > remaining_) Truncate(batch, remaining_);
+        remaining_ -= batch->Size();
+        return true;
+    }
+    batch->Clear();
+    return false;
+}
+
+AggregationExecutor::AggregationExecutor(std::unique_ptr<Executor> child, std::vector<int32_t> group_by,
+                                         std::vector<AggregateExpr> aggregates, ThreadPool *pool)
+    : child_(std::move(child)), group_by_(std::move(group_by)), aggregates_(std::move(aggregates)), pool_(pool) {}
+
+void AggregationExecutor::Build() {
+    size_t folds = pool_ != nullptr ? pool_->GetWorkerCount() + 1 : 1;
+    std::vector<std::unique_ptr<AggregateHashTable>> partials;
+    for (size_t i = 0; i < folds; ++i) {
+        partials.push_back(std::make_unique<AggregateHashTable>(group_by_, aggregates_));
+    }
+
+    std::mutex latch;
+    std::atomic<bool> exhausted{false};
+    bool shared = child_->IsThreadSafe();
+    auto fold = [&](AggregateHashTable *table) {
+        RowBatch batch;
+        while (!exhausted) {
+            std::unique_lock<std::mutex> guard(latch, std::defer_lock);
+            if (!shared) guard.lock();
+            if (!child_->Next(&batch)) break;
+            if (guard.owns_lock()) guard.unlock();
+            for (const Tuple &tuple : batch.tuples) table->Update(tuple);
+        }
+        exhausted = true;
+    };
+    if (pool_ != nullptr) {
+        pool_->ParallelFor(folds, [&](size_t i) { fold(partials[i].get()); });
+    } else {
+        fold(partials[0].get());
+    }
+
+    table_ = std::move(partials[0]);
+    for (size_t i = 1; i < partials.size(); ++i) table_->Merge(*partials[i]);
+    table_->EnsureEmptyKeyGroup();
+    groups_ = table_->SortedGroups();
+}
+
+bool AggregationExecutor::Next(RowBatch *batch) {
+    batch->Clear();
+    if (table_ == nullptr) Build();
+    while (pos_ < groups_.size() && batch->Size() < EXECUTION_BATCH_SIZE) {
+        batch->rids.emplace_back();
+        batch->tuples.push_back(table_->GetRow(groups_[pos_++]));
+    }
+    return batch->Size() > 0;
+}
+
+bool OutputExecutor::Next(RowBatch *batch) {
+    if (!header_printed_) {
+        writer_.WriteHeader(headers_);
+        header_printed_ = true;
+    }
+    if (!child_->Next(batch)) {
+        writer_.Flush();
+        return false;
+    }
+    for (const Tuple &tuple : batch->tuples) writer_.WriteRow(tuple);
+    row_count_ += batch->Size();
+    return true;
+}
+
+std::unique_ptr<Executor> MakeScanExecutor(Catalog &catalog, TableInfo *table, const Predicate *pred,
+                                           ThreadPool *pool, bool ordered) {
+    std::unique_ptr<Executor> scan = MakeIndexOrColumnScan(catalog, table, pred);
+    if (scan != nullptr) return scan;
+
+    TableHeap *heap = table->table_.get();
+    const Schema *schema = table->schema_.get();
+    if (pool != nullptr) return std::make_unique<ParallelScanExecutor>(pool, heap, pred, schema, ordered);
+    if (pred == nullptr) return std::make_unique<SeqScanExecutor>(heap);
+    return std::make_unique<FilterExecutor>(std::make_unique<SeqScanExecutor>(heap), pred, schema);
+}
+
+void ScanMorsels(Catalog &catalog, TableInfo *table, const Predicate *pred, ThreadPool *pool,
+                 const std::function<void(size_t, RowBatch *)> &sink) {
+    std::unique_ptr<Executor> scan = MakeIndexOrColumnScan(catalog, table, pred);
+    if (scan == nullptr && pool != nullptr) {
+        TableHeap *heap = table->table_.get();
+        MorselSource source(heap);
+        pool->ParallelFor(pool->GetWorkerCount() + 1, [&](size_t) {
+            size_t morsel;
+            std::vector<page_id_t> pages;
+            RowBatch batch;
+            while (source.Claim(&morsel, &pages)) {
+                ScanMorsel(heap, pages, pred, *table->schema_, &batch);
+                if (batch.Size() > 0) sink(morsel, &batch);
+            }
+        });
+        return;
+    }
+
+    if (scan == nullptr) scan = MakeScanExecutor(catalog, table, pred);
+    RowBatch rows;
+    DrainExecutor(scan.get(), &rows);
+    if (rows.Size() > 0) sink(0, &rows);
+}
+
+void DrainExecutor(Executor *executor, RowBatch *rows) {
+    RowBatch batch;
+    while (executor->Next(&batch)) {
+        rows->rids.insert(rows->rids.end(), batch.rids.begin(), batch.rids.end());
+        rows->tuples.insert(rows->tuples.end(), std::make_move_iterator(batch.tuples.begin()),
+                            std::make_move_iterator(batch.tuples.end()));
+    }
+}
+
+} // namespace simpledb
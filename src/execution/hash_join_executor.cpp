@@ -0,0 +1,277 @@
+#include "execution/hash_join_executor.h"
+#include "execution/hash_util.h"
+#include "common/logger.h"
+#include <filesystem>
+#include <iterator>
+
+namespace simpledb {
+
+static_assert((JOIN_PARTITIONS & (JOIN_PARTITIONS - 1)) == 0, "JOIN_PARTITIONS must be a power of two");
+
+namespace {
+
+Tuple JoinRows(const Tuple &probe, const Tuple &build) {
+    std::vector<Value> values;
+    values.reserve(probe.GetValues().size() + build.GetValues().size());
+    values.insert(values.end(), probe.GetValues().begin(), probe.GetValues().end());
+    values.insert(values.end(), build.GetValues().begin(), build.GetValues().end());
+    return Tuple(std::move(values));
+}
+
+} // namespace
+
+void HashJoinExecutor::Partition::BuildTable() {
+    size_t size = 1;
+    while (size < rows.size() * 2) size <<= 1;
+    buckets.assign(size, 0);
+    next.assign(rows.size(), 0);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        size_t bucket = hashes[i] & (size - 1);
+        next[i] = buckets[bucket];
+        buckets[bucket] = static_cast<uint32_t>(i + 1);
+    }
+}
+
+void HashJoinExecutor::Partition::Clear() {
+    std::vector<Tuple>().swap(rows);
+    std::vector<uint64_t>().swap(hashes);
+    std::vector<uint32_t>().swap(buckets);
+    std::vector<uint32_t>().swap(next);
+}
+
+HashJoinExecutor::HashJoinExecutor(std::unique_ptr<Executor> probe, const Schema *probe_schema, uint32_t probe_key,
+                                   std::unique_ptr<Executor> build, const Schema *build_schema, uint32_t build_key,
+                                   ThreadPool *pool, size_t memory_budget)
+    : probe_(std::move(probe)), probe_schema_(probe_schema), probe_key_(probe_key), build_(std::move(build)),
+      build_schema_(build_schema), build_key_(build_key), pool_(pool), memory_budget_(memory_budget),
+      num_slots_(pool != nullptr ? pool->GetWorkerCount() + 1 : 1), partitions_(JOIN_PARTITIONS) {}
+
+HashJoinExecutor::~HashJoinExecutor() {
+    build_spill_.clear();
+    probe_spill_.clear();
+    spill_pool_.reset();
+    spill_disk_.reset();
+    if (!spill_file_.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(spill_file_, ec);
+    }
+}
+
+bool HashJoinExecutor::Next(RowBatch *batch) {
+    while (queue_.empty() && phase_ != Phase::DONE) Advance();
+    if (queue_.empty()) {
+        batch->Clear();
+        return false;
+    }
+    *batch = std::move(queue_.front());
+    queue_.pop_front();
+    return true;
+}
+
+void HashJoinExecutor::Advance() {
+    switch (phase_) {
+        case Phase::BUILD:
+            BuildPhase();
+            if (spilled_) {
+                SpillProbeRows();
+                spill_cursors_.resize(num_slots_);
+                phase_ = Phase::JOIN_SPILLED;
+            } else {
+                std::atomic<size_t> next{0};
+                ForEachSlot([&](size_t) {
+                    for (size_t p = next++; p < partitions_.size(); p = next++) partitions_[p].BuildTable();
+                });
+                phase_ = Phase::PROBE;
+            }
+            break;
+        case Phase::PROBE:
+            if (!ProbeRound()) phase_ = Phase::DONE;
+            break;
+        case Phase::JOIN_SPILLED:
+            if (!JoinSpilledRound()) {
+                spill_cursors_.clear();
+                phase_ = Phase::DONE;
+            }
+            break;
+        case Phase::DONE:
+            break;
+    }
+}
+
+void HashJoinExecutor::BuildPhase() {
+    ForEachSlot([&](size_t) {
+        LocalPartitions local;
+        RowBatch batch;
+        while (Pull(build_.get(), &batch)) {
+            for (Tuple &row : batch.tuples) {
+                uint64_t hash = HashValue(row.GetValues()[build_key_]);
+                size_t p = PartitionOf(hash);
+                local.bytes += row.GetFootprint();
+                local.rows[p].push_back(std::move(row));
+                local.hashes[p].push_back(hash);
+            }
+            DepositBuildRows(&local);
+        }
+    });
+}
+
+void HashJoinExecutor::SpillProbeRows() {
+    ForEachSlot([&](size_t) {
+        LocalPartitions local;
+        RowBatch batch;
+        while (Pull(probe_.get(), &batch)) {
+            for (Tuple &row : batch.tuples) {
+                local.rows[PartitionOf(HashValue(row.GetValues()[probe_key_]))].push_back(std::move(row));
+            }
+            SpillRows(probe_spill_, &local);
+        }
+    });
+}
+
+// False once the probe input has run dry.
+bool HashJoinExecutor::ProbeRound() {
+    std::atomic<bool> pulled{false};
+    ForEachSlot([&](size_t) {
+        RowBatch batch;
+        if (!Pull(probe_.get(), &batch)) return;
+        pulled = true;
+        RowBatch out;
+        for (const Tuple &row : batch.tuples) {
+            uint64_t hash = HashValue(row.GetValues()[probe_key_]);
+            ProbeRow(partitions_[PartitionOf(hash)], row, hash, &out);
+        }
+        if (out.Size() > 0) Emit(&out);
+    });
+    return pulled;
+}
+
+// False once every spilled partition has been joined.
+bool HashJoinExecutor::JoinSpilledRound() {
+    std::atomic<bool> active{false};
+    ForEachSlot([&](size_t slot) {
+        SpillCursor &cursor = spill_cursors_[slot];
+        RowBatch page_rows;
+        while (cursor.next_page == INVALID_PAGE_ID) {
+            cursor.partition.Clear();
+            cursor.index = next_spilled_++;
+            if (cursor.index >= JOIN_PARTITIONS) return;
+            for (page_id_t page = build_spill_[cursor.index]->GetFirstPageId(); page != INVALID_PAGE_ID;) {
+                page_rows.Clear();
+                page = build_spill_[cursor.index]->ScanPage(page, &page_rows.rids, &page_rows.tuples);
+                for (Tuple &row : page_rows.tuples) {
+                    cursor.partition.hashes.push_back(HashValue(row.GetValues()[build_key_]));
+                    cursor.partition.rows.push_back(std::move(row));
+                }
+            }
+            cursor.partition.BuildTable();
+            cursor.next_page = probe_spill_[cursor.index]->GetFirstPageId();
+        }
+        active = true;
+
+        page_rows.Clear();
+        cursor.next_page = probe_spill_[cursor.index]->ScanPage(cursor.next_page, &page_rows.rids, &page_rows.tuples);
+        RowBatch out;
+        for (const Tuple &row : page_rows.tuples) {
+            ProbeRow(cursor.partition, row, HashValue(row.GetValues()[probe_key_]), &out);
+        }
+        if (out.Size() > 0) Emit(&out);
+    });
+    return active;
+}
+
+void HashJoinExecutor::ForEachSlot(const std::function<void(size_t)> &body) {
+    if (pool_ != nullptr) {
+        pool_->ParallelFor(num_slots_, body);
+    } else {
+        body(0);
+    }
+}
+
+bool HashJoinExecutor::Pull(Executor *child, RowBatch *batch) {
+    if (child->IsThreadSafe()) return child->Next(batch);
+    std::lock_guard<std::mutex> guard(pull_latch_);
+    return child->Next(batch);
+}
+
+void HashJoinExecutor::DepositBuildRows(LocalPartitions *local) {
+    {
+        std::lock_guard<std::mutex> guard(spill_latch_);
+        if (!spilled_) {
+            for (size_t p = 0; p < JOIN_PARTITIONS; ++p) {
+                Partition &partition = partitions_[p];
+                partition.rows.insert(partition.rows.end(), std::make_move_iterator(local->rows[p].begin()),
+                                      std::make_move_iterator(local->rows[p].end()));
+                partition.hashes.insert(partition.hashes.end(), local->hashes[p].begin(), local->hashes[p].end());
+                local->rows[p].clear();
+                local->hashes[p].clear();
+            }
+            memory_used_ += local->bytes;
+            local->bytes = 0;
+            if (memory_used_ > memory_budget_ && !spill_failed_) StartSpilling();
+            return;
+        }
+    }
+    SpillRows(build_spill_, local);
+}
+
+void HashJoinExecutor::StartSpilling() {
+    spill_file_ = DiskManager::TempFileName("simpledb-join");
+    spill_disk_ = std::make_unique<DiskManager>(spill_file_);
+    spill_pool_ = std::make_unique<BufferPoolManager>(JOIN_SPILL_POOL_PAGES, spill_disk_.get());
+    for (size_t p = 0; p < JOIN_PARTITIONS; ++p) {
+        build_spill_.push_back(std::make_unique<TableHeap>(spill_pool_.get(), build_schema_, 0, nullptr));
+        probe_spill_.push_back(std::make_unique<TableHeap>(spill_pool_.get(), probe_schema_, 0, nullptr));
+        if (build_spill_.back()->GetFirstPageId() == INVALID_PAGE_ID ||
+            probe_spill_.back()->GetFirstPageId() == INVALID_PAGE_ID) {
+            LOG_WARN("Could not create join spill file '" << spill_file_ << "'; joining in memory.");
+            spill_failed_ = true;
+            build_spill_.clear();
+            probe_spill_.clear();
+            return;
+        }
+    }
+
+    std::vector<RID> rids;
+    for (size_t p = 0; p < JOIN_PARTITIONS; ++p) {
+        rids.resize(partitions_[p].rows.size());
+        if (!partitions_[p].rows.empty()) build_spill_[p]->InsertTuples(partitions_[p].rows, rids.data());
+        partitions_[p].Clear();
+    }
+    memory_used_ = 0;
+    spilled_ = true;
+}
+
+void HashJoinExecutor::SpillRows(std::vector<std::unique_ptr<TableHeap>> &heaps, LocalPartitions *local) {
+    std::vector<RID> rids;
+    for (size_t p = 0; p < JOIN_PARTITIONS; ++p) {
+        if (local->rows[p].empty()) continue;
+        rids.resize(local->rows[p].size());
+        heaps[p]->InsertTuples(local->rows[p], rids.data());
+        local->rows[p].clear();
+        local->hashes[p].clear();
+    }
+    local->bytes = 0;
+}
+
+void HashJoinExecutor::ProbeRow(const Partition &partition, const Tuple &row, uint64_t hash, RowBatch *out) {
+    const Value &key = row.GetValues()[probe_key_];
+    for (uint32_t i = partition.buckets[hash & (partition.buckets.size() - 1)]; i != 0; i = partition.next[i - 1]) {
+        const Tuple &match = partition.rows[i - 1];
+        if (partition.hashes[i - 1] != hash || match.GetValues()[build_key_] != key) continue;
+        out->rids.emplace_back();
+        out->tuples.push_back(JoinRows(row, match));
+        if (out->Size() >= EXECUTION_BATCH_SIZE) Emit(out);
+    }
+}
+
+void HashJoinExecutor::Emit(RowBatch *out) {
+    std::lock_guard<std::mutex> guard(queue_latch_);
+    queue_.push_back(std::move(*out));
+    out->Clear();
+}
+
+size_t HashJoinExecutor::PartitionOf(uint64_t hash) {
+    return static_cast<size_t>(hash >> 32) & (JOIN_PARTITIONS - 1);
+}
+
+} // namespace simpledb
@@ -0,0 +1,277 @@
+#include "execution/predicate.h"
+#include "common/logger.h"
+#include <cctype>
+#include <charconv>
+#include <cstring>
+
+namespace simpledb {
+
+bool BindCondition(const Schema &schema, std::string_view literal, Condition *cond) {
+    cond->literal = literal;
+    const std::string &lit = cond->literal;
+    if (lit.size() >= 2 && ((lit.front() == '\'' && lit.back() == '\'') || (lit.front() == '"' && lit.back() == '"'))) {
+        cond->unquoted.assign(lit, 1, lit.size() - 2);
+    } else {
+        cond->unquoted = lit;
+    }
+
+    if (schema.GetColumn(cond->col_idx).GetType() == TypeId::INTEGER) {
+        // Accept what std::stoi would, a leading + included.
+        std::string_view digits = lit;
+        if (digits.size() > 1 && digits[0] == '+' && digits[1] != '-') digits.remove_prefix(1);
+        auto result = std::from_chars(digits.data(), digits.data() + digits.size(), cond->int_literal);
+        cond->int_parsed = result.ec == std::errc() && result.ptr == digits.data() + digits.size();
+        cond->int_exact = cond->int_parsed && std::to_string(cond->int_literal) == lit;
+        if (!cond->int_parsed && cond->op != CompareOp::EQ && cond->op != CompareOp::NE) {
+            LOG_ERROR("Expected an integer literal for column '" << schema.GetColumn(cond->col_idx).GetName() << "'.");
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace {
+
+// Recursive-descent parser for where clauses:
+//
+//   or  := and { OR and }        and := not { AND not }
+//   not := NOT not | primary     primary := '(' or ')' | <col> <op> <literal>
+//
+// Keywords are case-insensitive. A literal is a quoted string or, as before, the raw
+// text up to the next AND / OR / ')' so unquoted values may contain spaces. With
+// allow_params, a bare ? literal is a parameter bound later.
+class PredicateParser {
+public:
+    PredicateParser(const Schema &schema, const std::string &text, Predicate *pred, bool allow_params)
+        : schema_(schema), text_(text), pred_(pred), allow_params_(allow_params) {}
+
+    bool Parse() {
+        pred_->root = ParseOr();
+        if (pred_->root < 0) return false;
+        SkipSpace();
+        if (pos_ < text_.size()) return Fail("unexpected '" + text_.substr(pos_) + "'");
+        return true;
+    }
+
+private:
+    bool Fail(const std::string &message) {
+        if (!failed_) LOG_ERROR("Syntax error in where clause: " << message << ".");
+        failed_ = true;
+        return false;
+    }
+
+    void SkipSpace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) pos_++;
+    }
+
+    static bool IsWordChar(char c) {
+        return !std::isspace(static_cast<unsigned char>(c)) && c != '(' && c != ')' && c != '=' && c != '<' &&
+               c != '>' && c != '!';
+    }
+
+    // Consume keyword (case-insensitively) if it is the next whole word.
+    bool AcceptKeyword(const char *keyword) {
+        SkipSpace();
+        size_t len = strlen(keyword);
+        if (text_.size() - pos_ < len) return false;
+        for (size_t i = 0; i < len; ++i) {
+            if (std::tolower(static_cast<unsigned char>(text_[pos_ + i])) != keyword[i]) return false;
+        }
+        if (pos_ + len < text_.size() && IsWordChar(text_[pos_ + len])) return false;
+        pos_ += len;
+        return true;
+    }
+
+    int32_t Combine(Predicate::Kind kind, int32_t left, int32_t right) {
+        Predicate::Node node;
+        node.kind = kind;
+        node.left = left;
+        node.right = right;
+        return pred_->Add(std::move(node));
+    }
+
+    int32_t ParseOr() {
+        int32_t left = ParseAnd();
+        while (left >= 0 && AcceptKeyword("or")) {
+            int32_t right = ParseAnd();
+            left = right < 0 ? -1 : Combine(Predicate::Kind::OR, left, right);
+        }
+        return left;
+    }
+
+    int32_t ParseAnd() {
+        int32_t left = ParseNot();
+        while (left >= 0 && AcceptKeyword("and")) {
+            int32_t right = ParseNot();
+            left = right < 0 ? -1 : Combine(Predicate::Kind::AND, left, right);
+        }
+        return left;
+    }
+
+    int32_t ParseNot() {
+        if (AcceptKeyword("not")) {
+            int32_t operand = ParseNot();
+            return operand < 0 ? -1 : Combine(Predicate::Kind::NOT, operand, -1);
+        }
+        SkipSpace();
+        if (pos_ < text_.size() && text_[pos_] == '(') {
+            pos_++;
+            int32_t inner = ParseOr();
+            SkipSpace();
+            if (inner < 0) return -1;
+            if (pos_ >= text_.size() || text_[pos_] != ')') {
+                Fail("missing ')'");
+                return -1;
+            }
+            pos_++;
+            return inner;
+        }
+        return ParseComparison();
+    }
+
+    int32_t ParseComparison() {
+        SkipSpace();
+        size_t start = pos_;
+        while (pos_ < text_.size() && IsWordChar(text_[pos_])) pos_++;
+        std::string col_name = text_.substr(start, pos_ - start);
+        if (col_name.empty()) {
+            Fail("expected a column name");
+            return -1;
+        }
+
+        SkipSpace();
+        char c = pos_ < text_.size() ? text_[pos_] : '\0';
+        char n = pos_ + 1 < text_.size() ? text_[pos_ + 1] : '\0';
+        CompareOp op;
+        size_t op_len = 1;
+        if (c == '=') {
+            op = CompareOp::EQ;
+        } else if ((c == '!' && n == '=') || (c == '<' && n == '>')) {
+            op = CompareOp::NE; op_len = 2;
+        } else if (c == '<') {
+            op = n == '=' ? CompareOp::LE : CompareOp::LT; op_len = n == '=' ? 2 : 1;
+        } else if (c == '>') {
+            op = n == '=' ? CompareOp::GE : CompareOp::GT; op_len = n == '=' ? 2 : 1;
+        } else {
+            LOG_ERROR("Syntax error: missing comparison operator in where clause.");
+            failed_ = true;
+            return -1;
+        }
+        pos_ += op_len;
+
+        std::string literal;
+        if (!ParseLiteral(&literal)) return -1;
+        Predicate::Node node;
+        node.cond.op = op;
+        node.cond.col_idx = schema_.GetColIdx(col_name);
+        if (node.cond.col_idx == -1) {
+            LOG_ERROR("Column '" << col_name << "' not found in table.");
+            failed_ = true;
+            return -1;
+        }
+        bool param = allow_params_ && literal == "?";
+        if (!param && !BindCondition(schema_, literal, &node.cond)) {
+            failed_ = true;
+            return -1;
+        }
+        int32_t index = pred_->Add(std::move(node));
+        if (param) pred_->params.push_back(index);
+        return index;
+    }
+
+    bool ParseLiteral(std::string *literal) {
+        SkipSpace();
+        size_t start = pos_;
+        if (pos_ < text_.size() && (text_[pos_] == '\'' || text_[pos_] == '"')) {
+            size_t close = text_.find(text_[pos_], pos_ + 1);
+            if (close == std::string::npos) return Fail("unterminated string literal");
+            pos_ = close + 1;
+        } else {
+            size_t end = pos_;
+            while (true) {
+                SkipSpace();
+                if (pos_ >= text_.size() || text_[pos_] == ')' || AcceptKeyword("and") || AcceptKeyword("or")) break;
+                while (pos_ < text_.size() && text_[pos_] != ')' && !std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+                    pos_++;
+                }
+                end = pos_;
+            }
+            pos_ = end;
+        }
+        *literal = text_.substr(start, pos_ - start);
+        if (literal->empty()) return Fail("expected a value");
+        return true;
+    }
+
+    const Schema &schema_;
+    const std::string &text_;
+    Predicate *pred_;
+    bool allow_params_;
+    size_t pos_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace
+
+bool ParsePredicate(const Schema &schema, std::string where_part, Predicate *pred, bool allow_params) {
+    size_t begin = where_part.find_first_not_of(" \t\n\v\f\r");
+    size_t end = where_part.find_last_not_of(" \t\n\v\f\r");
+    where_part = begin == std::string::npos ? std::string() : where_part.substr(begin, end - begin + 1);
+    if (!where_part.empty() && where_part.back() == ';') where_part.pop_back();
+    return PredicateParser(schema, where_part, pred, allow_params).Parse();
+}
+
+bool MatchesCondition(const Tuple &tuple, const Schema &schema, const Condition &cond) {
+    const Value &v = tuple.GetValue(&schema, cond.col_idx);
+    if (v.GetTypeId() == TypeId::INTEGER) {
+        int32_t x = v.GetAsInt();
+        switch (cond.op) {
+            case CompareOp::EQ: return cond.int_exact && x == cond.int_literal;
+            case CompareOp::NE: return !(cond.int_exact && x == cond.int_literal);
+            case CompareOp::LT: return x < cond.int_literal;
+            case CompareOp::LE: return x <= cond.int_literal;
+            case CompareOp::GT: return x > cond.int_literal;
+            case CompareOp::GE: return x >= cond.int_literal;
+        }
+        return false;
+    }
+    std::string_view s = v.GetAsString();
+    switch (cond.op) {
+        case CompareOp::EQ: return s == cond.literal || s == cond.unquoted;
+        case CompareOp::NE: return s != cond.literal && s != cond.unquoted;
+        case CompareOp::LT: return s < cond.unquoted;
+        case CompareOp::LE: return s <= cond.unquoted;
+        case CompareOp::GT: return s > cond.unquoted;
+        case CompareOp::GE: return s >= cond.unquoted;
+    }
+    return false;
+}
+
+bool MatchesPredicate(const Predicate &pred, int32_t node, const Tuple &tuple, const Schema &schema) {
+    const Predicate::Node &n = pred.nodes[node];
+    switch (n.kind) {
+        case Predicate::Kind::COMPARE: return MatchesCondition(tuple, schema, n.cond);
+        case Predicate::Kind::AND:
+            return MatchesPredicate(pred, n.left, tuple, schema) && MatchesPredicate(pred, n.right, tuple, schema);
+        case Predicate::Kind::OR:
+            return MatchesPredicate(pred, n.left, tuple, schema) || MatchesPredicate(pred, n.right, tuple, schema);
+        case Predicate::Kind::NOT: return !MatchesPredicate(pred, n.left, tuple, schema);
+    }
+    return false;
+}
+
+bool MatchesPredicate(const Predicate &pred, const Tuple &tuple, const Schema &schema) {
+    return MatchesPredicate(pred, pred.root, tuple, schema);
+}
+
+void CollectConjuncts(const Predicate &pred, int32_t node, std::vector<const Condition *> *conjuncts) {
+    const Predicate::Node &n = pred.nodes[node];
+    if (n.kind == Predicate::Kind::AND) {
+        CollectConjuncts(pred, n.left, conjuncts);
+        CollectConjuncts(pred, n.right, conjuncts);
+    } else if (n.kind == Predicate::Kind::COMPARE) {
+        conjuncts->push_back(&n.cond);
+    }
+}
+
+} // namespace simpledb
@@ -0,0 +1,54 @@
+#include "execution/result_writer.h"
+#include <charconv>
+
+namespace simpledb {
+
+namespace {
+
+constexpr size_t CELL_WIDTH = 20;
+constexpr char CELL_SEPARATOR[] = " | ";
+constexpr char HEADER_RULE[] = "\n------------------------------------------------------\n";
+
+} // namespace
+
+ResultWriter::ResultWriter(std::ostream &out, size_t capacity, Arena *scratch)
+    : out_(out), capacity_(capacity), buffer_(scratch) {
+    buffer_.reserve(capacity_ + 4 * 1024);
+}
+
+void ResultWriter::WriteHeader(const std::vector<std::string> &headers) {
+    for (const std::string &header : headers) AppendCell(header.data(), header.size());
+    buffer_.append(HEADER_RULE, sizeof(HEADER_RULE) - 1);
+}
+
+void ResultWriter::WriteRow(const Tuple &tuple) {
+    for (const Value &value : tuple.GetValues()) {
+        switch (value.GetTypeId()) {
+            case TypeId::INTEGER: {
+                char digits[16];
+                auto result = std::to_chars(digits, digits + sizeof(digits), value.GetAsInt());
+                AppendCell(digits, static_cast<size_t>(result.ptr - digits));
+                break;
+            }
+            case TypeId::VARCHAR: AppendCell(value.GetAsString().data(), value.GetAsString().size()); break;
+            default: AppendCell("NULL", 4); break;
+        }
+    }
+    buffer_.push_back('\n');
+    if (buffer_.size() >= capacity_) Flush();
+}
+
+void ResultWriter::Flush() {
+    if (buffer_.empty()) return;
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    out_.flush();
+    buffer_.clear();
+}
+
+void ResultWriter::AppendCell(const char *data, size_t size) {
+    buffer_.append(data, size);
+    if (size < CELL_WIDTH) buffer_.append(CELL_WIDTH - size, ' ');
+    buffer_.append(CELL_SEPARATOR, sizeof(CELL_SEPARATOR) - 1);
+}
+
+} // namespace simpledb
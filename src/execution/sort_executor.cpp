@@ -0,0 +1,386 @@
+#include "execution/sort_executor.h"
+#include "common/logger.h"
+#include "common/serialize.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <future>
+
+namespace simpledb {
+
+namespace {
+
+// Order of two values of one sort column: NULL first, then integers numerically and text
+// bytewise, or by the number it spells in a numeric column.
+int CompareValues(const Value &a, const Value &b, bool numeric) {
+    bool a_null = a.GetTypeId() == TypeId::INVALID;
+    bool b_null = b.GetTypeId() == TypeId::INVALID;
+    if (a_null || b_null) return static_cast<int>(b_null) - static_cast<int>(a_null);
+    if (a.GetTypeId() == TypeId::INTEGER && b.GetTypeId() == TypeId::INTEGER) {
+        return (a.GetAsInt() > b.GetAsInt()) - (a.GetAsInt() < b.GetAsInt());
+    }
+    if (numeric) {
+        auto number = [](const Value &v) {
+            if (v.GetTypeId() == TypeId::INTEGER) return static_cast<double>(v.GetAsInt());
+            double x = 0;
+            std::from_chars(v.GetAsString().data(), v.GetAsString().data() + v.GetAsString().size(), x);
+            return x;
+        };
+        double x = number(a);
+        double y = number(b);
+        return (x > y) - (x < y);
+    }
+    int cmp = a.GetTypeId() == b.GetTypeId() ? a.GetAsString().compare(b.GetAsString())
+                                             : a.ToString().compare(b.ToString());
+    return (cmp > 0) - (cmp < 0);
+}
+
+// A row as a run stores it: the size of the rest, the rid, then the values, each tagged
+// with its type so that NULLs and the rows of joins and aggregates need no schema.
+void EncodeRow(const Tuple &tuple, const RID &rid, std::string *out) {
+    size_t start = out->size();
+    PutValue<uint32_t>(out, 0);
+    PutValue<int32_t>(out, rid.GetPageId());
+    PutValue<uint32_t>(out, rid.GetSlotNum());
+    PutValue<uint32_t>(out, static_cast<uint32_t>(tuple.GetValues().size()));
+    for (const Value &value : tuple.GetValues()) {
+        PutValue<uint8_t>(out, static_cast<uint8_t>(value.GetTypeId()));
+        if (value.GetTypeId() == TypeId::INTEGER) PutValue<int32_t>(out, value.GetAsInt());
+        else if (value.GetTypeId() == TypeId::VARCHAR) PutString(out, value.GetAsString());
+    }
+    uint32_t size = static_cast<uint32_t>(out->size() - start - sizeof(uint32_t));
+    memcpy(&(*out)[start], &size, sizeof(size));
+}
+
+bool DecodeRow(const std::string &data, Tuple *tuple, RID *rid) {
+    ByteReader reader{data.data(), data.data() + data.size()};
+    int32_t page_id;
+    uint32_t slot, count;
+    if (!reader.Get(&page_id) || !reader.Get(&slot) || !reader.Get(&count)) return false;
+    rid->Set(page_id, slot);
+    std::vector<Value> values;
+    values.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint8_t type;
+        if (!reader.Get(&type)) return false;
+        if (type == static_cast<uint8_t>(TypeId::INTEGER)) {
+            int32_t v;
+            if (!reader.Get(&v)) return false;
+            values.emplace_back(v);
+        } else if (type == static_cast<uint8_t>(TypeId::VARCHAR)) {
+            std::string s;
+            if (!reader.GetString(&s)) return false;
+            values.emplace_back(s);
+        } else {
+            values.emplace_back();
+        }
+    }
+    *tuple = Tuple(std::move(values));
+    return true;
+}
+
+} // namespace
+
+// Rows appended to a run, written out a page at a time through the spill pool.
+class SortExecutor::RunWriter {
+public:
+    RunWriter(BufferPoolManager *pool, Run *run) : pool_(pool), run_(run) {}
+
+    bool Append(const Tuple &tuple, const RID &rid) {
+        size_t before = buffer_.size();
+        EncodeRow(tuple, rid, &buffer_);
+        run_->bytes += buffer_.size() - before;
+        size_t written = 0;
+        for (; buffer_.size() - written >= PAGE_SIZE; written += PAGE_SIZE) {
+            if (!WritePage(buffer_.data() + written, PAGE_SIZE)) return false;
+        }
+        buffer_.erase(0, written);
+        return true;
+    }
+
+    // Write the last, partly filled page.
+    bool Finish() { return buffer_.empty() || WritePage(buffer_.data(), buffer_.size()); }
+
+private:
+    bool WritePage(const char *data, size_t size) {
+        page_id_t page_id;
+        Page *page = pool_->NewPage(&page_id);
+        if (page == nullptr) return false;
+        memcpy(page->GetData(), data, size);
+        memset(page->GetData() + size, 0, PAGE_SIZE - size);
+        pool_->UnpinPage(page_id, true);
+        run_->pages.push_back(page_id);
+        return true;
+    }
+
+    BufferPoolManager *pool_;
+    Run *run_;
+    std::string buffer_;   // encoded rows not yet written, less than a page once Append returns
+};
+
+// The rows of a run, read from the spill file in chunks of SORT_READ_AHEAD_PAGES pages
+// straight through the disk scheduler: while one chunk is decoded the next is in flight.
+// The run's pages must be on disk. Alternatively, the sorted rows still held in memory.
+class SortExecutor::RunReader {
+public:
+    RunReader(DiskScheduler *io, const Run &run) : io_(io), run_(run), remaining_(run.bytes) {
+        for (auto &chunk : chunks_) chunk.resize(SORT_READ_AHEAD_PAGES * PAGE_SIZE);
+        Prefetch();
+    }
+
+    explicit RunReader(std::vector<Row> rows) : memory_(std::move(rows)), in_memory_(true) {}
+
+    ~RunReader() {
+        for (auto &read : pending_) read.wait();
+    }
+
+    // The next row of the run; false at its end, or on a read error.
+    bool Read(Row *row) {
+        if (in_memory_) {
+            if (memory_pos_ == memory_.size()) return false;
+            *row = std::move(memory_[memory_pos_++]);
+            return true;
+        }
+        uint32_t size;
+        if (remaining_ == 0 && pos_ == length_) return false;
+        if (!ReadBytes(reinterpret_cast<char *>(&size), sizeof(size))) return false;
+        scratch_.resize(size);
+        if (!ReadBytes(scratch_.data(), size) || !DecodeRow(scratch_, &row->tuple, &row->rid)) {
+            LOG_ERROR("A sort run read back from the spill file is corrupt.");
+            remaining_ = 0;
+            pos_ = length_;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    // Start reading the pages after those already requested into the idle chunk.
+    void Prefetch() {
+        char *dest = chunks_[1 - current_].data();
+        for (size_t i = 0; i < SORT_READ_AHEAD_PAGES && next_page_ < run_.pages.size(); ++i, ++next_page_) {
+            pending_.push_back(io_->Submit(false, run_.pages[next_page_], dest + i * PAGE_SIZE));
+        }
+    }
+
+    // Make the prefetched chunk current and start on the one after it.
+    bool NextChunk() {
+        if (pending_.empty()) return false;
+        bool ok = true;
+        for (auto &read : pending_) ok = read.get() && ok;
+        size_t pages = pending_.size();
+        pending_.clear();
+        if (!ok) {
+            LOG_ERROR("Could not read a sort run back from the spill file.");
+            remaining_ = 0;
+            return false;
+        }
+        current_ = 1 - current_;
+        pos_ = 0;
+        length_ = std::min(pages * PAGE_SIZE, remaining_);
+        remaining_ -= length_;
+        Prefetch();
+        return true;
+    }
+
+    bool ReadBytes(char *dest, size_t size) {
+        while (size > 0) {
+            if (pos_ == length_ && !NextChunk()) return false;
+            size_t n = std::min(size, length_ - pos_);
+            memcpy(dest, chunks_[current_].data() + pos_, n);
+            dest += n;
+            pos_ += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    DiskScheduler *io_ = nullptr;
+    Run run_;
+    size_t remaining_ = 0;              // bytes of the run not yet in a chunk
+    std::vector<char> chunks_[2];
+    size_t current_ = 0;
+    size_t pos_ = 0;                    // next byte of the current chunk
+    size_t length_ = 0;                 // bytes of the run in the current chunk
+    size_t next_page_ = 0;
+    std::vector<std::future<bool>> pending_;
+    std::string scratch_;
+
+    std::vector<Row> memory_;
+    bool in_memory_ = false;
+    size_t memory_pos_ = 0;
+};
+
+SortExecutor::SortExecutor(std::unique_ptr<Executor> child, std::vector<SortKey> keys, size_t limit,
+                           size_t memory_budget)
+    : child_(std::move(child)), keys_(std::move(keys)), limit_(limit), memory_budget_(memory_budget) {}
+
+SortExecutor::~SortExecutor() {
+    merge_.reset();
+    spill_io_.reset();
+    spill_pool_.reset();
+    spill_disk_.reset();
+    if (!spill_file_.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(spill_file_, ec);
+    }
+}
+
+bool SortExecutor::Before(const Tuple &a, size_t seq_a, const Tuple &b, size_t seq_b) const {
+    for (const SortKey &key : keys_) {
+        int cmp = CompareValues(a.GetValues()[key.col], b.GetValues()[key.col], key.numeric);
+        if (cmp != 0) return key.descending ? cmp > 0 : cmp < 0;
+    }
+    return seq_a < seq_b;
+}
+
+void SortExecutor::Build() {
+    built_ = true;
+    if (limit_ == 0) return;
+    bool bounded = limit_ != std::numeric_limits<size_t>::max();
+    auto before = [this](const Row &a, const Row &b) { return Before(a.tuple, a.seq, b.tuple, b.seq); };
+    RowBatch batch;
+    size_t seq = 0;
+    while (child_->Next(&batch)) {
+        for (size_t i = 0; i < batch.Size(); ++i, ++seq) {
+            if (!bounded || rows_.size() < limit_) {
+                memory_used_ += batch.tuples[i].GetFootprint();
+                rows_.push_back({std::move(batch.tuples[i]), batch.rids[i], seq});
+                if (bounded) std::push_heap(rows_.begin(), rows_.end(), before);
+                if (memory_used_ > memory_budget_ && !spill_failed_) {
+                    // A heap that no longer fits either turns into runs, cut off after limit_ rows.
+                    SpillRun();
+                    if (!spill_failed_) bounded = false;
+                    else if (bounded) std::make_heap(rows_.begin(), rows_.end(), before);
+                }
+                continue;
+            }
+            // Full: the row replaces the heap's last row only if it sorts before it.
+            if (!Before(batch.tuples[i], seq, rows_.front().tuple, rows_.front().seq)) continue;
+            std::pop_heap(rows_.begin(), rows_.end(), before);
+            memory_used_ += batch.tuples[i].GetFootprint() - rows_.back().tuple.GetFootprint();
+            rows_.back() = {std::move(batch.tuples[i]), batch.rids[i], seq};
+            std::push_heap(rows_.begin(), rows_.end(), before);
+        }
+    }
+    if (bounded) {
+        std::sort_heap(rows_.begin(), rows_.end(), before);
+    } else {
+        std::sort(rows_.begin(), rows_.end(), before);
+    }
+    if (runs_.empty()) return;
+
+    while (runs_.size() + 1 > SORT_MERGE_FAN_IN && MergePass()) {
+    }
+    merge_ = std::make_unique<Merge>();
+    OpenMerge(0, runs_.size(), &rows_, merge_.get());
+}
+
+void SortExecutor::SpillRun() {
+    if (spill_pool_ == nullptr) StartSpilling();
+    std::sort(rows_.begin(), rows_.end(),
+              [this](const Row &a, const Row &b) { return Before(a.tuple, a.seq, b.tuple, b.seq); });
+    Run run;
+    RunWriter writer(spill_pool_.get(), &run);
+    bool ok = true;
+    for (size_t i = 0; ok && i < rows_.size(); ++i) ok = writer.Append(rows_[i].tuple, rows_[i].rid);
+    if (!ok || !writer.Finish()) {
+        LOG_WARN("Could not write a sort run to '" << spill_file_ << "'; sorting the rest in memory.");
+        spill_failed_ = true;
+        return;
+    }
+    runs_.push_back(std::move(run));
+    rows_.clear();
+    memory_used_ = 0;
+}
+
+void SortExecutor::StartSpilling() {
+    spill_file_ = DiskManager::TempFileName("simpledb-sort");
+    spill_disk_ = std::make_unique<DiskManager>(spill_file_);
+    spill_pool_ = std::make_unique<BufferPoolManager>(SORT_SPILL_POOL_PAGES, spill_disk_.get());
+    spill_io_ = std::make_unique<DiskScheduler>(spill_disk_.get());
+}
+
+bool SortExecutor::MergePass() {
+    std::vector<Run> merged;
+    for (size_t first = 0; first < runs_.size(); first += SORT_MERGE_FAN_IN) {
+        size_t count = std::min(SORT_MERGE_FAN_IN, runs_.size() - first);
+        if (count == 1) {
+            merged.push_back(std::move(runs_[first]));
+            continue;
+        }
+        Merge merge;
+        Run run;
+        RunWriter writer(spill_pool_.get(), &run);
+        bool ok = OpenMerge(first, count, nullptr, &merge);
+        Row row;
+        while (ok && PopMerge(&merge, &row)) ok = writer.Append(row.tuple, row.rid);
+        if (!ok || !writer.Finish()) {
+            LOG_WARN("Could not write a merged sort run to '" << spill_file_ << "'; merging all runs at once.");
+            return false;
+        }
+        merged.push_back(std::move(run));
+    }
+    runs_ = std::move(merged);
+    return true;
+}
+
+bool SortExecutor::OpenMerge(size_t first, size_t count, std::vector<Row> *memory, Merge *merge) {
+    // Readers go around the buffer pool, so the runs' pages have to be on disk first.
+    if (!spill_pool_->FlushAllPages()) {
+        LOG_ERROR("Could not write sort runs to '" << spill_file_ << "'.");
+        return false;
+    }
+    for (size_t i = first; i < first + count; ++i) {
+        merge->readers.push_back(std::make_unique<RunReader>(spill_io_.get(), runs_[i]));
+    }
+    if (memory != nullptr && !memory->empty()) merge->readers.push_back(std::make_unique<RunReader>(std::move(*memory)));
+
+    auto after = [this](const Row &a, const Row &b) { return Before(b.tuple, b.seq, a.tuple, a.seq); };
+    for (size_t i = 0; i < merge->readers.size(); ++i) {
+        Row row;
+        if (!merge->readers[i]->Read(&row)) continue;
+        row.seq = i;
+        merge->heads.push_back(std::move(row));
+        std::push_heap(merge->heads.begin(), merge->heads.end(), after);
+    }
+    return true;
+}
+
+bool SortExecutor::PopMerge(Merge *merge, Row *row) {
+    if (merge->heads.empty()) return false;
+    auto after = [this](const Row &a, const Row &b) { return Before(b.tuple, b.seq, a.tuple, a.seq); };
+    std::pop_heap(merge->heads.begin(), merge->heads.end(), after);
+    *row = std::move(merge->heads.back());
+    size_t reader = row->seq;
+    if (merge->readers[reader]->Read(&merge->heads.back())) {
+        merge->heads.back().seq = reader;
+        std::push_heap(merge->heads.begin(), merge->heads.end(), after);
+    } else {
+        merge->heads.pop_back();
+    }
+    return true;
+}
+
+bool SortExecutor::Next(RowBatch *batch) {
+    batch->Clear();
+    if (!built_) Build();
+    if (merge_ != nullptr) {
+        Row row;
+        while (batch->Size() < EXECUTION_BATCH_SIZE && emitted_ < limit_ && PopMerge(merge_.get(), &row)) {
+            batch->rids.push_back(row.rid);
+            batch->tuples.push_back(std::move(row.tuple));
+            emitted_++;
+        }
+        return batch->Size() > 0;
+    }
+    while (pos_ < rows_.size() && batch->Size() < EXECUTION_BATCH_SIZE) {
+        batch->rids.push_back(rows_[pos_].rid);
+        batch->tuples.push_back(std::move(rows_[pos_].tuple));
+        pos_++;
+    }
+    return batch->Size() > 0;
+}
+
+} // namespace simpledb
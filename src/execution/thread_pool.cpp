@@ -0,0 +1,114 @@
+#include "execution/thread_pool.h"
+#include <algorithm>
+
+namespace simpledb {
+
+namespace {
+
+// The pool and queue of the worker running on this thread, if any.
+thread_local const ThreadPool *current_pool = nullptr;
+thread_local size_t current_queue = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t num_workers) {
+    for (size_t i = 0; i < num_workers; ++i) queues_.push_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < num_workers; ++i) workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(sleep_latch_);
+        stopping_ = true;
+    }
+    sleep_cv_.notify_all();
+    for (auto &worker : workers_) worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    if (workers_.empty()) {
+        task();
+        return;
+    }
+    size_t target = current_pool == this ? current_queue : next_queue_++ % queues_.size();
+    {
+        std::lock_guard<std::mutex> guard(queues_[target]->latch);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> guard(sleep_latch_);
+        pending_++;
+    }
+    sleep_cv_.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)> &body) {
+    // Shared with the helper tasks, which may only start after this call has returned.
+    struct Loop {
+        std::mutex latch;
+        std::condition_variable done_cv;
+        const std::function<void(size_t)> *body = nullptr;
+        size_t count = 0;
+        size_t next = 0;
+        size_t running = 0;
+    };
+    auto loop = std::make_shared<Loop>();
+    loop->body = &body;
+    loop->count = count;
+
+    auto run = [loop] {
+        std::unique_lock<std::mutex> lock(loop->latch);
+        if (loop->next >= loop->count) return;
+        loop->running++;
+        while (loop->next < loop->count) {
+            size_t i = loop->next++;
+            lock.unlock();
+            (*loop->body)(i);
+            lock.lock();
+        }
+        if (--loop->running == 0) loop->done_cv.notify_all();
+    };
+    size_t helpers = count == 0 ? 0 : std::min(workers_.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i) Submit(run);
+    run();
+
+    std::unique_lock<std::mutex> lock(loop->latch);
+    loop->done_cv.wait(lock, [&] { return loop->running == 0; });
+}
+
+void ThreadPool::WorkerLoop(size_t self) {
+    current_pool = this;
+    current_queue = self;
+    std::function<void()> task;
+    while (true) {
+        if (PopOrSteal(self, &task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_latch_);
+        sleep_cv_.wait(lock, [&] { return pending_ > 0 || stopping_; });
+        if (pending_ <= 0) return;
+    }
+}
+
+bool ThreadPool::PopOrSteal(size_t self, std::function<void()> *task) {
+    for (size_t k = 0; k < queues_.size(); ++k) {
+        Queue &queue = *queues_[(self + k) % queues_.size()];
+        std::lock_guard<std::mutex> guard(queue.latch);
+        if (queue.tasks.empty()) continue;
+        if (k == 0) {
+            *task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            *task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        std::lock_guard<std::mutex> sleep_guard(sleep_latch_);
+        pending_--;
+        return true;
+    }
+    return false;
+}
+
+} // namespace simpledb
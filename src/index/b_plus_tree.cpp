@@ -0,0 +1,209 @@
+#include "index/b_plus_tree.h"
+#include "common/logger.h"
+#include <climits>
+
+namespace simpledb {
+
+BPlusTree::BPlusTree(BufferPoolManager *bpm, page_id_t root_page_id)
+    : bpm_(bpm), root_page_id_(root_page_id) {}
+
+page_id_t BPlusTree::FindLeaf(const IndexKey &k, std::vector<page_id_t> *path) {
+    page_id_t page_id = root_page_id_;
+    while (page_id != INVALID_PAGE_ID) {
+        Page *page = bpm_->FetchPage(page_id, AccessType::INDEX);
+        if (page == nullptr) return INVALID_PAGE_ID;
+        BPlusTreeInternalPage node(page);
+        if (node.IsLeaf()) {
+            bpm_->UnpinPage(page_id, false);
+            return page_id;
+        }
+        page_id_t child = node.EntryAt(node.ChildIndex(k)).child;
+        bpm_->UnpinPage(page_id, false);
+        if (path != nullptr) path->push_back(page_id);
+        page_id = child;
+    }
+    return INVALID_PAGE_ID;
+}
+
+bool BPlusTree::Insert(int32_t key, const RID &rid) {
+    std::unique_lock<std::shared_mutex> guard(latch_);
+    IndexKey k(key, rid);
+
+    if (root_page_id_ == INVALID_PAGE_ID) {
+        page_id_t page_id;
+        Page *page = bpm_->NewPage(&page_id);
+        if (page == nullptr) return false;
+        BPlusTreeLeafPage leaf(page);
+        leaf.Init();
+        leaf.InsertAt(0, k);
+        bpm_->UnpinPage(page_id, true);
+        root_page_id_ = page_id;
+        return true;
+    }
+
+    std::vector<page_id_t> path;
+    page_id_t leaf_id = FindLeaf(k, &path);
+    Page *page = bpm_->FetchPage(leaf_id, AccessType::INDEX);
+    if (page == nullptr) return false;
+    BPlusTreeLeafPage leaf(page);
+
+    int32_t pos = leaf.LowerBound(k);
+    if (pos < leaf.GetSize() && leaf.KeyAt(pos) == k) {
+        bpm_->UnpinPage(leaf_id, false);
+        return false;
+    }
+    // A full leaf splits, and its full ancestors with it. Pin every node the split touches
+    // and take every new page it needs before changing anything, so running out of frames
+    // leaves the tree as it was.
+    std::vector<Page *> parents;
+    std::vector<Page *> spare;
+    if (leaf.GetSize() == BPlusTreeLeafPage::MAX_SIZE && !ReserveSplit(path, &parents, &spare)) {
+        bpm_->UnpinPage(leaf_id, false);
+        return false;
+    }
+    leaf.InsertAt(pos, k);
+    if (leaf.GetSize() <= BPlusTreeLeafPage::MAX_SIZE) {
+        bpm_->UnpinPage(leaf_id, true);
+        return true;
+    }
+
+    // Split: the upper half moves to a new right sibling.
+    Page *right_page = spare.back();
+    spare.pop_back();
+    page_id_t right_id = right_page->GetPageId();
+    BPlusTreeLeafPage right(right_page);
+    right.Init();
+    int32_t total = leaf.GetSize();
+    int32_t keep = total / 2;
+    for (int32_t i = keep; i < total; ++i) {
+        right.SetKeyAt(i - keep, leaf.KeyAt(i));
+    }
+    right.SetSize(total - keep);
+    leaf.SetSize(keep);
+    right.SetNextPageId(leaf.GetNextPageId());
+    leaf.SetNextPageId(right_id);
+    IndexKey separator = right.KeyAt(0);
+
+    bpm_->UnpinPage(right_id, true);
+    bpm_->UnpinPage(leaf_id, true);
+    InsertIntoParent(&parents, leaf_id, separator, right_id, &spare);
+    return true;
+}
+
+bool BPlusTree::ReserveSplit(const std::vector<page_id_t> &path, std::vector<Page *> *parents,
+                             std::vector<Page *> *spare) {
+    // The split climbs through full ancestors and stops at the first one with room; if
+    // there is none, it grows a new root. Each full node needs a new sibling page.
+    size_t needed = 1;
+    bool ok = true;
+    size_t depth = path.size();
+    for (; depth > 0; --depth) {
+        Page *page = bpm_->FetchPage(path[depth - 1], AccessType::INDEX);
+        if (page == nullptr) {
+            ok = false;
+            break;
+        }
+        parents->insert(parents->begin(), page);
+        if (BPlusTreeInternalPage(page).GetSize() < BPlusTreeInternalPage::MAX_SIZE) break;
+        needed++;
+    }
+    if (depth == 0) needed++;
+
+    while (ok && spare->size() < needed) {
+        page_id_t page_id;
+        Page *page = bpm_->NewPage(&page_id);
+        if (page == nullptr) ok = false;
+        else spare->push_back(page);
+    }
+    if (ok) return true;
+    for (Page *page : *parents) bpm_->UnpinPage(page->GetPageId(), false);
+    for (Page *page : *spare) bpm_->UnpinPage(page->GetPageId(), false);
+    parents->clear();
+    spare->clear();
+    LOG_ERROR("Buffer pool exhausted while splitting index node");
+    return false;
+}
+
+void BPlusTree::InsertIntoParent(std::vector<Page *> *parents, page_id_t left, const IndexKey &key,
+                                 page_id_t right, std::vector<Page *> *spare) {
+    if (parents->empty()) {
+        Page *page = spare->back();
+        spare->pop_back();
+        BPlusTreeInternalPage root(page);
+        root.Init();
+        root.InsertAt(0, {IndexKey(), left});
+        root.InsertAt(1, {key, right});
+        root_page_id_ = page->GetPageId();
+        bpm_->UnpinPage(root_page_id_, true);
+        return;
+    }
+
+    Page *page = parents->back();
+    parents->pop_back();
+    page_id_t parent_id = page->GetPageId();
+    BPlusTreeInternalPage parent(page);
+    parent.InsertAt(parent.IndexOfChild(left) + 1, {key, right});
+    if (parent.GetSize() <= BPlusTreeInternalPage::MAX_SIZE) {
+        bpm_->UnpinPage(parent_id, true);
+        return;
+    }
+
+    // Split the internal node; the first key of the right half moves up to the grandparent.
+    Page *sibling_page = spare->back();
+    spare->pop_back();
+    page_id_t sibling_id = sibling_page->GetPageId();
+    BPlusTreeInternalPage sibling(sibling_page);
+    sibling.Init();
+    int32_t total = parent.GetSize();
+    int32_t keep = total / 2;
+    for (int32_t i = keep; i < total; ++i) {
+        sibling.SetEntryAt(i - keep, parent.EntryAt(i));
+    }
+    sibling.SetSize(total - keep);
+    parent.SetSize(keep);
+    IndexKey separator = sibling.EntryAt(0).key;
+
+    bpm_->UnpinPage(sibling_id, true);
+    bpm_->UnpinPage(parent_id, true);
+    InsertIntoParent(parents, parent_id, separator, sibling_id, spare);
+}
+
+bool BPlusTree::Remove(int32_t key, const RID &rid) {
+    std::unique_lock<std::shared_mutex> guard(latch_);
+    if (root_page_id_ == INVALID_PAGE_ID) return false;
+    IndexKey k(key, rid);
+    page_id_t leaf_id = FindLeaf(k, nullptr);
+    Page *page = bpm_->FetchPage(leaf_id, AccessType::INDEX);
+    if (page == nullptr) return false;
+    BPlusTreeLeafPage leaf(page);
+    int32_t pos = leaf.LowerBound(k);
+    bool found = pos < leaf.GetSize() && leaf.KeyAt(pos) == k;
+    if (found) leaf.RemoveAt(pos);
+    bpm_->UnpinPage(leaf_id, found);
+    return found;
+}
+
+void BPlusTree::ScanRange(int32_t low, int32_t high, std::vector<RID> *result) {
+    std::shared_lock<std::shared_mutex> guard(latch_);
+    if (root_page_id_ == INVALID_PAGE_ID || low > high) return;
+    IndexKey start(low, RID(INT_MIN, 0));
+    page_id_t page_id = FindLeaf(start, nullptr);
+    while (page_id != INVALID_PAGE_ID) {
+        Page *page = bpm_->FetchPage(page_id, AccessType::INDEX);
+        if (page == nullptr) return;
+        BPlusTreeLeafPage leaf(page);
+        for (int32_t i = leaf.LowerBound(start); i < leaf.GetSize(); ++i) {
+            IndexKey k = leaf.KeyAt(i);
+            if (k.key > high) {
+                bpm_->UnpinPage(page_id, false);
+                return;
+            }
+            result->push_back(k.GetRID());
+        }
+        page_id_t next = leaf.GetNextPageId();
+        bpm_->UnpinPage(page_id, false);
+        page_id = next;
+    }
+}
+
+} // namespace simpledb
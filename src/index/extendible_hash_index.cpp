@@ -0,0 +1,231 @@
+#include "index/extendible_hash_index.h"
+#include "common/logger.h"
+
+namespace simpledb {
+
+ExtendibleHashIndex::ExtendibleHashIndex(BufferPoolManager *bpm, page_id_t header_page_id)
+    : bpm_(bpm), header_page_id_(header_page_id) {
+    if (header_page_id_ != INVALID_PAGE_ID) return;
+    Page *page = bpm_->NewPage(&header_page_id_);
+    if (page == nullptr) {
+        LOG_ERROR("Buffer pool exhausted while creating hash index");
+        header_page_id_ = INVALID_PAGE_ID;
+        return;
+    }
+    HashHeaderPage(page).Init();
+    bpm_->UnpinPage(header_page_id_, true);
+}
+
+uint32_t ExtendibleHashIndex::Hash(std::string_view key) {
+    // 64-bit FNV-1a folded to 32 bits, so both the header and directory bits are well mixed.
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+page_id_t ExtendibleHashIndex::GetDirectory(uint32_t hash, bool create) {
+    Page *page = bpm_->FetchPage(header_page_id_, AccessType::INDEX);
+    if (page == nullptr) return INVALID_PAGE_ID;
+    HashHeaderPage header(page);
+    uint32_t slot = HashHeaderPage::IndexOf(hash);
+    page_id_t dir_id = header.GetDirectoryPageId(slot);
+    if (dir_id != INVALID_PAGE_ID || !create) {
+        bpm_->UnpinPage(header_page_id_, false);
+        return dir_id;
+    }
+
+    page_id_t bucket_id;
+    Page *dir_page = bpm_->NewPage(&dir_id);
+    Page *bucket_page = dir_page != nullptr ? bpm_->NewPage(&bucket_id) : nullptr;
+    if (bucket_page == nullptr) {
+        if (dir_page != nullptr) bpm_->UnpinPage(dir_id, false);
+        bpm_->UnpinPage(header_page_id_, false);
+        LOG_ERROR("Buffer pool exhausted while growing hash index");
+        return INVALID_PAGE_ID;
+    }
+    HashBucketPage(bucket_page).Init();
+    HashDirectoryPage(dir_page).Init(bucket_id);
+    header.SetDirectoryPageId(slot, dir_id);
+    bpm_->UnpinPage(bucket_id, true);
+    bpm_->UnpinPage(dir_id, true);
+    bpm_->UnpinPage(header_page_id_, true);
+    return dir_id;
+}
+
+bool ExtendibleHashIndex::InsertEntry(const Value &key, const RID &rid) {
+    std::unique_lock<std::shared_mutex> guard(latch_);
+    uint32_t h = Hash(key.GetAsString());
+    page_id_t dir_id = GetDirectory(h, true);
+    if (dir_id == INVALID_PAGE_ID) return false;
+    Page *dir_page = bpm_->FetchPage(dir_id, AccessType::INDEX);
+    if (dir_page == nullptr) return false;
+    HashDirectoryPage dir(dir_page);
+    bool dir_dirty = false;
+    HashBucketPage::Entry entry{h, rid.GetPageId(), rid.GetSlotNum()};
+
+    while (true) {
+        uint32_t slot = dir.IndexOf(h);
+        page_id_t bucket_id = dir.GetBucketPageId(slot);
+        Page *bucket_page = bpm_->FetchPage(bucket_id, AccessType::INDEX);
+        if (bucket_page == nullptr) break;
+        HashBucketPage bucket(bucket_page);
+        if (!bucket.IsFull()) {
+            bucket.Append(entry);
+            bpm_->UnpinPage(bucket_id, true);
+            bpm_->UnpinPage(dir_id, dir_dirty);
+            return true;
+        }
+
+        // Splitting only helps if the full page holds some other hash value; a page of
+        // duplicates of this key goes straight to its overflow chain.
+        bool uniform = true;
+        for (uint32_t i = 0; i < bucket.GetSize() && uniform; ++i) {
+            uniform = bucket.EntryAt(i).hash == h;
+        }
+        if (!uniform && dir.GetLocalDepth(slot) < HashDirectoryPage::MAX_DEPTH) {
+            bpm_->UnpinPage(bucket_id, false);
+            if (!SplitBucket(dir, slot)) break;
+            dir_dirty = true;
+            continue;
+        }
+
+        bool ok = PushToChain(bucket_page);
+        if (ok) bucket.Append(entry);
+        bpm_->UnpinPage(bucket_id, ok);
+        bpm_->UnpinPage(dir_id, dir_dirty);
+        return ok;
+    }
+    bpm_->UnpinPage(dir_id, dir_dirty);
+    return false;
+}
+
+bool ExtendibleHashIndex::PushToChain(Page *head_page) {
+    page_id_t overflow_id;
+    Page *overflow_page = bpm_->NewPage(&overflow_id);
+    if (overflow_page == nullptr) {
+        LOG_ERROR("Buffer pool exhausted while extending hash bucket");
+        return false;
+    }
+    memcpy(overflow_page->GetData(), head_page->GetData(), PAGE_SIZE);
+    HashBucketPage head(head_page);
+    head.SetSize(0);
+    head.SetOverflowPageId(overflow_id);
+    bpm_->UnpinPage(overflow_id, true);
+    return true;
+}
+
+bool ExtendibleHashIndex::SplitBucket(HashDirectoryPage &dir, uint32_t dir_slot) {
+    uint32_t local_depth = dir.GetLocalDepth(dir_slot);
+    page_id_t old_id = dir.GetBucketPageId(dir_slot);
+
+    page_id_t new_id;
+    Page *new_page = bpm_->NewPage(&new_id);
+    if (new_page == nullptr) {
+        LOG_ERROR("Buffer pool exhausted while splitting hash bucket");
+        return false;
+    }
+    HashBucketPage new_bucket(new_page);
+    new_bucket.Init();
+
+    if (local_depth == dir.GetGlobalDepth()) dir.Grow();
+    uint32_t split_bit = 1u << local_depth;
+    for (uint32_t i = 0; i < dir.Size(); ++i) {
+        if (dir.GetBucketPageId(i) != old_id) continue;
+        dir.SetLocalDepth(i, local_depth + 1);
+        if (i & split_bit) dir.SetBucketPageId(i, new_id);
+    }
+
+    // Drain the old chain, then refill its pages in order with the entries that stay.
+    std::vector<HashBucketPage::Entry> keep;
+    std::vector<page_id_t> chain;
+    for (page_id_t pid = old_id; pid != INVALID_PAGE_ID;) {
+        Page *page = bpm_->FetchPage(pid, AccessType::INDEX);
+        if (page == nullptr) break;
+        HashBucketPage bucket(page);
+        for (uint32_t i = 0; i < bucket.GetSize(); ++i) {
+            HashBucketPage::Entry e = bucket.EntryAt(i);
+            if (e.hash & split_bit) {
+                if (new_bucket.IsFull()) PushToChain(new_page);
+                new_bucket.Append(e);
+            } else {
+                keep.push_back(e);
+            }
+        }
+        chain.push_back(pid);
+        page_id_t next = bucket.GetOverflowPageId();
+        bpm_->UnpinPage(pid, false);
+        pid = next;
+    }
+    bpm_->UnpinPage(new_id, true);
+
+    size_t pos = 0;
+    for (page_id_t pid : chain) {
+        Page *page = bpm_->FetchPage(pid, AccessType::INDEX);
+        if (page == nullptr) break;
+        HashBucketPage bucket(page);
+        bucket.SetSize(0);
+        while (pos < keep.size() && !bucket.IsFull()) bucket.Append(keep[pos++]);
+        bpm_->UnpinPage(pid, true);
+    }
+    return true;
+}
+
+bool ExtendibleHashIndex::DeleteEntry(const Value &key, const RID &rid) {
+    std::unique_lock<std::shared_mutex> guard(latch_);
+    uint32_t h = Hash(key.GetAsString());
+    page_id_t dir_id = GetDirectory(h, false);
+    if (dir_id == INVALID_PAGE_ID) return false;
+    Page *dir_page = bpm_->FetchPage(dir_id, AccessType::INDEX);
+    if (dir_page == nullptr) return false;
+    HashDirectoryPage dir(dir_page);
+    page_id_t pid = dir.GetBucketPageId(dir.IndexOf(h));
+    bpm_->UnpinPage(dir_id, false);
+
+    while (pid != INVALID_PAGE_ID) {
+        Page *page = bpm_->FetchPage(pid, AccessType::INDEX);
+        if (page == nullptr) return false;
+        HashBucketPage bucket(page);
+        for (uint32_t i = 0; i < bucket.GetSize(); ++i) {
+            HashBucketPage::Entry e = bucket.EntryAt(i);
+            if (e.hash == h && e.page_id == rid.GetPageId() && e.slot_num == rid.GetSlotNum()) {
+                bucket.RemoveAt(i);
+                bpm_->UnpinPage(pid, true);
+                return true;
+            }
+        }
+        page_id_t next = bucket.GetOverflowPageId();
+        bpm_->UnpinPage(pid, false);
+        pid = next;
+    }
+    return false;
+}
+
+void ExtendibleHashIndex::ScanKey(const Value &key, std::vector<RID> *result) {
+    std::shared_lock<std::shared_mutex> guard(latch_);
+    uint32_t h = Hash(key.GetAsString());
+    page_id_t dir_id = GetDirectory(h, false);
+    if (dir_id == INVALID_PAGE_ID) return;
+    Page *dir_page = bpm_->FetchPage(dir_id, AccessType::INDEX);
+    if (dir_page == nullptr) return;
+    HashDirectoryPage dir(dir_page);
+    page_id_t pid = dir.GetBucketPageId(dir.IndexOf(h));
+    bpm_->UnpinPage(dir_id, false);
+
+    while (pid != INVALID_PAGE_ID) {
+        Page *page = bpm_->FetchPage(pid, AccessType::INDEX);
+        if (page == nullptr) return;
+        HashBucketPage bucket(page);
+        for (uint32_t i = 0; i < bucket.GetSize(); ++i) {
+            HashBucketPage::Entry e = bucket.EntryAt(i);
+            if (e.hash == h) result->emplace_back(e.page_id, e.slot_num);
+        }
+        page_id_t next = bucket.GetOverflowPageId();
+        bpm_->UnpinPage(pid, false);
+        pid = next;
+    }
+}
+
+} // namespace simpledb
@@ -1,16 +1,43 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <vector>
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <memory>
 #include <iomanip>
-
+#include <atomic>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <fstream>
+#include <filesystem>
+#include <shared_mutex>
+#include <thread>
+#include <chrono>
+
+#include "common/alloc_stats.h"
+#include "common/arena.h"
 #include "common/logger.h"
 #include "storage/disk_manager.h"
+#include "storage/buffer_pool_manager.h"
+#include "storage/csv_loader.h"
+#include "storage/table_page.h"
+#include "storage/vacuum_manager.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
 #include "catalog/catalog.h"
 #include "catalog/type_id.h"
+#include "execution/executor.h"
+#include "execution/hash_join_executor.h"
+#include "execution/sort_executor.h"
+#include "execution/predicate.h"
+#include "execution/thread_pool.h"
 
 using namespace simpledb;
 
@@ -24,6 +51,35 @@ static inline void trim(std::string &s) {
     ltrim(s);
     rtrim(s);
 }
+static inline std::string_view trimmed(std::string_view s) {
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+    return s;
+}
+
+void InsertIndexEntries(Catalog &catalog, TableInfo *table, const Tuple &tuple, const RID &rid) {
+    for (IndexInfo *index : catalog.GetTableIndexes(table->name_)) {
+        index->index_->InsertEntry(tuple.GetValue(table->schema_.get(), index->key_col_), rid);
+    }
+}
+
+void RemoveIndexEntries(Catalog &catalog, TableInfo *table, const Tuple &tuple, const RID &rid) {
+    for (IndexInfo *index : catalog.GetTableIndexes(table->name_)) {
+        index->index_->DeleteEntry(tuple.GetValue(table->schema_.get(), index->key_col_), rid);
+    }
+}
+
+// Re-point index entries whose key or RID changed with an update.
+void UpdateIndexEntries(Catalog &catalog, TableInfo *table, const Tuple &old_tuple, const RID &old_rid,
+                        const Tuple &new_tuple, const RID &new_rid) {
+    for (IndexInfo *index : catalog.GetTableIndexes(table->name_)) {
+        const Value &old_key = old_tuple.GetValue(table->schema_.get(), index->key_col_);
+        const Value &new_key = new_tuple.GetValue(table->schema_.get(), index->key_col_);
+        if (old_key == new_key && old_rid == new_rid) continue;
+        index->index_->DeleteEntry(old_key, old_rid);
+        index->index_->InsertEntry(new_key, new_rid);
+    }
+}
 
 bool ExecuteMakeTable(Catalog &catalog, const std::string &query, bool is_replaying = false) {
     size_t start_paren = query.find('(');
@@ -78,242 +134,461 @@ bool ExecuteMakeTable(Catalog &catalog, const std::string &query, bool is_replay
     }
 }
 
-void ExecuteShow(Catalog &catalog, const std::string &query) {
-    size_t from_pos = query.find(" from ");
-    if (from_pos == std::string::npos || from_pos <= 5) {
-        LOG_ERROR("Syntax error. Expected: show <cols> from <table>");
-        return;
+bool ExecuteMakeIndex(Catalog &catalog, const std::string &query, bool is_replaying = false) {
+    size_t on_pos = query.find(" on ");
+    size_t start_paren = query.find('(', on_pos == std::string::npos ? 0 : on_pos);
+    size_t end_paren = query.rfind(')');
+    if (on_pos == std::string::npos || start_paren == std::string::npos || end_paren == std::string::npos ||
+        end_paren < start_paren) {
+        LOG_ERROR("Syntax error. Expected: make index <name> on <table>(<col>)");
+        return false;
     }
-    
-    std::string cols_part = query.substr(5, from_pos - 5);
-    trim(cols_part);
 
-    size_t where_pos = query.find(" where ", from_pos);
-    std::string table_name = (where_pos == std::string::npos) ? query.substr(from_pos + 6) : query.substr(from_pos + 6, where_pos - (from_pos + 6));
-    trim(table_name);
-    if (!table_name.empty() && table_name.back() == ';') table_name.pop_back();
+    std::string index_name = query.substr(10, on_pos - 10);
+    std::string table_name = query.substr(on_pos + 4, start_paren - (on_pos + 4));
+    std::string col_name = query.substr(start_paren + 1, end_paren - start_paren - 1);
+    trim(index_name); trim(table_name); trim(col_name);
 
     TableInfo *table = catalog.GetTable(table_name);
     if (!table) {
         LOG_ERROR("Table '" << table_name << "' not found.");
-        return;
+        return false;
     }
 
-    std::vector<std::string> target_cols;
-    bool show_all = false;
-    if (cols_part == "all" || cols_part == "*") {
-        show_all = true;
+    int32_t col_idx = table->schema_->GetColIdx(col_name);
+    if (col_idx == -1) {
+        LOG_ERROR("Column '" << col_name << "' not found in table.");
+        return false;
+    }
+    if (!catalog.CreateIndex(index_name, table_name, col_idx)) {
+        if (!is_replaying) LOG_ERROR("Index '" << index_name << "' already exists.");
+        return false;
+    }
+    if (!is_replaying) LOG_INFO("Index '" << index_name << "' created on " << table_name << "(" << col_name << ").");
+    return true;
+}
+
+void ExecuteShowDatabase(Catalog &catalog, const std::string &db_name) {
+    LOG_INFO("Tables in database '" << db_name << "':");
+    std::vector<std::string> tables = catalog.GetTableNames();
+    if (tables.empty()) {
+        std::cout << "(No tables found)\n";
     } else {
-        std::stringstream ss(cols_part);
-        std::string c;
-        while (std::getline(ss, c, ',')) {
-            trim(c);
-            target_cols.push_back(c);
+        for (const auto& name : tables) {
+            std::cout << "- " << name << "\n";
         }
     }
+}
 
-    std::vector<int32_t> display_col_indices;
-    const Schema &schema = *table->schema_;
-    if (show_all) {
-        for (uint32_t i = 0; i < schema.GetColumnCount(); ++i) {
-            display_col_indices.push_back(i);
+enum class StatementType { SHOW, INSERT, CHANGE, REMOVE, DELETE };
+
+// A parsed show / insert / change / remove statement, ready to run any number of times.
+// Literals written as ? are parameters, numbered left to right and filled in by BindPlan.
+struct Plan {
+    StatementType type = StatementType::SHOW;
+    std::string table_name;
+    std::vector<int32_t> columns;   // SHOW: columns to display; CHANGE: the column to set
+    std::vector<Tuple> rows;        // INSERT: the rows
+    std::vector<Value> values;      // CHANGE: the new value
+    bool has_where = false;
+    Predicate where;
+    int64_t limit = -1;             // SHOW: most rows to print, -1 for no limit
+    int64_t offset = 0;             // SHOW: rows to skip before the limit applies
+    std::vector<SortKey> order_by;  // SHOW: columns of the scanned (or aggregated) row to sort on
+    std::vector<std::string> headers;       // SHOW: output column titles
+
+    // SHOW with group by or aggregates: rows are grouped on group_by, and columns index
+    // the aggregated row, which holds the group_by values followed by the aggregates.
+    std::vector<int32_t> group_by;
+    std::vector<AggregateExpr> aggregates;
+
+    // SHOW from "<table_name> join <join_table> on ...": rows hold table_name's values
+    // followed by join_table's, described by join_schema, whose columns are named
+    // "<table>.<col>". The join keys index each table's own row.
+    std::string join_table;
+    std::shared_ptr<Schema> join_schema;
+    uint32_t join_left_key = 0;
+    uint32_t join_right_key = 0;
+
+    // Where a parameter goes: values[value] (for an INSERT, column value % n of rows[value / n],
+    // n being the column count), or the comparison at where.nodes[node]
+    struct Param {
+        int32_t value = -1;
+        int32_t node = -1;
+    };
+    std::vector<Param> params;
+
+    bool IsMutation() const { return type != StatementType::SHOW; }
+    bool IsAggregate() const { return !group_by.empty() || !aggregates.empty(); }
+};
+
+// Split a comma separated argument list into trimmed views of text, leaving commas inside
+// quotes alone.
+void SplitArguments(std::string_view text, ScratchVector<std::string_view> *args) {
+    size_t start = 0;
+    char quote = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (quote != 0) {
+            if (c == quote) quote = 0;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+        } else if (c == ',') {
+            args->push_back(trimmed(text.substr(start, i - start)));
+            start = i + 1;
         }
-    } else {
-        for (const auto& c : target_cols) {
-            int32_t idx = schema.GetColIdx(c);
-            if (idx == -1) {
-                LOG_ERROR("Column '" << c << "' not found for selection.");
-                return;
-            }
-            display_col_indices.push_back(idx);
+    }
+    std::string_view last = trimmed(text.substr(start));
+    if (!last.empty() || !args->empty()) args->push_back(last);
+}
+
+// Convert a literal as written in a statement to a value for column; quotes around
+// strings are dropped. An integer is read the way std::stoi reads it: an optional sign,
+// then digits, with anything after them ignored.
+bool ParseValue(const Column &column, std::string_view literal, Value *value) {
+    literal = trimmed(literal);
+    if (column.GetType() == TypeId::INTEGER) {
+        std::string_view digits = literal;
+        if (digits.size() > 1 && digits[0] == '+' && digits[1] != '-') digits.remove_prefix(1);
+        int32_t parsed;
+        if (std::from_chars(digits.data(), digits.data() + digits.size(), parsed).ec != std::errc()) {
+            LOG_ERROR("Expected an integer value for column '" << column.GetName() << "'.");
+            return false;
         }
+        *value = Value(parsed);
+        return true;
+    }
+    if (literal.size() >= 2 && ((literal.front() == '\'' && literal.back() == '\'') ||
+                                (literal.front() == '"' && literal.back() == '"'))) {
+        literal = literal.substr(1, literal.size() - 2);
     }
+    *value = Value(literal);
+    return true;
+}
 
-    std::string col_name, val_str;
-    int32_t filter_col_idx = -1;
-    if (where_pos != std::string::npos) {
-        std::string cond_part = query.substr(where_pos + 7);
-        trim(cond_part);
+// Parse a where clause into plan, registering its parameters.
+bool PlanWhere(const Schema &schema, const std::string &where_part, bool allow_params, Plan *plan) {
+    plan->has_where = true;
+    if (!ParsePredicate(schema, where_part, &plan->where, allow_params)) return false;
+    for (int32_t node : plan->where.params) plan->params.push_back({-1, node});
+    return true;
+}
 
-        size_t eq_pos = cond_part.find('=');
-        if (eq_pos == std::string::npos) {
-            LOG_ERROR("Syntax error: missing '=' in where clause.");
-            return;
-        }
+// Parse an aggregate call such as count(*) or sum(price) from a select list.
+bool ParseAggregate(const Schema &schema, const std::string &item, AggregateExpr *agg) {
+    size_t open = item.find('(');
+    if (item.back() != ')') {
+        LOG_ERROR("Syntax error: missing ')' in '" << item << "'.");
+        return false;
+    }
+    std::string name = item.substr(0, open);
+    std::string arg = item.substr(open + 1, item.size() - open - 2);
+    trim(name); trim(arg);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    if (name == "count") {
+        agg->type = AggregateType::COUNT;
+    } else if (name == "sum") {
+        agg->type = AggregateType::SUM;
+    } else if (name == "min") {
+        agg->type = AggregateType::MIN;
+    } else if (name == "max") {
+        agg->type = AggregateType::MAX;
+    } else if (name == "avg") {
+        agg->type = AggregateType::AVG;
+    } else {
+        LOG_ERROR("Unknown aggregate '" << name << "'. Expected count, sum, min, max or avg.");
+        return false;
+    }
+    if (agg->type == AggregateType::COUNT && arg == "*") {
+        agg->col = -1;
+        return true;
+    }
+    agg->col = schema.GetColIdx(arg);
+    if (agg->col == -1) {
+        LOG_ERROR("Column '" << arg << "' not found for " << name << ".");
+        return false;
+    }
+    if ((agg->type == AggregateType::SUM || agg->type == AggregateType::AVG) &&
+        schema.GetColumn(agg->col).GetType() != TypeId::INTEGER) {
+        LOG_ERROR(name << " needs an integer column, but '" << arg << "' is not one.");
+        return false;
+    }
+    return true;
+}
 
-        col_name = cond_part.substr(0, eq_pos);
-        val_str = cond_part.substr(eq_pos + 1);
-        trim(col_name); trim(val_str);
-        if (!val_str.empty() && val_str.back() == ';') val_str.pop_back();
+// "<left> join <right> on <col> = <col>": the joined tables, their combined schema and the
+// key column on each side.
+bool PlanJoin(Catalog &catalog, const std::string &from_part, Plan *plan) {
+    size_t join_pos = from_part.find(" join ");
+    size_t on_pos = from_part.find(" on ", join_pos);
+    if (on_pos == std::string::npos) {
+        LOG_ERROR("Syntax error. Expected: show <cols> from <table> join <table> on <col> = <col>");
+        return false;
+    }
+    std::string left_name = from_part.substr(0, join_pos);
+    std::string right_name = from_part.substr(join_pos + 6, on_pos - join_pos - 6);
+    std::string on_part = from_part.substr(on_pos + 4);
+    trim(left_name); trim(right_name); trim(on_part);
+
+    TableInfo *left = catalog.GetTable(left_name);
+    TableInfo *right = catalog.GetTable(right_name);
+    if (!left || !right) {
+        LOG_ERROR("Table '" << (left ? right_name : left_name) << "' not found.");
+        return false;
+    }
+    if (left == right) {
+        LOG_ERROR("Joining a table with itself is not supported.");
+        return false;
+    }
 
-        filter_col_idx = table->schema_->GetColIdx(col_name);
-        if (filter_col_idx == -1) {
-            LOG_ERROR("Column '" << col_name << "' not found in table.");
-            return;
-        }
+    std::vector<Column> columns;
+    for (const Column &column : left->schema_->GetColumns()) columns.emplace_back(left_name + "." + column.GetName(), column.GetType());
+    for (const Column &column : right->schema_->GetColumns()) columns.emplace_back(right_name + "." + column.GetName(), column.GetType());
+    plan->join_schema = std::make_shared<Schema>(columns);
+
+    size_t eq_pos = on_part.find('=');
+    if (eq_pos == std::string::npos) {
+        LOG_ERROR("Syntax error. Expected: on <col> = <col>");
+        return false;
+    }
+    std::string first = on_part.substr(0, eq_pos);
+    std::string second = on_part.substr(eq_pos + 1);
+    trim(first); trim(second);
+    int32_t first_idx = plan->join_schema->GetColIdx(first);
+    int32_t second_idx = plan->join_schema->GetColIdx(second);
+    if (first_idx == -1 || second_idx == -1) {
+        LOG_ERROR("Column '" << (first_idx == -1 ? first : second) << "' not found for join.");
+        return false;
     }
 
-    for (int32_t idx : display_col_indices) {
-        std::cout << std::left << std::setw(20) << schema.GetColumn(idx).GetName() << " | ";
+    int32_t left_count = static_cast<int32_t>(left->schema_->GetColumnCount());
+    if ((first_idx < left_count) == (second_idx < left_count)) {
+        LOG_ERROR("The join condition must compare a column of '" << left_name << "' with one of '" << right_name << "'.");
+        return false;
+    }
+    if (first_idx > second_idx) std::swap(first_idx, second_idx);
+    if (columns[first_idx].GetType() != columns[second_idx].GetType()) {
+        LOG_ERROR("Cannot join '" << first << "' and '" << second << "': their types differ.");
+        return false;
     }
-    std::cout << "\n------------------------------------------------------\n";
+    plan->table_name = left_name;
+    plan->join_table = right_name;
+    plan->join_left_key = static_cast<uint32_t>(first_idx);
+    plan->join_right_key = static_cast<uint32_t>(second_idx - left_count);
+    return true;
+}
+
+// A row count as written after limit or offset: up to 18 digits.
+bool ParseRowCount(const std::string &word, int64_t *count) {
+    if (word.empty() || word.size() > 18 || word.find_first_not_of("0123456789") != std::string::npos) return false;
+    *count = std::stoll(word);
+    return true;
+}
+
+// "<n>" or "<n> offset <m>", the text after limit.
+bool ParseLimit(const std::string &text, int64_t *limit, int64_t *offset) {
+    std::stringstream ss(text);
+    std::string count, keyword, skip, extra;
+    ss >> count >> keyword >> skip >> extra;
+    if (!extra.empty() || !ParseRowCount(count, limit)) return false;
+    if (keyword.empty()) return true;
+    return keyword == "offset" && ParseRowCount(skip, offset);
+}
 
-    size_t count = 0;
-    for (const auto &tuple : table->tuples_) {
-        bool match = true;
-        if (filter_col_idx != -1) {
-            Value v = tuple.GetValue(&schema, filter_col_idx);
-            match = false;
-            if (v.GetTypeId() == TypeId::INTEGER && std::to_string(v.GetAsInt()) == val_str) match = true;
-            if (v.GetTypeId() == TypeId::VARCHAR && v.GetAsString() == val_str) match = true;
-            if (v.GetTypeId() == TypeId::VARCHAR && val_str.front() == '\'' && val_str.back() == '\'') {
-                std::string unquoted = val_str.substr(1, val_str.size() - 2);
-                if (v.GetAsString() == unquoted) match = true;
+// Resolve the items of an order by, each "<col> [asc | desc]". Without aggregates they name
+// columns of the scanned row; with them, a group by column or an aggregate, which is added
+// to the plan if the select list does not compute it.
+bool PlanOrderBy(const Schema &schema, const std::string &order_part, Plan *plan) {
+    const int32_t key_count = static_cast<int32_t>(plan->group_by.size());
+    std::stringstream ss(order_part);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        trim(item);
+        SortKey key;
+        size_t space = item.find_last_of(' ');
+        if (space != std::string::npos) {
+            std::string direction = item.substr(space + 1);
+            std::transform(direction.begin(), direction.end(), direction.begin(), ::tolower);
+            if (direction == "asc" || direction == "desc") {
+                key.descending = direction == "desc";
+                item.erase(space);
+                trim(item);
             }
         }
 
-        if (match) {
-            for (int32_t idx : display_col_indices) {
-                std::cout << std::left << std::setw(20) << tuple.GetValue(&schema, idx).ToString() << " | ";
+        if (plan->IsAggregate() && item.find('(') != std::string::npos) {
+            AggregateExpr agg;
+            if (!ParseAggregate(schema, item, &agg)) return false;
+            auto same = std::find_if(plan->aggregates.begin(), plan->aggregates.end(), [&](const AggregateExpr &other) {
+                return other.type == agg.type && other.col == agg.col;
+            });
+            if (same == plan->aggregates.end()) same = plan->aggregates.insert(same, agg);
+            key.col = key_count + static_cast<int32_t>(same - plan->aggregates.begin());
+            key.numeric = agg.type != AggregateType::MIN && agg.type != AggregateType::MAX;
+        } else {
+            key.col = schema.GetColIdx(item);
+            if (key.col == -1) {
+                LOG_ERROR("Column '" << item << "' not found for order by.");
+                return false;
+            }
+            if (plan->IsAggregate()) {
+                auto group = std::find(plan->group_by.begin(), plan->group_by.end(), key.col);
+                if (group == plan->group_by.end()) {
+                    LOG_ERROR("Column '" << item << "' must be in the group by list to order by it.");
+                    return false;
+                }
+                key.col = static_cast<int32_t>(group - plan->group_by.begin());
             }
-            std::cout << "\n";
-            count++;
         }
+        plan->order_by.push_back(key);
     }
-    LOG_INFO(count << " rows returned.");
+    return true;
 }
 
-void ExecuteShowDatabase(Catalog &catalog, const std::string &db_name) {
-    LOG_INFO("Tables in database '" << db_name << "':");
-    std::vector<std::string> tables = catalog.GetTableNames();
-    if (tables.empty()) {
-        std::cout << "(No tables found)\n";
-    } else {
-        for (const auto& name : tables) {
-            std::cout << "- " << name << "\n";
-        }
+bool PlanShow(Catalog &catalog, const std::string &statement, bool allow_params, Plan *plan) {
+    // An optional trailing "limit <n> [offset <m>]" pages through the rows printed.
+    std::string query = statement;
+    while (!query.empty() && (query.back() == ';' || std::isspace(static_cast<unsigned char>(query.back())))) {
+        query.pop_back();
+    }
+    size_t limit_pos = query.rfind(" limit ");
+    if (limit_pos != std::string::npos && ParseLimit(query.substr(limit_pos + 7), &plan->limit, &plan->offset)) {
+        query.erase(limit_pos);
     }
-}
 
-bool ExecuteRemoveFrom(Catalog &catalog, const std::string &query, bool is_replaying = false) {
-    size_t where_pos = query.find(" where ");
-    if (where_pos == std::string::npos) {
-        LOG_ERROR("Syntax error. Expected: remove from <table> where <col> = <val>");
+    size_t from_pos = query.find(" from ");
+    if (from_pos == std::string::npos || from_pos <= 5) {
+        LOG_ERROR("Syntax error. Expected: show <cols> from <table>");
         return false;
     }
 
-    std::string table_name = query.substr(12, where_pos - 12);
-    trim(table_name);
-
-    std::string cond_part = query.substr(where_pos + 7);
-    trim(cond_part);
+    std::string cols_part = query.substr(5, from_pos - 5);
+    trim(cols_part);
 
-    size_t eq_pos = cond_part.find('=');
-    if (eq_pos == std::string::npos) {
-         LOG_ERROR("Syntax error: missing '=' in where clause.");
-         return false;
+    // An optional "order by <cols>" comes before the limit, and "group by <cols>" before that.
+    std::string order_part;
+    size_t order_pos = query.rfind(" order by ");
+    if (order_pos != std::string::npos && order_pos > from_pos) {
+        order_part = query.substr(order_pos + 10);
+        query.erase(order_pos);
+    }
+    std::string group_part;
+    size_t group_pos = query.rfind(" group by ");
+    if (group_pos != std::string::npos && group_pos > from_pos) {
+        group_part = query.substr(group_pos + 10);
+        query.erase(group_pos);
     }
-    
-    std::string col_name = cond_part.substr(0, eq_pos);
-    std::string val_str = cond_part.substr(eq_pos + 1);
-    trim(col_name); trim(val_str);
-    if (!val_str.empty() && val_str.back() == ';') val_str.pop_back();
 
-    TableInfo *table = catalog.GetTable(table_name);
-    if (!table) {
-        LOG_ERROR("Table not found.");
+    size_t where_pos = query.find(" where ", from_pos);
+    std::string table_name = (where_pos == std::string::npos) ? query.substr(from_pos + 6) : query.substr(from_pos + 6, where_pos - (from_pos + 6));
+    trim(table_name);
+    if (!table_name.empty() && table_name.back() == ';') table_name.pop_back();
+
+    plan->type = StatementType::SHOW;
+    if (table_name.find(" join ") != std::string::npos) {
+        if (!PlanJoin(catalog, table_name, plan)) return false;
+    } else if (!catalog.GetTable(table_name)) {
+        LOG_ERROR("Table '" << table_name << "' not found.");
         return false;
+    } else {
+        plan->table_name = table_name;
     }
 
-    int32_t col_idx = table->schema_->GetColIdx(col_name);
-    if (col_idx == -1) {
-        LOG_ERROR("Column not found in table.");
-        return false;
+    const Schema &schema = plan->join_schema ? *plan->join_schema : *catalog.GetTable(plan->table_name)->schema_;
+    if (!group_part.empty()) {
+        std::stringstream ss(group_part);
+        std::string c;
+        while (std::getline(ss, c, ',')) {
+            trim(c);
+            int32_t idx = schema.GetColIdx(c);
+            if (idx == -1) {
+                LOG_ERROR("Column '" << c << "' not found for group by.");
+                return false;
+            }
+            plan->group_by.push_back(idx);
+        }
     }
 
-    size_t removed = 0;
-    auto it = table->tuples_.begin();
-    while (it != table->tuples_.end()) {
-        Value v = it->GetValue(table->schema_.get(), col_idx);
-        bool match = false;
-        if (v.GetTypeId() == TypeId::INTEGER && std::to_string(v.GetAsInt()) == val_str) match = true;
-        if (v.GetTypeId() == TypeId::VARCHAR && v.GetAsString() == val_str) match = true;
-        if (v.GetTypeId() == TypeId::VARCHAR && val_str.front() == '\'' && val_str.back() == '\'') {
-             std::string unquoted = val_str.substr(1, val_str.size() - 2);
-             if (v.GetAsString() == unquoted) match = true;
+    if (cols_part == "all" || cols_part == "*") {
+        if (!plan->group_by.empty()) {
+            LOG_ERROR("Select the group by columns and aggregates by name when using group by.");
+            return false;
+        }
+        for (uint32_t i = 0; i < schema.GetColumnCount(); ++i) {
+            plan->columns.push_back(i);
+            plan->headers.push_back(schema.GetColumn(i).GetName());
+        }
+    } else {
+        // Each item is a column or an aggregate; plain columns index the table row until
+        // the plan turns out to aggregate, and are then mapped onto the group by values.
+        std::vector<bool> is_aggregate;
+        std::stringstream ss(cols_part);
+        std::string c;
+        while (std::getline(ss, c, ',')) {
+            trim(c);
+            plan->headers.push_back(c);
+            if (c.find('(') != std::string::npos) {
+                AggregateExpr agg;
+                if (!ParseAggregate(schema, c, &agg)) return false;
+                plan->columns.push_back(static_cast<int32_t>(plan->aggregates.size()));
+                plan->aggregates.push_back(agg);
+                is_aggregate.push_back(true);
+                continue;
+            }
+            int32_t idx = schema.GetColIdx(c);
+            if (idx == -1) {
+                LOG_ERROR("Column '" << c << "' not found for selection.");
+                return false;
+            }
+            plan->columns.push_back(idx);
+            is_aggregate.push_back(false);
         }
 
-        if (match) {
-            it = table->tuples_.erase(it);
-            removed++;
-        } else {
-            ++it;
+        if (plan->IsAggregate()) {
+            int32_t key_count = static_cast<int32_t>(plan->group_by.size());
+            for (size_t i = 0; i < plan->columns.size(); ++i) {
+                if (is_aggregate[i]) {
+                    plan->columns[i] += key_count;
+                    continue;
+                }
+                auto key = std::find(plan->group_by.begin(), plan->group_by.end(), plan->columns[i]);
+                if (key == plan->group_by.end()) {
+                    LOG_ERROR("Column '" << plan->headers[i] << "' must be in the group by list or inside an aggregate.");
+                    return false;
+                }
+                plan->columns[i] = static_cast<int32_t>(key - plan->group_by.begin());
+            }
         }
     }
-    if (!is_replaying) LOG_INFO("Removed " << removed << " rows.");
-    return true;
+
+    if (!order_part.empty() && !PlanOrderBy(schema, order_part, plan)) return false;
+    return where_pos == std::string::npos || PlanWhere(schema, query.substr(where_pos + 7), allow_params, plan);
 }
 
-bool ExecuteDeleteFrom(Catalog &catalog, const std::string &query, bool is_replaying = false) {
+// remove from <table> where ... and delete from <table> where ... differ only in wording.
+bool PlanRemove(Catalog &catalog, const std::string &query, StatementType type, bool allow_params, Plan *plan) {
     size_t where_pos = query.find(" where ");
     if (where_pos == std::string::npos) {
-        LOG_ERROR("Syntax error. Expected: delete from <table> where <col> = <val>");
+        LOG_ERROR("Syntax error. Expected: " << (type == StatementType::DELETE ? "delete" : "remove")
+                  << " from <table> where <condition>");
         return false;
     }
 
     std::string table_name = query.substr(12, where_pos - 12);
     trim(table_name);
 
-    std::string cond_part = query.substr(where_pos + 7);
-    trim(cond_part);
-
-    size_t eq_pos = cond_part.find('=');
-    if (eq_pos == std::string::npos) {
-         LOG_ERROR("Syntax error: missing '=' in where clause.");
-         return false;
-    }
-    
-    std::string col_name = cond_part.substr(0, eq_pos);
-    std::string val_str = cond_part.substr(eq_pos + 1);
-    trim(col_name); trim(val_str);
-    if (!val_str.empty() && val_str.back() == ';') val_str.pop_back();
-
     TableInfo *table = catalog.GetTable(table_name);
     if (!table) {
         LOG_ERROR("Table not found.");
         return false;
     }
-
-    int32_t col_idx = table->schema_->GetColIdx(col_name);
-    if (col_idx == -1) {
-        LOG_ERROR("Column not found in table.");
-        return false;
-    }
-
-    size_t removed = 0;
-    auto it = table->tuples_.begin();
-    while (it != table->tuples_.end()) {
-        Value v = it->GetValue(table->schema_.get(), col_idx);
-        bool match = false;
-        if (v.GetTypeId() == TypeId::INTEGER && std::to_string(v.GetAsInt()) == val_str) match = true;
-        if (v.GetTypeId() == TypeId::VARCHAR && v.GetAsString() == val_str) match = true;
-        if (v.GetTypeId() == TypeId::VARCHAR && val_str.front() == '\'' && val_str.back() == '\'') {
-             std::string unquoted = val_str.substr(1, val_str.size() - 2);
-             if (v.GetAsString() == unquoted) match = true;
-        }
-
-        if (match) {
-            it = table->tuples_.erase(it);
-            removed++;
-        } else {
-            ++it;
-        }
-    }
-    if (!is_replaying) LOG_INFO("Deleted " << removed << " rows.");
-    return true;
+    plan->type = type;
+    plan->table_name = table_name;
+    return PlanWhere(*table->schema_, query.substr(where_pos + 7), allow_params, plan);
 }
 
-bool ExecuteChangeTable(Catalog &catalog, const std::string &query, bool is_replaying = false) {
+bool PlanChange(Catalog &catalog, const std::string &query, bool allow_params, Plan *plan) {
     size_t set_pos = query.find(" set ");
     if (set_pos == std::string::npos) {
         LOG_ERROR("Syntax error. Expected: change <table> set <col> = <val>");
@@ -348,159 +623,874 @@ bool ExecuteChangeTable(Catalog &catalog, const std::string &query, bool is_repl
          LOG_ERROR("Column not found.");
          return false;
     }
+    plan->type = StatementType::CHANGE;
+    plan->table_name = table_name;
+    plan->columns.push_back(col_idx);
+    plan->values.emplace_back();
+    if (allow_params && val_str == "?") {
+        plan->params.push_back({0, -1});
+    } else if (!ParseValue(table->schema_->GetColumn(col_idx), val_str, &plan->values[0])) {
+        return false;
+    }
 
-    int32_t filter_col_idx = -1;
-    std::string filter_val_str;
-    if (where_pos != std::string::npos) {
-        std::string cond_part = query.substr(where_pos + 7);
-        trim(cond_part);
+    return where_pos == std::string::npos ||
+           PlanWhere(*table->schema_, query.substr(where_pos + 7), allow_params, plan);
+}
+
+bool PlanInsert(Catalog &catalog, const std::string &query, bool allow_params, Plan *plan) {
+    size_t val_pos = query.find(" values ");
+    if (val_pos == std::string::npos) {
+        LOG_ERROR("Syntax error. Expected: insert into <table> values (v1, v2)");
+        return false;
+    }
+
+    std::string table_name = query.substr(12, val_pos - 12);
+    trim(table_name);
 
-        size_t cond_eq_pos = cond_part.find('=');
-        if (cond_eq_pos == std::string::npos) {
-             LOG_ERROR("Syntax error: missing '=' in where clause.");
-             return false;
+    TableInfo *table = catalog.GetTable(table_name);
+    if (!table) {
+        LOG_ERROR("Table not found.");
+        return false;
+    }
+
+    plan->type = StatementType::INSERT;
+    plan->table_name = table_name;
+
+    // One or more comma separated rows: (v1, v2), (v3, v4), ...
+    const Schema &schema = *table->schema_;
+    size_t pos = val_pos + 8;
+    while (true) {
+        pos = query.find_first_not_of(' ', pos);
+        if (pos == std::string::npos || query[pos] != '(') {
+            LOG_ERROR("Syntax error in values list.");
+            return false;
         }
-        
-        std::string f_col_name = cond_part.substr(0, cond_eq_pos);
-        filter_val_str = cond_part.substr(cond_eq_pos + 1);
-        trim(f_col_name); trim(filter_val_str);
-        if (!filter_val_str.empty() && filter_val_str.back() == ';') filter_val_str.pop_back();
-
-        filter_col_idx = table->schema_->GetColIdx(f_col_name);
-        if (filter_col_idx == -1) {
-            LOG_ERROR("Column not found in where clause.");
+        // Find the closing parenthesis, skipping over quoted strings.
+        size_t end_paren = pos + 1;
+        char quote = 0;
+        for (; end_paren < query.size(); ++end_paren) {
+            char c = query[end_paren];
+            if (quote != 0) {
+                if (c == quote) quote = 0;
+            } else if (c == '\'' || c == '"') {
+                quote = c;
+            } else if (c == ')') {
+                break;
+            }
+        }
+        if (end_paren == query.size()) {
+            LOG_ERROR("Syntax error in values list.");
+            return false;
+        }
+
+        ScratchVector<std::string_view> tokens;
+        SplitArguments(std::string_view(query).substr(pos + 1, end_paren - pos - 1), &tokens);
+        if (tokens.size() > schema.GetColumnCount()) {
+            LOG_ERROR("Too many values provided.");
+            return false;
+        }
+        if (tokens.size() < schema.GetColumnCount()) {
+            LOG_ERROR("Not enough values provided.");
             return false;
         }
+        std::vector<Value> row(tokens.size());
+        for (uint32_t col_idx = 0; col_idx < tokens.size(); ++col_idx) {
+            if (allow_params && tokens[col_idx] == "?") {
+                size_t value = plan->rows.size() * schema.GetColumnCount() + col_idx;
+                plan->params.push_back({static_cast<int32_t>(value), -1});
+            } else if (!ParseValue(schema.GetColumn(col_idx), tokens[col_idx], &row[col_idx])) {
+                return false;
+            }
+        }
+        plan->rows.emplace_back(std::move(row));
+
+        pos = query.find_first_not_of(' ', end_paren + 1);
+        if (pos == std::string::npos || query[pos] == ';') return true;
+        if (query[pos] != ',') {
+            LOG_ERROR("Syntax error in values list.");
+            return false;
+        }
+        ++pos;
     }
+}
 
-    TypeId t = table->schema_->GetColumn(col_idx).GetType();
-    Value new_val;
-    if (t == TypeId::INTEGER) {
-        new_val = Value(std::stoi(val_str));
+// True for the statements PlanStatement understands.
+bool IsPlannable(const std::string &query) {
+    return (query.rfind("show ", 0) == 0 && query.find(" from ") != std::string::npos) ||
+           query.rfind("insert into", 0) == 0 || query.rfind("change", 0) == 0 ||
+           query.rfind("remove from", 0) == 0 || query.rfind("delete from", 0) == 0;
+}
+
+bool PlanStatement(Catalog &catalog, const std::string &query, bool allow_params, Plan *plan) {
+    if (query.rfind("show ", 0) == 0) return PlanShow(catalog, query, allow_params, plan);
+    if (query.rfind("insert into", 0) == 0) return PlanInsert(catalog, query, allow_params, plan);
+    if (query.rfind("change", 0) == 0) return PlanChange(catalog, query, allow_params, plan);
+    if (query.rfind("remove from", 0) == 0) return PlanRemove(catalog, query, StatementType::REMOVE, allow_params, plan);
+    if (query.rfind("delete from", 0) == 0) return PlanRemove(catalog, query, StatementType::DELETE, allow_params, plan);
+    LOG_ERROR("Only show, insert, change, remove and delete statements can be planned.");
+    return false;
+}
+
+// Fill a plan's parameters from args, given as they would be written in the statement.
+bool BindPlan(Catalog &catalog, const ScratchVector<std::string_view> &args, Plan *plan) {
+    if (args.size() != plan->params.size()) {
+        LOG_ERROR("Expected " << plan->params.size() << " parameters, got " << args.size() << ".");
+        return false;
+    }
+    TableInfo *table = catalog.GetTable(plan->table_name);
+    if (!table) {
+        LOG_ERROR("Table not found.");
+        return false;
+    }
+    const Schema &schema = plan->join_schema ? *plan->join_schema : *table->schema_;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const Plan::Param &param = plan->params[i];
+        if (param.value >= 0 && plan->type == StatementType::INSERT) {
+            uint32_t col = param.value % schema.GetColumnCount();
+            Value value;
+            if (!ParseValue(schema.GetColumn(col), args[i], &value)) return false;
+            plan->rows[param.value / schema.GetColumnCount()].SetValue(col, std::move(value));
+        } else if (param.value >= 0) {
+            if (!ParseValue(schema.GetColumn(plan->columns[0]), args[i], &plan->values[param.value])) return false;
+        } else if (!BindCondition(schema, args[i], &plan->where.nodes[param.node].cond)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// True if the hash table of a join should be built on its first table rather than its
+// second: both have been analyzed and the first has fewer rows.
+bool BuildOnFirst(const TableInfo &first, const TableInfo &second) {
+    return first.stats_ != nullptr && second.stats_ != nullptr &&
+           first.stats_->GetRowCount() < second.stats_->GetRowCount();
+}
+
+// Scan -> [Filter] -> [Aggregation] -> [Sort] -> [Limit] -> Projection -> Output, or for a join
+// HashJoin(Scan, Scan) -> [Filter] -> [Aggregation] -> ... with the second table as the build
+// side, unless BuildOnFirst says otherwise. Heap scans run on pool, keeping heap order unless
+// the rows are aggregated or joined. The output is buffered in scratch.
+void RunShow(Catalog &catalog, ThreadPool *pool, Arena *scratch, TableInfo *table, const Plan &plan) {
+    std::unique_ptr<Executor> root;
+    if (plan.join_schema) {
+        TableInfo *other = catalog.GetTable(plan.join_table);
+        if (!other) {
+            LOG_ERROR("Table not found.");
+            return;
+        }
+        if (BuildOnFirst(*table, *other)) {
+            root = std::make_unique<HashJoinExecutor>(MakeScanExecutor(catalog, other, nullptr, pool, false),
+                                                      other->schema_.get(), plan.join_right_key,
+                                                      MakeScanExecutor(catalog, table, nullptr, pool, false),
+                                                      table->schema_.get(), plan.join_left_key, pool);
+            // Put the first table's values back in front.
+            int32_t first_count = static_cast<int32_t>(table->schema_->GetColumnCount());
+            int32_t second_count = static_cast<int32_t>(other->schema_->GetColumnCount());
+            std::vector<int32_t> columns;
+            for (int32_t i = 0; i < first_count; ++i) columns.push_back(second_count + i);
+            for (int32_t i = 0; i < second_count; ++i) columns.push_back(i);
+            root = std::make_unique<ProjectionExecutor>(std::move(root), std::move(columns));
+        } else {
+            root = std::make_unique<HashJoinExecutor>(MakeScanExecutor(catalog, table, nullptr, pool, false),
+                                                      table->schema_.get(), plan.join_left_key,
+                                                      MakeScanExecutor(catalog, other, nullptr, pool, false),
+                                                      other->schema_.get(), plan.join_right_key, pool);
+        }
+        if (plan.has_where) root = std::make_unique<FilterExecutor>(std::move(root), &plan.where, plan.join_schema.get());
     } else {
-        if ((val_str.front() == '\'' && val_str.back() == '\'') || 
-            (val_str.front() == '"' && val_str.back() == '"')) {
-            val_str = val_str.substr(1, val_str.size() - 2);
+        root = MakeScanExecutor(catalog, table, plan.has_where ? &plan.where : nullptr, pool, !plan.IsAggregate());
+    }
+    if (plan.IsAggregate()) {
+        root = std::make_unique<AggregationExecutor>(std::move(root), plan.group_by, plan.aggregates, pool);
+    }
+    if (!plan.order_by.empty()) {
+        // With a limit, the sort only has to keep the rows up to the end of the page.
+        size_t keep = plan.limit >= 0 ? static_cast<size_t>(plan.limit + plan.offset) : std::numeric_limits<size_t>::max();
+        root = std::make_unique<SortExecutor>(std::move(root), plan.order_by, keep);
+    }
+    if (plan.limit >= 0) {
+        root = std::make_unique<LimitExecutor>(std::move(root), static_cast<size_t>(plan.limit),
+                                               static_cast<size_t>(plan.offset));
+    }
+    root = std::make_unique<ProjectionExecutor>(std::move(root), plan.columns);
+    OutputExecutor output(std::move(root), plan.headers, std::cout, scratch);
+    RowBatch batch;
+    while (output.Next(&batch)) {}
+    LOG_INFO(output.GetRowCount() << " rows returned.");
+}
+
+// Rows are found and delete-marked a morsel at a time on pool's threads; the index entries
+// of the deleted rows are removed afterwards on this thread.
+void RunRemove(Catalog &catalog, ThreadPool *pool, TableInfo *table, const Plan &plan, bool is_replaying) {
+    bool indexed = !catalog.GetTableIndexes(table->name_).empty();
+    std::mutex latch;
+    std::map<size_t, RowBatch> deleted_rows;
+    std::atomic<size_t> removed{0};
+    ScanMorsels(catalog, table, &plan.where, pool, [&](size_t morsel, RowBatch *victims) {
+        std::vector<bool> deleted;
+        removed += table->table_->DeleteTuples(victims->rids, &deleted);
+        if (!indexed) return;
+        RowBatch gone;
+        for (size_t i = 0; i < victims->Size(); ++i) {
+            if (!deleted[i]) continue;
+            gone.rids.push_back(victims->rids[i]);
+            gone.tuples.push_back(std::move(victims->tuples[i]));
         }
-        new_val = Value(val_str);
+        std::lock_guard<std::mutex> guard(latch);
+        deleted_rows.emplace(morsel, std::move(gone));
+    });
+    for (const auto &entry : deleted_rows) {
+        const RowBatch &gone = entry.second;
+        for (size_t i = 0; i < gone.Size(); ++i) RemoveIndexEntries(catalog, table, gone.tuples[i], gone.rids[i]);
     }
+    if (table->stats_) table->stats_->RecordDelete(removed);
+    if (!is_replaying) LOG_INFO((plan.type == StatementType::DELETE ? "Deleted " : "Removed ") << removed << " rows.");
+}
 
-    size_t updated = 0;
-    for (auto &tuple : table->tuples_) {
-        bool match = true;
-        if (filter_col_idx != -1) {
-            Value v = tuple.GetValue(table->schema_.get(), filter_col_idx);
-            match = false;
-            if (v.GetTypeId() == TypeId::INTEGER && std::to_string(v.GetAsInt()) == filter_val_str) match = true;
-            if (v.GetTypeId() == TypeId::VARCHAR && v.GetAsString() == filter_val_str) match = true;
-            if (v.GetTypeId() == TypeId::VARCHAR && ((filter_val_str.front() == '\'' && filter_val_str.back() == '\'') || 
-                                                     (filter_val_str.front() == '"' && filter_val_str.back() == '"'))) {
-                 std::string unquoted = filter_val_str.substr(1, filter_val_str.size() - 2);
-                 if (v.GetAsString() == unquoted) match = true;
-            }
+// Matches are collected first so relocated tuples are not visited twice by the scan. Each
+// morsel's matches are then updated on pool's threads, and the indexes are fixed up
+// afterwards on this thread.
+void RunChange(Catalog &catalog, ThreadPool *pool, TableInfo *table, const Plan &plan, bool is_replaying) {
+    std::mutex latch;
+    std::vector<RowBatch> targets;
+    ScanMorsels(catalog, table, plan.has_where ? &plan.where : nullptr, pool, [&](size_t, RowBatch *rows) {
+        std::lock_guard<std::mutex> guard(latch);
+        targets.push_back(std::move(*rows));
+    });
+
+    std::vector<RowBatch> changed(targets.size());
+    std::vector<std::vector<bool>> applied(targets.size());
+    pool->ParallelFor(targets.size(), [&](size_t m) {
+        changed[m] = targets[m];
+        applied[m].resize(changed[m].Size());
+        for (size_t i = 0; i < changed[m].Size(); ++i) {
+            changed[m].tuples[i].SetValue(plan.columns[0], plan.values[0]);
+            applied[m][i] = table->table_->UpdateTuple(changed[m].tuples[i], &changed[m].rids[i]);
         }
+    });
 
-        if (match) {
-            tuple.SetValue(col_idx, new_val);
+    size_t updated = 0;
+    for (size_t m = 0; m < targets.size(); ++m) {
+        for (size_t i = 0; i < targets[m].Size(); ++i) {
+            if (!applied[m][i]) continue;
+            UpdateIndexEntries(catalog, table, targets[m].tuples[i], targets[m].rids[i], changed[m].tuples[i],
+                               changed[m].rids[i]);
             updated++;
         }
     }
+    if (table->stats_ && updated > 0) table->stats_->RecordUpdate(plan.columns[0], plan.values[0]);
     if (!is_replaying) LOG_INFO("Updated " << updated << " rows.");
-    return true;
 }
 
-bool ExecuteInsertInto(Catalog &catalog, const std::string &query, bool is_replaying = false) {
-    size_t val_pos = query.find(" values ");
-    if (val_pos == std::string::npos) {
-        LOG_ERROR("Syntax error. Expected: insert into <table> values (v1, v2)");
+// The rows go into the heap straight from the plan; only their rids and serialized form
+// are kept, in scratch.
+bool RunInsert(Catalog &catalog, Arena *scratch, TableInfo *table, const Plan &plan, bool is_replaying) {
+    ScratchVector<RID> rids(plan.rows.size(), RID(), scratch);
+    if (!table->table_->InsertTuples(plan.rows, rids.data(), scratch)) {
+        LOG_ERROR("Failed to insert rows.");
         return false;
     }
+    for (size_t i = 0; i < plan.rows.size(); ++i) InsertIndexEntries(catalog, table, plan.rows[i], rids[i]);
+    if (table->stats_) {
+        for (const Tuple &row : plan.rows) table->stats_->RecordInsert(row);
+    }
+    if (!is_replaying) {
+        if (plan.rows.size() == 1) {
+            LOG_INFO("1 row inserted.");
+        } else {
+            LOG_INFO(plan.rows.size() << " rows inserted.");
+        }
+    }
+    return true;
+}
 
-    std::string table_name = query.substr(12, val_pos - 12);
-    trim(table_name);
-
-    TableInfo *table = catalog.GetTable(table_name);
+// Statement-lifetime buffers come from scratch, which the caller resets afterwards.
+bool RunPlan(Catalog &catalog, ThreadPool *pool, Arena *scratch, const Plan &plan, bool is_replaying = false) {
+    TableInfo *table = catalog.GetTable(plan.table_name);
     if (!table) {
         LOG_ERROR("Table not found.");
         return false;
     }
-
-    size_t start_paren = query.find('(', val_pos);
-    size_t end_paren = query.find(')', start_paren);
-    if (start_paren == std::string::npos || end_paren == std::string::npos) {
-        LOG_ERROR("Syntax error in values list.");
-        return false;
+    switch (plan.type) {
+        case StatementType::SHOW: RunShow(catalog, pool, scratch, table, plan); return true;
+        case StatementType::INSERT: return RunInsert(catalog, scratch, table, plan, is_replaying);
+        case StatementType::CHANGE: RunChange(catalog, pool, table, plan, is_replaying); return true;
+        case StatementType::REMOVE:
+        case StatementType::DELETE: RunRemove(catalog, pool, table, plan, is_replaying); return true;
     }
+    return false;
+}
 
-    std::string vals_part = query.substr(start_paren + 1, end_paren - start_paren - 1);
-    std::stringstream ss(vals_part);
-    std::string val_tok;
-    std::vector<Value> row_values;
-
-    uint32_t col_idx = 0;
-    while (std::getline(ss, val_tok, ',')) {
-        trim(val_tok);
-        if (col_idx >= table->schema_->GetColumnCount()) {
-            LOG_ERROR("Too many values provided.");
-            return false;
-        }
+// Parse and run a statement without caching its plan.
+bool ExecuteQuery(Catalog &catalog, ThreadPool *pool, Arena *scratch, const std::string &query,
+                  bool is_replaying = false) {
+    Plan plan;
+    return PlanStatement(catalog, query, false, &plan) && RunPlan(catalog, pool, scratch, plan, is_replaying);
+}
 
-        TypeId expected_type = table->schema_->GetColumn(col_idx).GetType();
-        if (expected_type == TypeId::INTEGER) {
-            row_values.emplace_back(std::stoi(val_tok));
-        } else {
-            if (val_tok.front() == '\'' && val_tok.back() == '\'') {
-                val_tok = val_tok.substr(1, val_tok.size() - 2);
+// Rewrite a statement so that statements differing only in their literals read the same:
+// whitespace outside quotes is collapsed, a trailing ';' dropped, and each quoted string
+// or number written where a value goes is replaced by ? and appended to literals, as a
+// view into query. "insert into t values (1,  'a');" becomes "insert into t values (?, ?)".
+void NormalizeStatement(const std::string &query, std::string *normalized, ScratchVector<std::string_view> *literals) {
+    std::string &out = *normalized;
+    out.clear();
+    out.reserve(query.size());
+    auto is_word = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+    auto value_position = [&]() {
+        size_t i = out.find_last_not_of(' ');
+        return i != std::string::npos && std::string_view("(,=<>!").find(out[i]) != std::string_view::npos;
+    };
+
+    size_t i = 0;
+    while (i < query.size()) {
+        char c = query[i];
+        if (c == '\'' || c == '"') {
+            size_t close = query.find(c, i + 1);
+            if (close == std::string::npos) {
+                out.append(query, i, std::string::npos);
+                break;
             }
-            row_values.emplace_back(val_tok);
+            literals->push_back(std::string_view(query).substr(i, close - i + 1));
+            out += '?';
+            i = close + 1;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (!out.empty() && out.back() != ' ') out += ' ';
+            while (i < query.size() && std::isspace(static_cast<unsigned char>(query[i]))) ++i;
+        } else if ((std::isdigit(static_cast<unsigned char>(c)) ||
+                    (c == '-' && i + 1 < query.size() && std::isdigit(static_cast<unsigned char>(query[i + 1])))) &&
+                   value_position()) {
+            size_t end = i + 1;
+            while (end < query.size() && std::isdigit(static_cast<unsigned char>(query[end]))) ++end;
+            if (end < query.size() && is_word(query[end])) {
+                // Part of a word such as 2nd; leave it as written.
+                out.append(query, i, end - i);
+            } else {
+                literals->push_back(std::string_view(query).substr(i, end - i));
+                out += '?';
+            }
+            i = end;
+        } else {
+            out += c;
+            ++i;
         }
-        col_idx++;
     }
+    while (!out.empty() && (out.back() == ' ' || out.back() == ';')) out.pop_back();
+}
 
-    if (row_values.size() != table->schema_->GetColumnCount()) {
-        LOG_ERROR("Not enough values provided.");
-        return false;
+// Least recently used cache of parsed plans keyed on normalized statement text.
+class PlanCache {
+public:
+    explicit PlanCache(size_t capacity) : capacity_(capacity) {}
+
+    // Returns nullptr on a miss; a hit becomes the most recently used entry.
+    Plan *Find(const std::string &key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) return nullptr;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return &it->second->second;
     }
 
-    table->tuples_.emplace_back(row_values);
-    if (!is_replaying) LOG_INFO("1 row inserted.");
-    return true;
-}
+    Plan *Insert(const std::string &key, Plan plan) {
+        entries_.emplace_front(key, std::move(plan));
+        index_[key] = entries_.begin();
+        if (entries_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+        return &entries_.front().second;
+    }
 
-void AppendToLog(const std::string& db_file, const std::string& query) {
-    std::ofstream out(db_file + ".log", std::ios::app);
-    if (out.is_open()) {
-        out << query << "\n";
+    void Clear() {
+        entries_.clear();
+        index_.clear();
+    }
+
+private:
+    size_t capacity_;
+    std::list<std::pair<std::string, Plan>> entries_;
+    std::unordered_map<std::string, std::list<std::pair<std::string, Plan>>::iterator> index_;
+};
+
+// A statement named with prepare. The plan is dropped when the connection changes and
+// built again from text on the next execute.
+struct PreparedStatement {
+    std::string text;
+    std::unique_ptr<Plan> plan;
+};
+
+struct Database {
+    std::unique_ptr<DiskManager> disk_manager;
+    std::unique_ptr<BufferPoolManager> bpm;
+    std::unique_ptr<Catalog> catalog;
+    std::unique_ptr<LogManager> log_manager;
+    std::unique_ptr<CheckpointManager> checkpoint_manager;
+    std::unique_ptr<VacuumManager> vacuum_manager;
+
+    // Session durability setting, carried over when connecting to another database
+    DurabilityMode durability = DEFAULT_DURABILITY;
+    size_t group_ms = LOG_GROUP_COMMIT_MS;
+    size_t group_bytes = LOG_GROUP_COMMIT_BYTES;
+
+    // Workers that run queries alongside the connection's own thread; see "set threads"
+    std::unique_ptr<ThreadPool> pool;
+
+    // Print the heap allocations of each statement; see "set allocations"
+    bool report_allocations = false;
+
+    // Memory a statement needs only while it runs, reset after every statement
+    Arena scratch;
+    std::string statement_key;   // normalized text of the current statement, see ExecuteCached
+
+    // Plans refer to tables by name, so both are reset when another database is opened
+    PlanCache plan_cache{PLAN_CACHE_SIZE};
+    std::unordered_map<std::string, PreparedStatement> prepared;
+};
+
+// Close the statement's group of log records; replay only applies complete statements.
+void CommitStatement(Database &db) {
+    lsn_t lsn = db.log_manager->AppendRecord(LogRecord::Commit());
+    if (!db.log_manager->Commit(lsn)) {
+        LOG_ERROR("Statement applied but could not be made durable.");
     }
 }
 
-void ReplayLog(Catalog& catalog, const std::string& db_file) {
-    std::ifstream in(db_file + ".log");
+// Re-execute a SQL text log from older versions. The statements are logged again through
+// the attached LogManager, which converts the database to the binary log format.
+void ReplayLegacyLog(Database &db, const std::string &legacy_file) {
+    std::ifstream in(legacy_file);
     if (!in.is_open()) return;
-    
+    Catalog &catalog = *db.catalog;
+
     std::string query;
-    int count = 0;
     while (std::getline(in, query)) {
         trim(query);
         if (query.rfind("make table", 0) == 0) ExecuteMakeTable(catalog, query, true);
-        else if (query.rfind("remove from", 0) == 0) ExecuteRemoveFrom(catalog, query, true);
-        else if (query.rfind("delete from", 0) == 0) ExecuteDeleteFrom(catalog, query, true);
-        else if (query.rfind("change", 0) == 0) ExecuteChangeTable(catalog, query, true);
-        else if (query.rfind("insert into", 0) == 0) ExecuteInsertInto(catalog, query, true);
-        count++;
+        else if (query.rfind("make index", 0) == 0) ExecuteMakeIndex(catalog, query, true);
+        else if (IsPlannable(query) && query.rfind("show ", 0) != 0) ExecuteQuery(catalog, db.pool.get(), &db.scratch, query, true);
+        else continue;
+        db.log_manager->AppendRecord(LogRecord::Commit());
+        db.scratch.Reset();
+    }
+}
+
+// set columnar <table> on | off
+void ExecuteSetColumnar(Catalog &catalog, const std::string &query) {
+    std::stringstream ss(query.substr(12));
+    std::string table_name, mode;
+    ss >> table_name >> mode;
+    if (!table_name.empty() && table_name.back() == ';') table_name.pop_back();
+    if (mode != "on" && mode != "off") {
+        LOG_ERROR("Syntax error. Expected: set columnar <table> on | off");
+        return;
+    }
+    TableInfo *table = catalog.GetTable(table_name);
+    if (!table) {
+        LOG_ERROR("Table '" << table_name << "' not found.");
+        return;
+    }
+    if (mode == "off") {
+        table->column_store_.reset();
+        LOG_INFO("Table '" << table_name << "' is scanned from its pages.");
+        return;
+    }
+    if (table->column_store_ == nullptr) table->column_store_ = std::make_unique<ColumnStore>(table->schema_.get());
+    table->column_store_->Refresh(table->table_.get());
+    size_t encoded = 0;
+    for (uint32_t i = 0; i < table->schema_->GetColumnCount(); ++i) encoded += table->column_store_->IsDictionaryEncoded(i);
+    LOG_INFO("Table '" << table_name << "' is scanned from columns (" << table->column_store_->GetRowCount()
+             << " rows, " << encoded << " dictionary-encoded, " << FilterKernelName(BestFilterKernel()) << " filters).");
+}
+
+const char *DurabilityName(DurabilityMode mode) {
+    switch (mode) {
+    case DurabilityMode::OFF: return "off";
+    case DurabilityMode::GROUP: return "group";
+    case DurabilityMode::SYNC: return "sync";
+    }
+    return "unknown";
+}
+
+// set durability off | sync | group [<ms>] [<bytes>]
+void ExecuteSetDurability(Database &db, const std::string &query) {
+    std::stringstream ss(query.substr(14));
+    std::string mode;
+    ss >> mode;
+    if (mode == "off") {
+        db.durability = DurabilityMode::OFF;
+    } else if (mode == "sync") {
+        db.durability = DurabilityMode::SYNC;
+    } else if (mode == "group") {
+        db.durability = DurabilityMode::GROUP;
+        size_t ms, bytes;
+        if (ss >> ms) {
+            db.group_ms = std::max<size_t>(ms, 1);
+            if (ss >> bytes) db.group_bytes = std::max<size_t>(bytes, 1);
+        }
+    } else {
+        LOG_ERROR("Syntax error. Expected: set durability off | sync | group [<ms>] [<bytes>]");
+        return;
+    }
+    if (db.log_manager) db.log_manager->SetDurability(db.durability, db.group_ms, db.group_bytes);
+    if (db.durability == DurabilityMode::GROUP) {
+        LOG_INFO("Durability set to group (every " << db.group_ms << " ms or " << db.group_bytes << " bytes).");
+    } else {
+        LOG_INFO("Durability set to " << DurabilityName(db.durability) << ".");
+    }
+}
+
+// Threads a query runs on when the session has not picked a number.
+size_t DefaultExecutionThreads() {
+    if (EXECUTION_THREADS != 0) return EXECUTION_THREADS;
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// set threads <n>
+// Queries then run on the calling thread and n - 1 workers.
+void ExecuteSetThreads(Database &db, const std::string &query) {
+    std::stringstream ss(query.substr(11));
+    size_t threads = 0;
+    if (!(ss >> threads) || threads == 0 || threads > 1024) {
+        LOG_ERROR("Syntax error. Expected: set threads <n>, with n from 1 to 1024");
+        return;
+    }
+    db.pool = std::make_unique<ThreadPool>(threads - 1);
+    LOG_INFO("Queries run on " << threads << (threads == 1 ? " thread." : " threads."));
+}
+
+// set allocations on | off
+// With on, each statement is followed by the number of heap allocations made while it ran,
+// by every thread of the process.
+void ExecuteSetAllocations(Database &db, const std::string &query) {
+    std::stringstream ss(query.substr(15));
+    std::string mode;
+    ss >> mode;
+    if (!mode.empty() && mode.back() == ';') mode.pop_back();
+    if (mode != "on" && mode != "off") {
+        LOG_ERROR("Syntax error. Expected: set allocations on | off");
+        return;
+    }
+    db.report_allocations = mode == "on";
+    SetAllocCounting(db.report_allocations);
+    LOG_INFO("Allocation reporting " << (db.report_allocations ? "on." : "off."));
+}
+
+// load <table> from '<file.csv>'
+// Rows are parsed into pages off the statement path and appended a batch at a time. Each
+// batch is committed as its own statement, so the log stays bounded and background
+// checkpoints can run between batches; a failed load keeps the batches before the error.
+void ExecuteLoad(Database &db, const std::string &query) {
+    size_t from_pos = query.find(" from ");
+    if (from_pos == std::string::npos) {
+        LOG_ERROR("Syntax error. Expected: load <table> from '<file.csv>'");
+        return;
+    }
+    std::string table_name = query.substr(5, from_pos - 5);
+    std::string path = query.substr(from_pos + 6);
+    trim(table_name); trim(path);
+    if (!path.empty() && path.back() == ';') path.pop_back();
+    if (path.size() >= 2 && (path.front() == '\'' || path.front() == '"') && path.back() == path.front()) {
+        path = path.substr(1, path.size() - 2);
+    }
+
+    Catalog &catalog = *db.catalog;
+    TableInfo *table = catalog.GetTable(table_name);
+    if (!table) {
+        LOG_ERROR("Table '" << table_name << "' not found.");
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t rows = 0;
+    CsvLoader loader(table->schema_.get(), std::min(LOAD_THREADS, static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency()))));
+    bool ok = loader.Load(path, [&](CsvLoader::Batch &batch) {
+        std::shared_lock<std::shared_mutex> guard(db.checkpoint_manager->GetStatementLatch());
+        bool indexed = !catalog.GetTableIndexes(table->name_).empty();
+        for (size_t i = 0; i < batch.page_count; ++i) {
+            page_id_t page_id;
+            if (!table->table_->AppendPage(batch.GetPage(i), &page_id)) {
+                CommitStatement(db);
+                return false;
+            }
+            if (!indexed && !table->stats_) continue;
+            TablePage page(batch.GetPage(i));
+            for (uint32_t slot = 0; slot < page.GetSlotCount(); ++slot) {
+                uint32_t size;
+                const char *data = page.GetTuple(slot, &size);
+                Tuple tuple;
+                tuple.DeserializeFrom(*table->schema_, data);
+                if (indexed) InsertIndexEntries(catalog, table, tuple, RID(page_id, slot));
+                if (table->stats_) table->stats_->RecordInsert(tuple);
+            }
+        }
+        CommitStatement(db);
+        rows += batch.row_count;
+        return true;
+    });
+
+    if (!ok && rows == 0) return;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO((ok ? "Loaded " : "Load stopped after ") << rows << " rows in " << seconds << " s ("
+             << static_cast<uint64_t>(rows / std::max(seconds, 1e-6)) << " rows/s).");
+}
+
+// vacuum [<table>]
+// Compact every page of the table (or of all tables) that deletes or updates left space on.
+void ExecuteVacuum(Database &db, const std::string &query) {
+    std::string table_name = query.substr(6);
+    trim(table_name);
+    if (!table_name.empty() && table_name.back() == ';') table_name.pop_back();
+
+    std::vector<std::string> names = table_name.empty() ? db.catalog->GetTableNames()
+                                                        : std::vector<std::string>{table_name};
+    size_t pages = 0, bytes = 0;
+    for (const std::string &name : names) {
+        TableInfo *table = db.catalog->GetTable(name);
+        if (!table) {
+            LOG_ERROR("Table '" << name << "' not found.");
+            return;
+        }
+        pages += table->table_->VacuumAll(&bytes);
+    }
+    CommitStatement(db);
+    LOG_INFO("Vacuum compacted " << pages << " pages, reclaiming " << bytes << " bytes.");
+}
+
+// analyze [<table>]
+// Gather the statistics the planner costs access paths and joins with, for one table or all.
+void ExecuteAnalyze(Database &db, const std::string &query) {
+    std::string table_name = query.substr(7);
+    trim(table_name);
+    if (!table_name.empty() && table_name.back() == ';') table_name.pop_back();
+
+    std::vector<std::string> names = table_name.empty() ? db.catalog->GetTableNames()
+                                                        : std::vector<std::string>{table_name};
+    for (const std::string &name : names) {
+        TableInfo *table = db.catalog->GetTable(name);
+        if (!table) {
+            LOG_ERROR("Table '" << name << "' not found.");
+            return;
+        }
+        table->stats_ = TableStats::Analyze(table->table_.get(), table->schema_.get());
+        const TableStats &stats = *table->stats_;
+        LOG_INFO("Analyzed '" << name << "': " << stats.GetRowCount() << " rows on " << stats.GetPageCount() << " pages.");
+        if (stats.GetRowCount() == 0) continue;
+        for (uint32_t col = 0; col < table->schema_->GetColumnCount(); ++col) {
+            const ColumnStats &column = stats.GetColumn(col);
+            LOG_INFO("  " << table->schema_->GetColumn(col).GetName() << ": " << stats.GetDistinctCount(col)
+                     << " distinct, from " << column.min.ToString() << " to " << column.max.ToString() << ", "
+                     << column.bounds.size() << " histogram buckets");
+        }
+    }
+}
+
+void ExecuteCheckpoint(Database &db) {
+    int pages = 0;
+    if (db.checkpoint_manager->Checkpoint(&pages)) {
+        LOG_INFO("Checkpoint complete: " << pages << " pages written.");
+    }
+}
+
+void CloseDatabase(Database &db) {
+    // Stop background compaction so the final checkpoint sees the database at rest.
+    db.vacuum_manager.reset();
+    // A clean shutdown leaves an empty log, so the next connect has nothing to redo.
+    if (db.checkpoint_manager && db.log_manager) db.checkpoint_manager->Checkpoint();
+    // Tear down in dependency order so dirty pages are flushed before the file closes.
+    db.checkpoint_manager.reset();
+    db.log_manager.reset();
+    db.catalog.reset();
+    db.bpm.reset();
+    db.disk_manager.reset();
+}
+
+void OpenDatabase(Database &db, const std::string &db_file) {
+    CloseDatabase(db);
+    db.plan_cache.Clear();
+    for (auto &[name, statement] : db.prepared) statement.plan.reset();
+
+    // Older versions rebuilt every page from the log on connect; their data file holds
+    // nothing the log does not, so it is discarded and rebuilt once.
+    if (!CheckpointManager::IsSnapshotFile(db_file)) {
+        std::ofstream(db_file, std::ios::binary | std::ios::trunc);
+    }
+
+    db.disk_manager = std::make_unique<DiskManager>(db_file, true);
+    db.bpm = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, db.disk_manager.get());
+    db.catalog = std::make_unique<Catalog>(db.bpm.get());
+    db.checkpoint_manager = std::make_unique<CheckpointManager>(db.catalog.get(), db.bpm.get(), db.disk_manager.get());
+    lsn_t checkpoint_lsn = db.checkpoint_manager->LoadSnapshot();
+
+    // A text log from an older version is moved aside and converted below. If a previous
+    // conversion was interrupted, the half-written binary log is discarded and it starts over.
+    std::string log_file = db_file + ".log";
+    std::string legacy_file = log_file + ".v1";
+    std::error_code ec;
+    if (!std::filesystem::exists(legacy_file) && LogRecovery::IsLegacyLog(log_file)) {
+        std::filesystem::rename(log_file, legacy_file, ec);
+    }
+    bool converting = std::filesystem::exists(legacy_file);
+    if (converting) std::filesystem::remove(log_file, ec);
+
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    LogRecovery recovery(db.catalog.get(), db.disk_manager.get(), std::min(RECOVERY_THREADS, cores));
+    if (!recovery.Recover(log_file, checkpoint_lsn)) {
+        LOG_ERROR("Recovery failed; the database may be incomplete.");
+    }
+    db.log_manager = std::make_unique<LogManager>(log_file, db.durability, db.group_ms, db.group_bytes);
+    db.log_manager->SetNextLSN(std::max(recovery.GetNextLSN(), checkpoint_lsn + 1));
+    db.catalog->SetLogManager(db.log_manager.get());
+    db.checkpoint_manager->SetLogManager(db.log_manager.get());
+
+    if (converting) {
+        ReplayLegacyLog(db, legacy_file);
+        if (db.log_manager->Flush()) {
+            std::filesystem::remove(legacy_file, ec);
+            LOG_INFO("Converted " << log_file << " to the binary log format.");
+        }
+    }
+    // Checkpoint what recovery redid so a second crash does not redo it again.
+    if (converting || recovery.GetRecordCount() > 0) db.checkpoint_manager->Checkpoint();
+    db.checkpoint_manager->StartBackground();
+    db.vacuum_manager = std::make_unique<VacuumManager>(db.catalog.get(), db.log_manager.get(),
+                                                        &db.checkpoint_manager->GetStatementLatch());
+    db.vacuum_manager->StartBackground();
+}
+
+// Run a show / insert / change / remove statement through the plan cache. Literals are
+// lifted out of the text so that, say, inserts of different rows share one cached plan.
+void ExecuteCached(Database &db, const std::string &query) {
+    ScratchVector<std::string_view> literals(&db.scratch);
+    const std::string &key = db.statement_key;
+    NormalizeStatement(query, &db.statement_key, &literals);
+    Plan *plan = db.plan_cache.Find(key);
+    if (plan == nullptr) {
+        Plan parsed;
+        if (!PlanStatement(*db.catalog, key, true, &parsed)) return;
+        if (parsed.params.size() != literals.size()) {
+            // A literal was lifted from somewhere other than a value, e.g. "5 6"; run the
+            // statement as written, uncached.
+            ExecuteQuery(*db.catalog, db.pool.get(), &db.scratch, query);
+            if (parsed.IsMutation()) CommitStatement(db);
+            return;
+        }
+        plan = db.plan_cache.Insert(key, std::move(parsed));
+    }
+    if (!BindPlan(*db.catalog, literals, plan)) return;
+    RunPlan(*db.catalog, db.pool.get(), &db.scratch, *plan);
+    if (plan->IsMutation()) CommitStatement(db);
+}
+
+// prepare <name> as <statement with ? parameters>
+void ExecutePrepare(Database &db, const std::string &query) {
+    size_t as_pos = query.find(" as ");
+    if (as_pos == std::string::npos || as_pos <= 8) {
+        LOG_ERROR("Syntax error. Expected: prepare <name> as <statement>");
+        return;
+    }
+    std::string name = query.substr(8, as_pos - 8);
+    std::string text = query.substr(as_pos + 4);
+    trim(name); trim(text);
+    if (!text.empty() && text.back() == ';') text.pop_back();
+
+    if (!IsPlannable(text)) {
+        LOG_ERROR("Only show, insert, change, remove and delete statements can be prepared.");
+        return;
+    }
+    auto plan = std::make_unique<Plan>();
+    if (!PlanStatement(*db.catalog, text, true, plan.get())) return;
+    size_t params = plan->params.size();
+    db.prepared[name] = PreparedStatement{text, std::move(plan)};
+    LOG_INFO("Statement '" << name << "' prepared with " << params << " parameters.");
+}
+
+// execute <name> [(arg, ...)]
+void ExecuteExecute(Database &db, const std::string &query) {
+    std::string_view rest = std::string_view(query).substr(8);
+    if (!rest.empty() && rest.back() == ';') rest.remove_suffix(1);
+    size_t open_paren = rest.find('(');
+    std::string name(trimmed(rest.substr(0, open_paren)));
+
+    ScratchVector<std::string_view> args(&db.scratch);
+    if (open_paren != std::string_view::npos) {
+        size_t close_paren = rest.rfind(')');
+        if (close_paren == std::string_view::npos || close_paren < open_paren) {
+            LOG_ERROR("Syntax error. Expected: execute <name> (v1, v2)");
+            return;
+        }
+        SplitArguments(rest.substr(open_paren + 1, close_paren - open_paren - 1), &args);
+    }
+
+    auto it = db.prepared.find(name);
+    if (it == db.prepared.end()) {
+        LOG_ERROR("Prepared statement '" << name << "' not found.");
+        return;
+    }
+    PreparedStatement &statement = it->second;
+    if (statement.plan == nullptr) {
+        auto plan = std::make_unique<Plan>();
+        if (!PlanStatement(*db.catalog, statement.text, true, plan.get())) return;
+        statement.plan = std::move(plan);
+    }
+    Plan &plan = *statement.plan;
+    if (!BindPlan(*db.catalog, args, &plan)) return;
+    RunPlan(*db.catalog, db.pool.get(), &db.scratch, plan);
+    if (plan.IsMutation()) CommitStatement(db);
+}
+
+// deallocate <name>
+void ExecuteDeallocate(Database &db, const std::string &query) {
+    std::string name = query.substr(11);
+    trim(name);
+    if (!name.empty() && name.back() == ';') name.pop_back();
+    if (db.prepared.erase(name) == 0) {
+        LOG_ERROR("Prepared statement '" << name << "' not found.");
+        return;
+    }
+    LOG_INFO("Statement '" << name << "' deallocated.");
+}
+
+// Run one statement against the connected database. Statements hold the statement latch
+// shared, so a background checkpoint only ever sees the database between statements.
+void ExecuteStatement(Database &db, const std::string &db_file, const std::string &query) {
+    Catalog &catalog = *db.catalog;
+    std::shared_lock<std::shared_mutex> guard(db.checkpoint_manager->GetStatementLatch());
+    if (query == "show" || query.rfind("show database", 0) == 0 || (query.rfind("show ", 0) == 0 && query.find("from") == std::string::npos)) {
+        ExecuteShowDatabase(catalog, db_file);
+    } else if (query == "vacuum" || query.rfind("vacuum ", 0) == 0 || query == "vacuum;") {
+        ExecuteVacuum(db, query);
+    } else if (query == "analyze" || query.rfind("analyze ", 0) == 0 || query == "analyze;") {
+        ExecuteAnalyze(db, query);
+    } else if (query.rfind("set columnar", 0) == 0) {
+        ExecuteSetColumnar(catalog, query);
+    } else if (query.rfind("make table", 0) == 0) {
+        ExecuteMakeTable(catalog, query);
+        CommitStatement(db);
+    } else if (query.rfind("make index", 0) == 0) {
+        ExecuteMakeIndex(catalog, query);
+        CommitStatement(db);
+    } else if (IsPlannable(query)) {
+        ExecuteCached(db, query);
+    } else if (query.rfind("prepare ", 0) == 0) {
+        ExecutePrepare(db, query);
+    } else if (query.rfind("execute ", 0) == 0) {
+        ExecuteExecute(db, query);
+    } else if (query.rfind("deallocate ", 0) == 0) {
+        ExecuteDeallocate(db, query);
+    } else {
+        LOG_ERROR("Unknown command: " << query);
     }
 }
 
 int main(int argc, char* argv[]) {
     std::string db_file = "";
-    std::unique_ptr<DiskManager> disk_manager = nullptr;
-    std::unique_ptr<Catalog> catalog = nullptr;
+    Database db;
+    db.pool = std::make_unique<ThreadPool>(DefaultExecutionThreads() - 1);
+    std::unique_ptr<Catalog> &catalog = db.catalog;
 
     if (argc > 1) {
         db_file = argv[1];
-        disk_manager = std::make_unique<DiskManager>(db_file);
-        catalog = std::make_unique<Catalog>();
-        ReplayLog(*catalog, db_file);
+        OpenDatabase(db, db_file);
         LOG_INFO("SimpleDBMS starting. Connected to database: " << db_file << " ... Type 'exit' to quit.");
     } else {
         LOG_INFO("SimpleDBMS starting with NO database connected. Type 'connect <database>' to start.");
@@ -515,35 +1505,38 @@ int main(int argc, char* argv[]) {
         if (query == "exit" || query == "quit") break;
         if (query.empty()) continue;
 
+        AllocStats before = GetAllocStats();
         if (query.rfind("connect ", 0) == 0) {
             db_file = query.substr(8);
             trim(db_file);
             if (!db_file.empty() && db_file.back() == ';') db_file.pop_back();
-            disk_manager = std::make_unique<DiskManager>(db_file);
-            catalog = std::make_unique<Catalog>();
             LOG_INFO("Connected to database: " << db_file);
-            ReplayLog(*catalog, db_file);
+            OpenDatabase(db, db_file);
+        } else if (query.rfind("set durability", 0) == 0) {
+            ExecuteSetDurability(db, query);
+        } else if (query.rfind("set threads", 0) == 0) {
+            ExecuteSetThreads(db, query);
+        } else if (query.rfind("set allocations", 0) == 0) {
+            ExecuteSetAllocations(db, query);
+            continue;
         } else if (!catalog) {
             LOG_ERROR("No database connected! Please run 'connect <db>' first.");
-        } else if (query == "show" || query.rfind("show database", 0) == 0 || (query.rfind("show ", 0) == 0 && query.find("from") == std::string::npos)) {
-            ExecuteShowDatabase(*catalog, db_file);
-        } else if (query.rfind("make table", 0) == 0) {
-            if (ExecuteMakeTable(*catalog, query)) AppendToLog(db_file, query);
-        } else if (query.rfind("show ", 0) == 0 && query.find(" from ") != std::string::npos) {
-            ExecuteShow(*catalog, query);
-        } else if (query.rfind("remove from", 0) == 0) {
-            if (ExecuteRemoveFrom(*catalog, query)) AppendToLog(db_file, query);
-        } else if (query.rfind("delete from", 0) == 0) {
-            if (ExecuteDeleteFrom(*catalog, query)) AppendToLog(db_file, query);
-        } else if (query.rfind("change", 0) == 0) {
-            if (ExecuteChangeTable(*catalog, query)) AppendToLog(db_file, query);
-        } else if (query.rfind("insert into", 0) == 0) {
-            if (ExecuteInsertInto(*catalog, query)) AppendToLog(db_file, query);
+        } else if (query == "checkpoint" || query == "checkpoint;") {
+            ExecuteCheckpoint(db);
+        } else if (query.rfind("load ", 0) == 0) {
+            ExecuteLoad(db, query);
         } else {
-            LOG_ERROR("Unknown command: " << query);
+            ExecuteStatement(db, db_file, query);
+        }
+        if (db.report_allocations) {
+            AllocStats used = GetAllocStats() - before;
+            LOG_INFO(used.allocations << " allocations (" << used.bytes << " bytes), " << used.frees << " frees, "
+                     << db.scratch.GetBytesUsed() << " bytes of scratch.");
         }
+        db.scratch.Reset();
     }
 
+    CloseDatabase(db);
     LOG_INFO("DBMS shutdown.");
     return 0;
 }
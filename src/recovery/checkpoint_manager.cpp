@@ -0,0 +1,218 @@
+#include "recovery/checkpoint_manager.h"
+#include "common/crc32.h"
+#include "common/logger.h"
+#include "common/serialize.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace simpledb {
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[] = "SDBCKPT1";
+constexpr size_t MAGIC_SIZE = sizeof(SNAPSHOT_MAGIC) - 1;
+constexpr page_id_t HEADER_PAGE_ID = 0;
+
+// Page 0 layout
+constexpr size_t OFFSET_LSN = 8;
+constexpr size_t OFFSET_NEXT_PAGE_ID = 16;
+constexpr size_t OFFSET_SIZE = 20;
+constexpr size_t OFFSET_CRC = 24;
+constexpr size_t OFFSET_NEXT_META = 28;
+constexpr size_t HEADER_SIZE = 32;
+
+// Overflow page layout: next meta page, then catalog bytes
+constexpr size_t OVERFLOW_HEADER_SIZE = 4;
+
+} // namespace
+
+CheckpointManager::CheckpointManager(Catalog *catalog, BufferPoolManager *bpm, DiskManager *disk_manager)
+    : catalog_(catalog), bpm_(bpm), disk_manager_(disk_manager) {}
+
+CheckpointManager::~CheckpointManager() {
+    {
+        std::lock_guard<std::mutex> guard(background_latch_);
+        stop_ = true;
+    }
+    background_cv_.notify_all();
+    if (background_thread_.joinable()) background_thread_.join();
+}
+
+bool CheckpointManager::IsSnapshotFile(const std::string &db_file) {
+    std::ifstream in(db_file, std::ios::binary);
+    char magic[MAGIC_SIZE];
+    if (!in.read(magic, MAGIC_SIZE)) return in.gcount() == 0;
+    return memcmp(magic, SNAPSHOT_MAGIC, MAGIC_SIZE) == 0;
+}
+
+std::string CheckpointManager::SerializeCatalog() {
+    std::vector<TableInfo *> tables;
+    for (const std::string &name : catalog_->GetTableNames()) tables.push_back(catalog_->GetTable(name));
+    std::sort(tables.begin(), tables.end(), [](TableInfo *a, TableInfo *b) { return a->oid_ < b->oid_; });
+
+    std::string out;
+    std::vector<IndexInfo *> indexes;
+    PutValue<uint32_t>(&out, static_cast<uint32_t>(tables.size()));
+    for (TableInfo *table : tables) {
+        PutValue(&out, table->oid_);
+        PutString(&out, table->name_);
+        PutValue<uint32_t>(&out, table->schema_->GetColumnCount());
+        for (const Column &col : table->schema_->GetColumns()) {
+            PutString(&out, col.GetName());
+            PutValue<uint8_t>(&out, static_cast<uint8_t>(col.GetType()));
+        }
+        PutValue(&out, table->table_->GetFirstPageId());
+        const auto &table_indexes = catalog_->GetTableIndexes(table->name_);
+        indexes.insert(indexes.end(), table_indexes.begin(), table_indexes.end());
+    }
+
+    PutValue<uint32_t>(&out, static_cast<uint32_t>(indexes.size()));
+    for (IndexInfo *index : indexes) {
+        PutString(&out, index->name_);
+        PutValue(&out, catalog_->GetTable(index->table_name_)->oid_);
+        PutValue(&out, index->key_col_);
+        PutValue(&out, index->index_->GetRootPageId());
+    }
+    return out;
+}
+
+bool CheckpointManager::WriteMetadata(lsn_t checkpoint_lsn, const std::string &catalog) {
+    // Work out how many overflow pages the catalog needs, reusing the last snapshot's.
+    size_t first_cap = PAGE_SIZE - HEADER_SIZE;
+    size_t overflow_cap = PAGE_SIZE - OVERFLOW_HEADER_SIZE;
+    size_t overflow_count = catalog.size() <= first_cap ? 0 : (catalog.size() - first_cap + overflow_cap - 1) / overflow_cap;
+    while (meta_pages_.size() < overflow_count) meta_pages_.push_back(disk_manager_->AllocatePage());
+
+    std::vector<char> page(PAGE_SIZE);
+    size_t pos = std::min(catalog.size(), first_cap);
+    for (size_t i = 0; i < overflow_count; ++i) {
+        std::fill(page.begin(), page.end(), 0);
+        page_id_t next = i + 1 < overflow_count ? meta_pages_[i + 1] : INVALID_PAGE_ID;
+        memcpy(page.data(), &next, sizeof(page_id_t));
+        size_t n = std::min(catalog.size() - pos, overflow_cap);
+        memcpy(page.data() + OVERFLOW_HEADER_SIZE, catalog.data() + pos, n);
+        pos += n;
+        if (!disk_manager_->WritePage(meta_pages_[i], page.data())) return false;
+    }
+
+    std::fill(page.begin(), page.end(), 0);
+    memcpy(page.data(), SNAPSHOT_MAGIC, MAGIC_SIZE);
+    page_id_t next_page_id = disk_manager_->GetNumPages();
+    uint32_t size = static_cast<uint32_t>(catalog.size());
+    uint32_t crc = Crc32(catalog.data(), catalog.size());
+    page_id_t first_meta = overflow_count > 0 ? meta_pages_[0] : INVALID_PAGE_ID;
+    memcpy(page.data() + OFFSET_LSN, &checkpoint_lsn, sizeof(lsn_t));
+    memcpy(page.data() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+    memcpy(page.data() + OFFSET_SIZE, &size, sizeof(uint32_t));
+    memcpy(page.data() + OFFSET_CRC, &crc, sizeof(uint32_t));
+    memcpy(page.data() + OFFSET_NEXT_META, &first_meta, sizeof(page_id_t));
+    memcpy(page.data() + HEADER_SIZE, catalog.data(), std::min(catalog.size(), first_cap));
+    return disk_manager_->WritePage(HEADER_PAGE_ID, page.data());
+}
+
+lsn_t CheckpointManager::LoadSnapshot() {
+    std::vector<char> page(PAGE_SIZE);
+    if (!disk_manager_->ReadPage(HEADER_PAGE_ID, page.data()) || memcmp(page.data(), SNAPSHOT_MAGIC, MAGIC_SIZE) != 0) {
+        return 0;
+    }
+
+    lsn_t checkpoint_lsn;
+    page_id_t next_page_id, next_meta;
+    uint32_t size, crc;
+    memcpy(&checkpoint_lsn, page.data() + OFFSET_LSN, sizeof(lsn_t));
+    memcpy(&next_page_id, page.data() + OFFSET_NEXT_PAGE_ID, sizeof(page_id_t));
+    memcpy(&size, page.data() + OFFSET_SIZE, sizeof(uint32_t));
+    memcpy(&crc, page.data() + OFFSET_CRC, sizeof(uint32_t));
+    memcpy(&next_meta, page.data() + OFFSET_NEXT_META, sizeof(page_id_t));
+
+    std::string catalog(page.data() + HEADER_SIZE, std::min<size_t>(size, PAGE_SIZE - HEADER_SIZE));
+    meta_pages_.clear();
+    while (catalog.size() < size && next_meta != INVALID_PAGE_ID) {
+        meta_pages_.push_back(next_meta);
+        if (!disk_manager_->ReadPage(next_meta, page.data())) break;
+        memcpy(&next_meta, page.data(), sizeof(page_id_t));
+        catalog.append(page.data() + OVERFLOW_HEADER_SIZE,
+                       std::min<size_t>(size - catalog.size(), PAGE_SIZE - OVERFLOW_HEADER_SIZE));
+    }
+    if (catalog.size() != size || Crc32(catalog.data(), catalog.size()) != crc) {
+        LOG_ERROR("Checkpoint metadata is corrupt; starting from an empty catalog.");
+        return 0;
+    }
+    disk_manager_->ReservePage(next_page_id - 1);
+
+    ByteReader in{catalog.data(), catalog.data() + catalog.size()};
+    uint32_t table_count = 0;
+    bool ok = in.Get(&table_count);
+    for (uint32_t t = 0; ok && t < table_count; ++t) {
+        table_oid_t oid = 0;
+        std::string name;
+        uint32_t col_count = 0;
+        ok = in.Get(&oid) && in.GetString(&name) && in.Get(&col_count);
+        std::vector<Column> columns;
+        for (uint32_t c = 0; ok && c < col_count; ++c) {
+            std::string col_name;
+            uint8_t type = 0;
+            ok = in.GetString(&col_name) && in.Get(&type);
+            if (ok) columns.emplace_back(col_name, static_cast<TypeId>(type));
+        }
+        page_id_t first_page_id = INVALID_PAGE_ID;
+        ok = ok && in.Get(&first_page_id);
+        if (ok) catalog_->AttachTable(name, oid, Schema(columns), first_page_id);
+    }
+
+    uint32_t index_count = 0;
+    ok = ok && in.Get(&index_count);
+    for (uint32_t i = 0; ok && i < index_count; ++i) {
+        std::string name;
+        table_oid_t oid;
+        uint32_t key_col;
+        page_id_t root_page_id;
+        ok = in.GetString(&name) && in.Get(&oid) && in.Get(&key_col) && in.Get(&root_page_id);
+        TableInfo *table = ok ? catalog_->GetTable(oid) : nullptr;
+        if (table != nullptr) catalog_->AttachIndex(name, table->name_, key_col, root_page_id);
+    }
+    if (!ok) LOG_ERROR("Checkpoint metadata is incomplete.");
+    return checkpoint_lsn;
+}
+
+bool CheckpointManager::Checkpoint(int *pages_written) {
+    if (log_manager_ == nullptr) return false;
+    std::unique_lock<std::shared_mutex> guard(statement_latch_);
+
+    // With statements shut out, the last record is a COMMIT and every page is quiescent.
+    lsn_t checkpoint_lsn = log_manager_->GetLastLSN();
+    if (!bpm_->FlushAllPages() || !WriteMetadata(checkpoint_lsn, SerializeCatalog())) {
+        LOG_ERROR("Checkpoint failed while writing pages.");
+        return false;
+    }
+    int published = disk_manager_->PublishSwap();
+    if (published < 0) {
+        LOG_ERROR("Checkpoint failed while publishing the snapshot.");
+        return false;
+    }
+    // The snapshot now covers every logged change. If the truncation is lost, recovery
+    // skips the stale records by their LSN.
+    if (!log_manager_->Truncate()) return false;
+    if (pages_written != nullptr) *pages_written = published;
+    return true;
+}
+
+void CheckpointManager::StartBackground(size_t log_bytes) {
+    background_thread_ = std::thread([this, log_bytes] { BackgroundLoop(log_bytes); });
+}
+
+void CheckpointManager::BackgroundLoop(size_t log_bytes) {
+    size_t threshold = log_bytes;
+    std::unique_lock<std::mutex> lock(background_latch_);
+    while (!stop_) {
+        background_cv_.wait_for(lock, std::chrono::milliseconds(CHECKPOINT_POLL_MS), [&] { return stop_; });
+        if (stop_ || log_manager_ == nullptr || log_manager_->GetLogSize() < threshold) continue;
+        lock.unlock();
+        // After a failure, wait for another log_bytes of log before trying again.
+        threshold = Checkpoint() ? log_bytes : log_manager_->GetLogSize() + log_bytes;
+        lock.lock();
+    }
+}
+
+} // namespace simpledb
@@ -0,0 +1,191 @@
+#include "recovery/log_manager.h"
+#include "common/logger.h"
+#include <chrono>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace simpledb {
+
+LogManager::LogManager(const std::string &log_file, DurabilityMode mode, size_t group_ms, size_t group_bytes)
+    : log_file_(log_file), mode_(mode), group_ms_(group_ms), group_bytes_(group_bytes) {
+#ifdef _WIN32
+    fd_ = _open(log_file.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    fd_ = open(log_file.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+#endif
+    if (fd_ < 0) {
+        LOG_ERROR("Failed to open log file: " << log_file);
+    }
+
+    // A new log starts with the format marker.
+    struct stat st;
+    if (fd_ >= 0 && fstat(fd_, &st) == 0) file_size_ = static_cast<size_t>(st.st_size);
+    if (file_size_ == 0) buffer_.assign(LOG_FILE_MAGIC, LOG_FILE_MAGIC_SIZE);
+    flush_thread_ = std::thread([this] { FlushLoop(); });
+}
+
+LogManager::~LogManager() {
+    {
+        std::lock_guard<std::mutex> guard(latch_);
+        stop_ = true;
+    }
+    flush_cv_.notify_all();
+    flush_thread_.join();
+    Flush();
+    if (fd_ >= 0) {
+#ifdef _WIN32
+        _close(fd_);
+#else
+        close(fd_);
+#endif
+    }
+}
+
+lsn_t LogManager::AppendRecord(const LogRecord &record) {
+    std::lock_guard<std::mutex> guard(latch_);
+    buffered_lsn_ = next_lsn_++;
+    record.SerializeTo(buffered_lsn_, &buffer_);
+    return buffered_lsn_;
+}
+
+void LogManager::SetNextLSN(lsn_t lsn) {
+    std::lock_guard<std::mutex> guard(latch_);
+    next_lsn_ = lsn;
+}
+
+bool LogManager::Commit(lsn_t lsn) {
+    std::unique_lock<std::mutex> lock(latch_);
+    switch (mode_) {
+    case DurabilityMode::SYNC:
+        // Whoever finds no flush running writes out everything buffered so far, so
+        // committers that arrive during an fsync are covered by the next one together.
+        while (persistent_lsn_ < lsn) {
+            if (flushing_) {
+                done_cv_.wait(lock);
+            } else if (!FlushLocked(lock, true)) {
+                return false;
+            }
+        }
+        break;
+    case DurabilityMode::GROUP:
+        if (buffer_.size() >= group_bytes_) {
+            flush_cv_.notify_one();
+            // Keep the buffer bounded if commits outpace the disk.
+            done_cv_.wait(lock, [&] { return buffer_.size() < 4 * group_bytes_; });
+        }
+        break;
+    case DurabilityMode::OFF:
+        if (buffer_.size() >= group_bytes_) return FlushLocked(lock, false);
+        break;
+    }
+    return true;
+}
+
+bool LogManager::Flush() {
+    std::unique_lock<std::mutex> lock(latch_);
+    return FlushLocked(lock, true);
+}
+
+void LogManager::SetDurability(DurabilityMode mode, size_t group_ms, size_t group_bytes) {
+    std::unique_lock<std::mutex> lock(latch_);
+    mode_ = mode;
+    group_ms_ = group_ms;
+    group_bytes_ = group_bytes;
+    // Commits acknowledged under a weaker mode become durable before the stronger one applies.
+    if (mode_ != DurabilityMode::OFF) FlushLocked(lock, true);
+    flush_cv_.notify_all();
+}
+
+lsn_t LogManager::GetPersistentLSN() {
+    std::lock_guard<std::mutex> guard(latch_);
+    return persistent_lsn_;
+}
+
+lsn_t LogManager::GetLastLSN() {
+    std::lock_guard<std::mutex> guard(latch_);
+    return next_lsn_ - 1;
+}
+
+size_t LogManager::GetLogSize() {
+    std::lock_guard<std::mutex> guard(latch_);
+    return file_size_ + buffer_.size();
+}
+
+bool LogManager::Truncate() {
+    std::unique_lock<std::mutex> lock(latch_);
+    // Flushing first keeps the background writer from appending stale records afterwards.
+    if (!FlushLocked(lock, false)) return false;
+#ifdef _WIN32
+    bool ok = _chsize_s(fd_, LOG_FILE_MAGIC_SIZE) == 0 && _commit(fd_) == 0;
+#else
+    bool ok = ftruncate(fd_, LOG_FILE_MAGIC_SIZE) == 0 && fsync(fd_) == 0;
+#endif
+    if (!ok) {
+        LOG_ERROR("Failed to truncate log file " << log_file_);
+        return false;
+    }
+    file_size_ = LOG_FILE_MAGIC_SIZE;
+    persistent_lsn_ = written_lsn_;
+    return true;
+}
+
+bool LogManager::FlushLocked(std::unique_lock<std::mutex> &lock, bool sync) {
+    done_cv_.wait(lock, [&] { return !flushing_; });
+    if (buffer_.empty() && (!sync || persistent_lsn_ >= written_lsn_)) return true;
+
+    std::string data;
+    data.swap(buffer_);
+    lsn_t upto = buffered_lsn_;
+    flushing_ = true;
+    lock.unlock();
+
+    bool ok = fd_ >= 0;
+    size_t written = 0;
+    while (ok && written < data.size()) {
+#ifdef _WIN32
+        int n = _write(fd_, data.data() + written, static_cast<unsigned>(data.size() - written));
+#else
+        ssize_t n = write(fd_, data.data() + written, data.size() - written);
+#endif
+        if (n <= 0) ok = false;
+        else written += static_cast<size_t>(n);
+    }
+#ifdef _WIN32
+    if (ok && sync) ok = _commit(fd_) == 0;
+#else
+    if (ok && sync) ok = fsync(fd_) == 0;
+#endif
+    if (!ok) LOG_ERROR("I/O error while writing log file " << log_file_);
+
+    lock.lock();
+    flushing_ = false;
+    // On failure the LSNs stay behind and the unwritten tail is requeued, so the next
+    // flush retries it instead of a commit being acknowledged that never reached the disk.
+    file_size_ += written;
+    if (ok) {
+        written_lsn_ = upto;
+        if (sync) persistent_lsn_ = upto;
+    } else {
+        buffer_.insert(0, data, written, std::string::npos);
+    }
+    done_cv_.notify_all();
+    return ok;
+}
+
+void LogManager::FlushLoop() {
+    std::unique_lock<std::mutex> lock(latch_);
+    while (!stop_) {
+        flush_cv_.wait_for(lock, std::chrono::milliseconds(group_ms_), [&] {
+            return stop_ || (mode_ == DurabilityMode::GROUP && buffer_.size() >= group_bytes_);
+        });
+        if (stop_) break;
+        if (mode_ == DurabilityMode::GROUP) FlushLocked(lock, true);
+    }
+}
+
+} // namespace simpledb
@@ -0,0 +1,234 @@
+#include "recovery/log_record.h"
+#include "common/crc32.h"
+#include "common/serialize.h"
+#include <cstring>
+
+namespace simpledb {
+
+LogRecord LogRecord::CreateTable(table_oid_t table_oid, const std::string &table_name, const Schema &schema) {
+    LogRecord record;
+    record.type_ = LogRecordType::CREATE_TABLE;
+    record.table_oid_ = table_oid;
+    record.name_ = table_name;
+    record.columns_ = schema.GetColumns();
+    return record;
+}
+
+LogRecord LogRecord::CreateIndex(table_oid_t table_oid, const std::string &index_name, uint32_t key_col) {
+    LogRecord record;
+    record.type_ = LogRecordType::CREATE_INDEX;
+    record.table_oid_ = table_oid;
+    record.name_ = index_name;
+    record.key_col_ = key_col;
+    return record;
+}
+
+LogRecord LogRecord::NewPage(table_oid_t table_oid, page_id_t prev_page_id, page_id_t page_id) {
+    LogRecord record;
+    record.type_ = LogRecordType::NEW_PAGE;
+    record.table_oid_ = table_oid;
+    record.prev_page_id_ = prev_page_id;
+    record.rid_.Set(page_id, 0);
+    return record;
+}
+
+LogRecord LogRecord::Insert(table_oid_t table_oid, const RID &rid, const char *data, uint32_t size) {
+    LogRecord record;
+    record.type_ = LogRecordType::INSERT;
+    record.table_oid_ = table_oid;
+    record.rid_ = rid;
+    record.data_.assign(data, size);
+    return record;
+}
+
+LogRecord LogRecord::Delete(table_oid_t table_oid, const RID &rid) {
+    LogRecord record;
+    record.type_ = LogRecordType::DELETE;
+    record.table_oid_ = table_oid;
+    record.rid_ = rid;
+    return record;
+}
+
+LogRecord LogRecord::Update(table_oid_t table_oid, const RID &rid, const char *data, uint32_t size) {
+    LogRecord record = Insert(table_oid, rid, data, size);
+    record.type_ = LogRecordType::UPDATE;
+    return record;
+}
+
+LogRecord LogRecord::Commit() {
+    LogRecord record;
+    record.type_ = LogRecordType::COMMIT;
+    return record;
+}
+
+LogRecord LogRecord::InsertBatch(table_oid_t table_oid, page_id_t page_id, std::string tuples) {
+    LogRecord record;
+    record.type_ = LogRecordType::INSERT_BATCH;
+    record.table_oid_ = table_oid;
+    record.rid_.Set(page_id, 0);
+    record.data_ = std::move(tuples);
+    return record;
+}
+
+void LogRecord::AppendBatchTuple(std::string *tuples, uint32_t slot, const char *data, uint32_t size) {
+    PutValue(tuples, slot);
+    PutValue(tuples, size);
+    tuples->append(data, size);
+}
+
+std::vector<std::pair<uint32_t, std::string>> LogRecord::GetBatchTuples() const {
+    std::vector<std::pair<uint32_t, std::string>> tuples;
+    ByteReader in{data_.data(), data_.data() + data_.size()};
+    uint32_t slot, size;
+    while (in.Get(&slot) && in.Get(&size) && static_cast<size_t>(in.end - in.pos) >= size) {
+        tuples.emplace_back(slot, std::string(in.pos, size));
+        in.pos += size;
+    }
+    return tuples;
+}
+
+LogRecord LogRecord::VacuumPage(table_oid_t table_oid, page_id_t page_id) {
+    LogRecord record;
+    record.type_ = LogRecordType::VACUUM_PAGE;
+    record.table_oid_ = table_oid;
+    record.rid_.Set(page_id, 0);
+    return record;
+}
+
+LogRecord LogRecord::LoadPage(table_oid_t table_oid, page_id_t prev_page_id, page_id_t page_id, const char *image) {
+    LogRecord record = NewPage(table_oid, prev_page_id, page_id);
+    record.type_ = LogRecordType::LOAD_PAGE;
+    record.data_.assign(image, PAGE_SIZE);
+    return record;
+}
+
+void LogRecord::SerializeTo(lsn_t lsn, std::string *out) const {
+    size_t start = out->size();
+    PutValue<uint32_t>(out, 0);   // size and CRC are patched in below
+    PutValue<uint32_t>(out, 0);
+    PutValue<lsn_t>(out, lsn);
+    PutValue<uint8_t>(out, static_cast<uint8_t>(type_));
+
+    switch (type_) {
+    case LogRecordType::CREATE_TABLE:
+        PutValue(out, table_oid_);
+        PutString(out, name_);
+        PutValue<uint32_t>(out, static_cast<uint32_t>(columns_.size()));
+        for (const Column &col : columns_) {
+            PutString(out, col.GetName());
+            PutValue<uint8_t>(out, static_cast<uint8_t>(col.GetType()));
+        }
+        break;
+    case LogRecordType::CREATE_INDEX:
+        PutValue(out, table_oid_);
+        PutString(out, name_);
+        PutValue(out, key_col_);
+        break;
+    case LogRecordType::NEW_PAGE:
+        PutValue(out, table_oid_);
+        PutValue(out, prev_page_id_);
+        PutValue(out, rid_.GetPageId());
+        break;
+    case LogRecordType::INSERT_BATCH:
+    case LogRecordType::VACUUM_PAGE:
+        PutValue(out, table_oid_);
+        PutValue(out, rid_.GetPageId());
+        out->append(data_);
+        break;
+    case LogRecordType::LOAD_PAGE:
+        PutValue(out, table_oid_);
+        PutValue(out, prev_page_id_);
+        PutValue(out, rid_.GetPageId());
+        out->append(data_);
+        break;
+    case LogRecordType::INSERT:
+    case LogRecordType::UPDATE:
+    case LogRecordType::DELETE:
+        PutValue(out, table_oid_);
+        PutValue(out, rid_.GetPageId());
+        PutValue(out, rid_.GetSlotNum());
+        // The tuple runs to the end of the record, so it needs no length of its own.
+        out->append(data_);
+        break;
+    case LogRecordType::COMMIT:
+    case LogRecordType::INVALID:
+        break;
+    }
+
+    uint32_t size = static_cast<uint32_t>(out->size() - start);
+    uint32_t crc = Crc32(out->data() + start + 8, size - 8);
+    memcpy(&(*out)[start], &size, sizeof(uint32_t));
+    memcpy(&(*out)[start + 4], &crc, sizeof(uint32_t));
+}
+
+size_t LogRecord::DeserializeFrom(const char *data, size_t size, LogRecord *record) {
+    if (size < HEADER_SIZE) return 0;
+    uint32_t record_size, crc;
+    memcpy(&record_size, data, sizeof(uint32_t));
+    memcpy(&crc, data + 4, sizeof(uint32_t));
+    if (record_size < HEADER_SIZE || record_size > size) return 0;
+    if (Crc32(data + 8, record_size - 8) != crc) return 0;
+
+    *record = LogRecord();
+    ByteReader in{data + 8, data + record_size};
+    uint8_t type = 0;
+    if (!in.Get(&record->lsn_) || !in.Get(&type)) return 0;
+    record->type_ = static_cast<LogRecordType>(type);
+
+    bool ok = true;
+    switch (record->type_) {
+    case LogRecordType::CREATE_TABLE: {
+        uint32_t count = 0;
+        ok = in.Get(&record->table_oid_) && in.GetString(&record->name_) && in.Get(&count);
+        for (uint32_t i = 0; ok && i < count; ++i) {
+            std::string name;
+            uint8_t col_type = 0;
+            ok = in.GetString(&name) && in.Get(&col_type);
+            if (ok) record->columns_.emplace_back(name, static_cast<TypeId>(col_type));
+        }
+        break;
+    }
+    case LogRecordType::CREATE_INDEX:
+        ok = in.Get(&record->table_oid_) && in.GetString(&record->name_) && in.Get(&record->key_col_);
+        break;
+    case LogRecordType::NEW_PAGE: {
+        page_id_t page_id = INVALID_PAGE_ID;
+        ok = in.Get(&record->table_oid_) && in.Get(&record->prev_page_id_) && in.Get(&page_id);
+        record->rid_.Set(page_id, 0);
+        break;
+    }
+    case LogRecordType::INSERT_BATCH:
+    case LogRecordType::VACUUM_PAGE: {
+        page_id_t page_id = INVALID_PAGE_ID;
+        ok = in.Get(&record->table_oid_) && in.Get(&page_id);
+        record->rid_.Set(page_id, 0);
+        if (ok) record->data_.assign(in.pos, in.end - in.pos);
+        break;
+    }
+    case LogRecordType::LOAD_PAGE: {
+        page_id_t page_id = INVALID_PAGE_ID;
+        ok = in.Get(&record->table_oid_) && in.Get(&record->prev_page_id_) && in.Get(&page_id) &&
+             static_cast<size_t>(in.end - in.pos) == PAGE_SIZE;
+        record->rid_.Set(page_id, 0);
+        if (ok) record->data_.assign(in.pos, PAGE_SIZE);
+        break;
+    }
+    case LogRecordType::INSERT:
+    case LogRecordType::UPDATE:
+    case LogRecordType::DELETE: {
+        page_id_t page_id = INVALID_PAGE_ID;
+        uint32_t slot = 0;
+        ok = in.Get(&record->table_oid_) && in.Get(&page_id) && in.Get(&slot);
+        record->rid_.Set(page_id, slot);
+        if (ok) record->data_.assign(in.pos, in.end - in.pos);
+        break;
+    }
+    case LogRecordType::COMMIT:
+        break;
+    default:
+        ok = false;
+    }
+    return ok ? record_size : 0;
+}
+
+} // namespace simpledb
@@ -0,0 +1,306 @@
+#include "recovery/log_recovery.h"
+#include "common/logger.h"
+#include "storage/table_page.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace simpledb {
+
+namespace {
+
+// Largest record accepted; anything claiming to be bigger is treated as corruption.
+constexpr size_t READ_BUFFER_SIZE = 1 << 20;
+
+// Records handed to a worker at a time, and how many batches may wait per worker
+// before decoding pauses.
+constexpr size_t REDO_BATCH_SIZE = 256;
+constexpr size_t REDO_MAX_QUEUED_BATCHES = 16;
+
+// Decodes records straight out of a large read buffer; a record split across reads is
+// moved to the front before the next read. Stops at the end of the file or at the first
+// record that does not decode.
+class LogReader {
+public:
+    explicit LogReader(std::ifstream *in) : in_(in), buf_(READ_BUFFER_SIZE) {}
+
+    bool Next(LogRecord *record) {
+        while (true) {
+            size_t used = LogRecord::DeserializeFrom(buf_.data() + begin_, end_ - begin_, record);
+            if (used != 0) {
+                begin_ += used;
+                return true;
+            }
+            if (eof_ || end_ - begin_ == buf_.size()) return false;
+            memmove(buf_.data(), buf_.data() + begin_, end_ - begin_);
+            buf_offset_ += begin_;
+            end_ -= begin_;
+            begin_ = 0;
+            in_->read(buf_.data() + end_, buf_.size() - end_);
+            end_ += static_cast<size_t>(in_->gcount());
+            eof_ = !*in_;
+        }
+    }
+
+    // File offset just past the last record returned
+    size_t GetOffset() const { return buf_offset_ + begin_; }
+    // Bytes of the file read so far; the whole file once Next has returned false
+    size_t GetBytesRead() const { return buf_offset_ + end_; }
+
+private:
+    std::ifstream *in_;
+    std::vector<char> buf_;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+    size_t buf_offset_ = LOG_FILE_MAGIC_SIZE;   // file offset of buf_[0]
+    bool eof_ = false;
+};
+
+} // namespace
+
+LogRecovery::LogRecovery(Catalog *catalog, DiskManager *disk_manager, size_t num_workers)
+    : catalog_(catalog), disk_manager_(disk_manager) {
+    // One worker cannot overlap anything, so it replays inline on the decoding thread.
+    if (num_workers == 1) num_workers = 0;
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+        Worker *worker = workers_.back().get();
+        worker->thread = std::thread([this, worker] { WorkerLoop(worker); });
+    }
+}
+
+LogRecovery::~LogRecovery() {
+    for (auto &worker : workers_) {
+        {
+            std::lock_guard<std::mutex> guard(worker->latch);
+            worker->stop = true;
+        }
+        worker->cv.notify_all();
+        worker->thread.join();
+    }
+}
+
+bool LogRecovery::IsLegacyLog(const std::string &log_file) {
+    std::ifstream in(log_file, std::ios::binary);
+    char magic[LOG_FILE_MAGIC_SIZE];
+    if (!in.read(magic, LOG_FILE_MAGIC_SIZE)) return in.gcount() > 0;
+    return memcmp(magic, LOG_FILE_MAGIC, LOG_FILE_MAGIC_SIZE) != 0;
+}
+
+bool LogRecovery::Recover(const std::string &log_file, lsn_t checkpoint_lsn) {
+    auto start = std::chrono::steady_clock::now();
+    next_lsn_ = checkpoint_lsn + 1;
+    std::ifstream in(log_file, std::ios::binary);
+    if (!in.is_open()) return true;
+
+    char magic[LOG_FILE_MAGIC_SIZE];
+    if (!in.read(magic, LOG_FILE_MAGIC_SIZE)) return true;
+    if (memcmp(magic, LOG_FILE_MAGIC, LOG_FILE_MAGIC_SIZE) != 0) {
+        LOG_ERROR("Unrecognized log format: " << log_file);
+        return false;
+    }
+
+    // Redo allocates index pages as B+ tree nodes split, possibly on several workers at
+    // once. Reserve every heap page the log creates first, so none of them is handed out.
+    LogRecord record;
+    {
+        LogReader reader(&in);
+        while (reader.Next(&record)) {
+            LogRecordType type = record.GetType();
+            bool creates_page = type == LogRecordType::NEW_PAGE || type == LogRecordType::LOAD_PAGE;
+            if (creates_page && record.GetLSN() > checkpoint_lsn) disk_manager_->ReservePage(record.GetRID().GetPageId());
+        }
+    }
+    in.clear();
+    in.seekg(LOG_FILE_MAGIC_SIZE);
+
+    LogReader reader(&in);
+    size_t committed_end = LOG_FILE_MAGIC_SIZE;
+    while (reader.Next(&record)) {
+        next_lsn_ = std::max(next_lsn_, record.GetLSN() + 1);
+        // Left behind if a crash came between a checkpoint and the log truncation.
+        if (record.GetLSN() <= checkpoint_lsn) {
+            committed_end = reader.GetOffset();
+            continue;
+        }
+        record_count_++;
+
+        if (record.GetType() == LogRecordType::COMMIT) {
+            for (LogRecord &change : pending_) Dispatch(std::move(change));
+            pending_.clear();
+            committed_end = reader.GetOffset();
+        } else {
+            pending_.push_back(std::move(record));
+        }
+    }
+
+    size_t file_size = reader.GetBytesRead();
+    if (committed_end < file_size) {
+        LOG_WARN("Discarding " << file_size - committed_end << " bytes of incomplete log tail");
+        in.close();
+        std::error_code ec;
+        std::filesystem::resize_file(log_file, committed_end, ec);
+        if (ec) LOG_ERROR("Failed to truncate log file: " << ec.message());
+    }
+    pending_.clear();
+    Drain();
+
+    for (const LogRecord &index : deferred_indexes_) {
+        TableInfo *table = catalog_->GetTable(index.GetTableOid());
+        if (table == nullptr || catalog_->CreateIndex(index.GetName(), table->name_, index.GetKeyCol()) == nullptr) {
+            LOG_ERROR("Failed to rebuild index " << index.GetName());
+        }
+    }
+    deferred_indexes_.clear();
+
+    if (record_count_ > 0) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("Replayed " << record_count_ << " log records in " << seconds << " s ("
+                 << static_cast<uint64_t>(record_count_ / std::max(seconds, 1e-6)) << " records/s, "
+                 << std::max<size_t>(workers_.size(), 1) << " threads).");
+    }
+    return true;
+}
+
+void LogRecovery::Dispatch(LogRecord record) {
+    if (record.GetType() == LogRecordType::CREATE_TABLE) {
+        // Workers look tables up without the catalog, so it only changes while they are idle.
+        Drain();
+        if (catalog_->AttachTable(record.GetName(), record.GetTableOid(), Schema(record.GetColumns()),
+                                  INVALID_PAGE_ID) == nullptr) {
+            LOG_ERROR("Failed to redo creation of table " << record.GetName());
+        }
+        return;
+    }
+    if (record.GetType() == LogRecordType::CREATE_INDEX) {
+        deferred_indexes_.push_back(std::move(record));
+        return;
+    }
+
+    TableInfo *table = catalog_->GetTable(record.GetTableOid());
+    if (table == nullptr) {
+        LOG_ERROR("Log record " << record.GetLSN() << " refers to unknown table " << record.GetTableOid());
+        return;
+    }
+    RedoTask task{table, &catalog_->GetTableIndexes(table->name_), std::move(record)};
+    if (workers_.empty()) {
+        Redo(task);
+        return;
+    }
+    Worker *worker = workers_[table->oid_ % workers_.size()].get();
+    worker->batch.push_back(std::move(task));
+    if (worker->batch.size() >= REDO_BATCH_SIZE) Submit(worker);
+}
+
+void LogRecovery::Submit(Worker *worker) {
+    if (worker->batch.empty()) return;
+    std::unique_lock<std::mutex> lock(worker->latch);
+    worker->cv.wait(lock, [&] { return worker->queue.size() < REDO_MAX_QUEUED_BATCHES; });
+    worker->queue.push_back(std::move(worker->batch));
+    worker->batch.clear();
+    lock.unlock();
+    worker->cv.notify_all();
+}
+
+void LogRecovery::Drain() {
+    for (auto &worker : workers_) Submit(worker.get());
+    for (auto &worker : workers_) {
+        std::unique_lock<std::mutex> lock(worker->latch);
+        worker->cv.wait(lock, [&] { return worker->queue.empty() && !worker->busy; });
+    }
+}
+
+void LogRecovery::WorkerLoop(Worker *worker) {
+    std::unique_lock<std::mutex> lock(worker->latch);
+    while (true) {
+        worker->cv.wait(lock, [&] { return worker->stop || !worker->queue.empty(); });
+        if (worker->queue.empty()) return;
+        std::vector<RedoTask> batch = std::move(worker->queue.front());
+        worker->queue.pop_front();
+        worker->busy = true;
+        lock.unlock();
+        worker->cv.notify_all();
+
+        for (const RedoTask &task : batch) Redo(task);
+
+        lock.lock();
+        worker->busy = false;
+        worker->cv.notify_all();
+    }
+}
+
+void LogRecovery::Redo(const RedoTask &task) {
+    const LogRecord &record = task.record;
+    TableInfo *table = task.table;
+    TableHeap *heap = table->table_.get();
+    bool indexed = !task.indexes->empty();
+    std::string old_data;
+    bool applied = false;
+    bool ok = false;
+    switch (record.GetType()) {
+    case LogRecordType::NEW_PAGE:
+        ok = heap->RedoNewPage(record.GetPrevPageId(), record.GetRID().GetPageId(), record.GetLSN());
+        break;
+    case LogRecordType::LOAD_PAGE:
+        ok = heap->RedoNewPage(record.GetPrevPageId(), record.GetRID().GetPageId(), record.GetLSN(),
+                               record.GetTupleData().data(), &applied);
+        break;
+    case LogRecordType::INSERT:
+        ok = heap->RedoInsert(record.GetRID(), record.GetTupleData(), record.GetLSN(), &applied);
+        break;
+    case LogRecordType::INSERT_BATCH:
+        ok = heap->RedoInsertBatch(record.GetRID().GetPageId(), record.GetBatchTuples(), record.GetLSN(), &applied);
+        break;
+    case LogRecordType::VACUUM_PAGE:
+        ok = heap->RedoVacuumPage(record.GetRID().GetPageId(), record.GetLSN());
+        break;
+    case LogRecordType::DELETE:
+        ok = heap->RedoDelete(record.GetRID(), record.GetLSN(), &applied, indexed ? &old_data : nullptr);
+        break;
+    case LogRecordType::UPDATE:
+        ok = heap->RedoUpdate(record.GetRID(), record.GetTupleData(), record.GetLSN(), &applied,
+                              indexed ? &old_data : nullptr);
+        break;
+    default:
+        break;
+    }
+    if (!ok) LOG_ERROR("Failed to redo log record " << record.GetLSN());
+    if (!applied || !indexed) return;
+    if (record.GetType() == LogRecordType::LOAD_PAGE) {
+        IndexLoadedPage(table, *task.indexes, record);
+    } else if (record.GetType() == LogRecordType::INSERT_BATCH) {
+        for (const auto &[slot, data] : record.GetBatchTuples()) {
+            UpdateIndexes(table, *task.indexes, old_data, data, RID(record.GetRID().GetPageId(), slot));
+        }
+    } else {
+        UpdateIndexes(table, *task.indexes, old_data, record.GetTupleData(), record.GetRID());
+    }
+}
+
+void LogRecovery::IndexLoadedPage(TableInfo *table, const std::vector<IndexInfo *> &indexes,
+                                  const LogRecord &record) {
+    // Every tuple on a loaded page is new, stored under consecutive slots.
+    std::string image = record.GetTupleData();
+    TablePage page(image.data());
+    for (uint32_t slot = 0; slot < page.GetSlotCount(); ++slot) {
+        uint32_t size;
+        const char *data = page.GetTuple(slot, &size);
+        if (data == nullptr) continue;
+        UpdateIndexes(table, indexes, std::string(), std::string(data, size), RID(record.GetRID().GetPageId(), slot));
+    }
+}
+
+void LogRecovery::UpdateIndexes(TableInfo *table, const std::vector<IndexInfo *> &indexes,
+                                const std::string &old_data, const std::string &new_data, const RID &rid) {
+    const Schema *schema = table->schema_.get();
+    Tuple old_tuple, new_tuple;
+    if (!old_data.empty()) old_tuple.DeserializeFrom(*schema, old_data.data());
+    if (!new_data.empty()) new_tuple.DeserializeFrom(*schema, new_data.data());
+    for (IndexInfo *index : indexes) {
+        if (!old_data.empty()) index->index_->DeleteEntry(old_tuple.GetValue(schema, index->key_col_), rid);
+        if (!new_data.empty()) index->index_->InsertEntry(new_tuple.GetValue(schema, index->key_col_), rid);
+    }
+}
+
+} // namespace simpledb
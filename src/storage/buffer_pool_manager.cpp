@@ -1,85 +1,154 @@
 #include "storage/buffer_pool_manager.h"
+#include "storage/clock_replacer.h"
+#include "storage/lru_k_replacer.h"
 #include "common/logger.h"
+#include <cstring>
 
 namespace simpledb {
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager) {
+BufferPoolShard::BufferPoolShard(size_t pool_size, DiskScheduler *disk_scheduler, ReplacerType replacer)
+    : pool_size_(pool_size), disk_scheduler_(disk_scheduler), disk_manager_(disk_scheduler->GetDiskManager()) {
     pages_ = new Page[pool_size_];
     frame_info_ = new FrameInfo[pool_size_];
+    if (replacer == ReplacerType::CLOCK) {
+        replacer_ = std::make_unique<ClockReplacer>(pool_size_);
+    } else {
+        replacer_ = std::make_unique<LRUKReplacer>(pool_size_, LRUK_REPLACER_K);
+    }
 
     for (size_t i = 0; i < pool_size_; ++i) {
         free_list_.push_back(static_cast<frame_id_t>(i));
     }
 }
 
-BufferPoolManager::~BufferPoolManager() {
+BufferPoolShard::~BufferPoolShard() {
     for (auto const& [page_id, frame_id] : page_table_) {
         if (frame_info_[frame_id].is_dirty) {
-            FlushPage(page_id);
+            disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
         }
     }
     delete[] pages_;
     delete[] frame_info_;
 }
 
-bool BufferPoolManager::FindVictim(frame_id_t *frame_id) {
+bool BufferPoolShard::AcquireFrame(frame_id_t *frame_id, page_id_t *evicted_page_id, bool *evicted_dirty) {
+    *evicted_page_id = INVALID_PAGE_ID;
+    *evicted_dirty = false;
     if (!free_list_.empty()) {
         *frame_id = free_list_.front();
         free_list_.pop_front();
         return true;
     }
 
-    for (auto it = eviction_list_.begin(); it != eviction_list_.end(); ++it) {
-        frame_id_t victim_frame_id = *it;
-        if (frame_info_[victim_frame_id].pin_count == 0) {
-            *frame_id = victim_frame_id;
-            eviction_list_.erase(it);
+    frame_id_t victim_frame_id;
+    if (!replacer_->Victim(&victim_frame_id)) {
+        return false; // All pages pinned
+    }
+    *frame_id = victim_frame_id;
 
-            page_id_t victim_page_id = pages_[victim_frame_id].GetPageId();
-            if (frame_info_[victim_frame_id].is_dirty) {
-                disk_manager_->WritePage(victim_page_id, pages_[victim_frame_id].GetData());
-            }
+    page_id_t victim_page_id = pages_[victim_frame_id].GetPageId();
+    page_table_.erase(victim_page_id);
+    if (frame_info_[victim_frame_id].is_dirty) {
+        *evicted_page_id = victim_page_id;
+        *evicted_dirty = true;
+        writing_back_.insert(victim_page_id);
+    }
+    frame_info_[victim_frame_id].is_dirty = false;
+    return true;
+}
 
-            page_table_.erase(victim_page_id);
-            frame_info_[victim_frame_id].is_dirty = false;
-            return true;
-        }
+void BufferPoolShard::ReleaseFrame(frame_id_t frame_id) {
+    if (--frame_info_[frame_id].pin_count > 0) return;
+    if (pages_[frame_id].GetPageId() != INVALID_PAGE_ID) {
+        replacer_->SetEvictable(frame_id, true);
+        return;
     }
-    return false; // All pages pinned
+    replacer_->Remove(frame_id);
+    frame_info_[frame_id].is_dirty = false;
+    free_list_.push_back(frame_id);
 }
 
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-    if (page_table_.count(page_id) > 0) {
-        frame_id_t frame_id = page_table_[page_id];
+Page *BufferPoolShard::FetchPage(page_id_t page_id, AccessType access_type) {
+    std::unique_lock<std::mutex> lock(latch_);
+    while (true) {
+        // A page still being written back must not be re-read until the write lands.
+        io_cv_.wait(lock, [&] { return writing_back_.count(page_id) == 0; });
+
+        auto it = page_table_.find(page_id);
+        if (it == page_table_.end()) break;
+        frame_id_t frame_id = it->second;
         frame_info_[frame_id].pin_count++;
-        return &pages_[frame_id];
+        replacer_->RecordAccess(frame_id, access_type);
+        replacer_->SetEvictable(frame_id, false);
+        io_cv_.wait(lock, [&] { return !frame_info_[frame_id].io_pending; });
+        // If the load we waited for failed, the frame no longer holds the page: look again.
+        it = page_table_.find(page_id);
+        if (it != page_table_.end() && it->second == frame_id) return &pages_[frame_id];
+        ReleaseFrame(frame_id);
     }
 
     frame_id_t frame_id;
-    if (!FindVictim(&frame_id)) {
+    page_id_t evicted_page_id;
+    bool evicted_dirty;
+    if (!AcquireFrame(&frame_id, &evicted_page_id, &evicted_dirty)) {
         return nullptr;
     }
 
-    pages_[frame_id].ResetMemory();
-    disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
-    pages_[frame_id].SetPageId(page_id);
-    
+    Page *page = &pages_[frame_id];
     page_table_[page_id] = frame_id;
     frame_info_[frame_id].pin_count = 1;
     frame_info_[frame_id].is_dirty = false;
-    eviction_list_.push_back(frame_id);
+    frame_info_[frame_id].io_pending = true;
+    replacer_->RecordAccess(frame_id, access_type);
+    replacer_->SetEvictable(frame_id, false);
+    lock.unlock();
+
+    // Hand a copy of the victim to the scheduler so its write-back runs alongside the read.
+    // The read stays on this thread: it has to wait for it anyway.
+    thread_local char victim_data[PAGE_SIZE];
+    std::future<bool> write_back;
+    if (evicted_dirty) {
+        memcpy(victim_data, page->GetData(), PAGE_SIZE);
+        write_back = disk_scheduler_->Submit(true, evicted_page_id, victim_data);
+    }
+    bool read_ok = disk_manager_->ReadPage(page_id, page->GetData());
+    bool write_ok = !evicted_dirty || write_back.get();
 
-    return &pages_[frame_id];
+    lock.lock();
+    if (evicted_dirty) writing_back_.erase(evicted_page_id);
+    frame_info_[frame_id].io_pending = false;
+    io_cv_.notify_all();
+    if (read_ok && write_ok) {
+        page->SetPageId(page_id);
+        return page;
+    }
+
+    page_table_.erase(page_id);
+    if (!write_ok) {
+        // Put the victim back, still dirty, so its changes are not lost.
+        LOG_ERROR("Failed to write back page " << evicted_page_id);
+        memcpy(page->GetData(), victim_data, PAGE_SIZE);
+        page->SetPageId(evicted_page_id);
+        page_table_[evicted_page_id] = frame_id;
+        frame_info_[frame_id].is_dirty = true;
+    } else {
+        page->SetPageId(INVALID_PAGE_ID);
+    }
+    ReleaseFrame(frame_id);
+    return nullptr;
 }
 
-bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-    if (page_table_.count(page_id) == 0) return false;
+bool BufferPoolShard::UnpinPage(page_id_t page_id, bool is_dirty) {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto it = page_table_.find(page_id);
+    if (it == page_table_.end()) return false;
 
-    frame_id_t frame_id = page_table_[page_id];
+    frame_id_t frame_id = it->second;
     if (frame_info_[frame_id].pin_count <= 0) return false;
 
-    frame_info_[frame_id].pin_count--;
+    if (--frame_info_[frame_id].pin_count == 0) {
+        replacer_->SetEvictable(frame_id, true);
+    }
     if (is_dirty) {
         frame_info_[frame_id].is_dirty = true;
     }
@@ -87,30 +156,154 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
     return true;
 }
 
-bool BufferPoolManager::FlushPage(page_id_t page_id) {
-    if (page_table_.count(page_id) == 0) return false;
+bool BufferPoolShard::FlushPage(page_id_t page_id) {
+    std::unique_lock<std::mutex> lock(latch_);
+    auto it = page_table_.find(page_id);
+    if (it == page_table_.end()) return false;
 
-    frame_id_t frame_id = page_table_[page_id];
-    disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
+    // Pin the frame for the duration of the write and clear the dirty bit first, so a
+    // modification that lands after the write re-marks the page dirty.
+    frame_id_t frame_id = it->second;
+    io_cv_.wait(lock, [&] { return !frame_info_[frame_id].io_pending; });
+    frame_info_[frame_id].pin_count++;
+    replacer_->SetEvictable(frame_id, false);
     frame_info_[frame_id].is_dirty = false;
+    lock.unlock();
 
-    return true;
+    Page *page = &pages_[frame_id];
+    page->RLatch();
+    bool ok = disk_manager_->WritePage(page_id, page->GetData());
+    page->RUnlatch();
+
+    lock.lock();
+    if (!ok) {
+        LOG_ERROR("Failed to flush page " << page_id);
+        frame_info_[frame_id].is_dirty = true;
+    }
+    ReleaseFrame(frame_id);
+    return ok;
 }
 
-Page *BufferPoolManager::NewPage(page_id_t *page_id) {
+Page *BufferPoolShard::NewPage(page_id_t page_id) {
+    std::unique_lock<std::mutex> lock(latch_);
     frame_id_t frame_id;
-    if (!FindVictim(&frame_id)) return nullptr;
+    page_id_t evicted_page_id;
+    bool evicted_dirty;
+    if (!AcquireFrame(&frame_id, &evicted_page_id, &evicted_dirty)) return nullptr;
 
-    *page_id = disk_manager_->AllocatePage();
-    pages_[frame_id].ResetMemory();
-    pages_[frame_id].SetPageId(*page_id);
-
-    page_table_[*page_id] = frame_id;
+    Page *page = &pages_[frame_id];
+    page_table_[page_id] = frame_id;
     frame_info_[frame_id].pin_count = 1;
     frame_info_[frame_id].is_dirty = false;
-    eviction_list_.push_back(frame_id);
+    frame_info_[frame_id].io_pending = true;
+    replacer_->RecordAccess(frame_id, AccessType::UNKNOWN);
+    replacer_->SetEvictable(frame_id, false);
+    lock.unlock();
+
+    bool write_ok = !evicted_dirty || disk_manager_->WritePage(evicted_page_id, page->GetData());
+    if (write_ok) {
+        page->ResetMemory();
+        page->SetPageId(page_id);
+    }
+
+    lock.lock();
+    if (evicted_dirty) writing_back_.erase(evicted_page_id);
+    frame_info_[frame_id].io_pending = false;
+    io_cv_.notify_all();
+    if (write_ok) return page;
+
+    // The frame still holds the victim: keep it there, dirty, and fail the call.
+    LOG_ERROR("Failed to write back page " << evicted_page_id);
+    page_table_.erase(page_id);
+    page_table_[evicted_page_id] = frame_id;
+    frame_info_[frame_id].is_dirty = true;
+    ReleaseFrame(frame_id);
+    return nullptr;
+}
 
-    return &pages_[frame_id];
+void BufferPoolShard::BeginFlushAll(std::vector<Page *> *pages) {
+    std::lock_guard<std::mutex> guard(latch_);
+    for (auto const& [page_id, frame_id] : page_table_) {
+        FrameInfo &info = frame_info_[frame_id];
+        if (!info.is_dirty || info.io_pending) continue;
+        info.pin_count++;
+        info.is_dirty = false;
+        replacer_->SetEvictable(frame_id, false);
+        pages->push_back(&pages_[frame_id]);
+    }
+}
+
+void BufferPoolShard::EndFlush(Page *page, bool written) {
+    std::lock_guard<std::mutex> guard(latch_);
+    frame_id_t frame_id = static_cast<frame_id_t>(page - pages_);
+    // A page whose write failed stays dirty for the next flush.
+    if (!written) frame_info_[frame_id].is_dirty = true;
+    ReleaseFrame(frame_id);
+}
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, ReplacerType replacer,
+                                     size_t num_shards)
+    : pool_size_(pool_size), disk_manager_(disk_manager),
+      disk_scheduler_(std::make_unique<DiskScheduler>(disk_manager)) {
+    if (num_shards == 0) num_shards = 1;
+    if (num_shards > pool_size_) num_shards = pool_size_;
+    for (size_t i = 0; i < num_shards; ++i) {
+        size_t frames = pool_size_ / num_shards + (i < pool_size_ % num_shards ? 1 : 0);
+        shards_.push_back(std::make_unique<BufferPoolShard>(frames, disk_scheduler_.get(), replacer));
+    }
+}
+
+BufferPoolManager::~BufferPoolManager() {
+    FlushAllPages();
+    shards_.clear();
+}
+
+Page *BufferPoolManager::FetchPage(page_id_t page_id, AccessType access_type) {
+    return ShardFor(page_id).FetchPage(page_id, access_type);
+}
+
+bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+    return ShardFor(page_id).UnpinPage(page_id, is_dirty);
+}
+
+bool BufferPoolManager::FlushPage(page_id_t page_id) {
+    return ShardFor(page_id).FlushPage(page_id);
+}
+
+bool BufferPoolManager::FlushAllPages() {
+    std::vector<std::vector<Page *>> dirty(shards_.size());
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        shards_[i]->BeginFlushAll(&dirty[i]);
+    }
+
+    // Pages are read-latched only once every shard latch is released, since a writer may
+    // hold a page latch while it waits for a shard.
+    std::vector<std::future<bool>> writes;
+    for (auto &pages : dirty) {
+        for (Page *page : pages) {
+            page->RLatch();
+            writes.push_back(disk_scheduler_->Submit(true, page->GetPageId(), page->GetData()));
+        }
+    }
+    size_t n = 0;
+    bool ok = true;
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        for (Page *page : dirty[i]) {
+            bool written = writes[n++].get();
+            if (!written) {
+                LOG_ERROR("Failed to flush page " << page->GetPageId());
+                ok = false;
+            }
+            page->RUnlatch();
+            shards_[i]->EndFlush(page, written);
+        }
+    }
+    return ok;
+}
+
+Page *BufferPoolManager::NewPage(page_id_t *page_id) {
+    *page_id = disk_manager_->AllocatePage();
+    return ShardFor(*page_id).NewPage(*page_id);
 }
 
 } // namespace simpledb
@@ -0,0 +1,46 @@
+#include "storage/clock_replacer.h"
+
+namespace simpledb {
+
+ClockReplacer::ClockReplacer(size_t num_frames) : frames_(num_frames) {}
+
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+    if (size_ == 0) return false;
+    // Two full sweeps are enough: the first clears every reference bit it passes.
+    for (size_t steps = 0; steps < 2 * frames_.size() + 1; ++steps) {
+        FrameState &f = frames_[hand_];
+        size_t current = hand_;
+        hand_ = (hand_ + 1) % frames_.size();
+        if (!f.present || !f.evictable) continue;
+        if (f.referenced) {
+            f.referenced = false;
+            continue;
+        }
+        f = FrameState();
+        size_--;
+        *frame_id = static_cast<frame_id_t>(current);
+        return true;
+    }
+    return false;
+}
+
+void ClockReplacer::RecordAccess(frame_id_t frame_id, AccessType type) {
+    FrameState &f = frames_[frame_id];
+    f.present = true;
+    if (type != AccessType::SCAN) f.referenced = true;
+}
+
+void ClockReplacer::SetEvictable(frame_id_t frame_id, bool evictable) {
+    FrameState &f = frames_[frame_id];
+    if (!f.present || f.evictable == evictable) return;
+    f.evictable = evictable;
+    if (evictable) size_++; else size_--;
+}
+
+void ClockReplacer::Remove(frame_id_t frame_id) {
+    FrameState &f = frames_[frame_id];
+    if (f.present && f.evictable) size_--;
+    f = FrameState();
+}
+
+} // namespace simpledb
@@ -0,0 +1,178 @@
+#include "storage/column_filter.h"
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SIMPLEDB_FILTER_AVX2 1
+#define SIMPLEDB_FILTER_SSE2 1
+#define SIMPLEDB_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_M_X64)
+#include <emmintrin.h>
+#define SIMPLEDB_FILTER_SSE2 1
+#define SIMPLEDB_TARGET(isa)
+#endif
+
+namespace simpledb {
+
+namespace {
+
+// Every operator is one of three comparisons, possibly negated: NE = !EQ, LE = !GT, GE = !LT.
+enum class BaseOp { EQ, GT, LT };
+
+BaseOp Decompose(CompareOp op, bool *negate) {
+    *negate = op == CompareOp::NE || op == CompareOp::LE || op == CompareOp::GE;
+    if (op == CompareOp::EQ || op == CompareOp::NE) return BaseOp::EQ;
+    if (op == CompareOp::GT || op == CompareOp::LE) return BaseOp::GT;
+    return BaseOp::LT;
+}
+
+template <BaseOp OP, typename T>
+inline bool Compare(const T &a, const T &b) {
+    if constexpr (OP == BaseOp::EQ) return a == b;
+    if constexpr (OP == BaseOp::GT) return a > b;
+    return a < b;
+}
+
+template <BaseOp OP>
+void ScalarInt32(const int32_t *data, size_t n, int32_t literal, bool negate, uint64_t *bitmap) {
+    for (size_t base = 0; base < n; base += 64) {
+        size_t count = std::min<size_t>(64, n - base);
+        uint64_t word = 0;
+        for (size_t i = 0; i < count; ++i) {
+            word |= static_cast<uint64_t>(Compare<OP>(data[base + i], literal)) << i;
+        }
+        if (negate) word = ~word;
+        if (count < 64) word &= (uint64_t{1} << count) - 1;
+        bitmap[base / 64] = word;
+    }
+}
+
+#ifdef SIMPLEDB_FILTER_SSE2
+template <BaseOp OP>
+SIMPLEDB_TARGET("sse2")
+void Sse2Int32(const int32_t *data, size_t n, int32_t literal, bool negate, uint64_t *bitmap) {
+    __m128i lit = _mm_set1_epi32(literal);
+    size_t words = n / 64;
+    for (size_t w = 0; w < words; ++w) {
+        const int32_t *block = data + w * 64;
+        uint64_t word = 0;
+        for (size_t j = 0; j < 16; ++j) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + j * 4));
+            __m128i m;
+            if constexpr (OP == BaseOp::EQ) m = _mm_cmpeq_epi32(v, lit);
+            else if constexpr (OP == BaseOp::GT) m = _mm_cmpgt_epi32(v, lit);
+            else m = _mm_cmplt_epi32(v, lit);
+            word |= static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(m))) << (j * 4);
+        }
+        bitmap[w] = negate ? ~word : word;
+    }
+    ScalarInt32<OP>(data + words * 64, n - words * 64, literal, negate, bitmap + words);
+}
+#endif
+
+#ifdef SIMPLEDB_FILTER_AVX2
+template <BaseOp OP>
+SIMPLEDB_TARGET("avx2")
+void Avx2Int32(const int32_t *data, size_t n, int32_t literal, bool negate, uint64_t *bitmap) {
+    __m256i lit = _mm256_set1_epi32(literal);
+    size_t words = n / 64;
+    for (size_t w = 0; w < words; ++w) {
+        const int32_t *block = data + w * 64;
+        uint64_t word = 0;
+        for (size_t j = 0; j < 8; ++j) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + j * 8));
+            __m256i m;
+            if constexpr (OP == BaseOp::EQ) m = _mm256_cmpeq_epi32(v, lit);
+            else if constexpr (OP == BaseOp::GT) m = _mm256_cmpgt_epi32(v, lit);
+            else m = _mm256_cmpgt_epi32(lit, v);
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(m))))
+                    << (j * 8);
+        }
+        bitmap[w] = negate ? ~word : word;
+    }
+    ScalarInt32<OP>(data + words * 64, n - words * 64, literal, negate, bitmap + words);
+}
+#endif
+
+template <BaseOp OP>
+void DispatchInt32(const int32_t *data, size_t n, int32_t literal, bool negate, uint64_t *bitmap,
+                   FilterKernel kernel) {
+#ifdef SIMPLEDB_FILTER_AVX2
+    if (kernel == FilterKernel::AVX2) return Avx2Int32<OP>(data, n, literal, negate, bitmap);
+#endif
+#ifdef SIMPLEDB_FILTER_SSE2
+    if (kernel != FilterKernel::SCALAR) return Sse2Int32<OP>(data, n, literal, negate, bitmap);
+#endif
+    ScalarInt32<OP>(data, n, literal, negate, bitmap);
+}
+
+template <BaseOp OP>
+void ScalarString(const uint32_t *offsets, const char *chars, size_t n, std::string_view literal, bool negate,
+                  uint64_t *bitmap) {
+    for (size_t base = 0; base < n; base += 64) {
+        size_t count = std::min<size_t>(64, n - base);
+        uint64_t word = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t *off = offsets + base + i;
+            std::string_view s(chars + off[0], off[1] - off[0]);
+            word |= static_cast<uint64_t>(Compare<OP>(s, literal)) << i;
+        }
+        if (negate) word = ~word;
+        if (count < 64) word &= (uint64_t{1} << count) - 1;
+        bitmap[base / 64] = word;
+    }
+}
+
+FilterKernel DetectFilterKernel() {
+#ifdef SIMPLEDB_FILTER_AVX2
+    if (__builtin_cpu_supports("avx2")) return FilterKernel::AVX2;
+#endif
+#ifdef SIMPLEDB_FILTER_SSE2
+#if defined(__GNUC__)
+    if (__builtin_cpu_supports("sse2")) return FilterKernel::SSE2;
+#else
+    return FilterKernel::SSE2;
+#endif
+#endif
+    return FilterKernel::SCALAR;
+}
+
+} // namespace
+
+FilterKernel BestFilterKernel() {
+    static const FilterKernel kernel = DetectFilterKernel();
+    return kernel;
+}
+
+const char *FilterKernelName(FilterKernel kernel) {
+    switch (kernel) {
+    case FilterKernel::SCALAR: return "scalar";
+    case FilterKernel::SSE2: return "sse2";
+    case FilterKernel::AVX2: return "avx2";
+    }
+    return "unknown";
+}
+
+void FilterInt32(const int32_t *data, size_t n, CompareOp op, int32_t literal, uint64_t *bitmap,
+                 FilterKernel kernel) {
+    // Never run a kernel the CPU lacks, even if a caller asks for it.
+    kernel = std::min(kernel, BestFilterKernel());
+    bool negate;
+    switch (Decompose(op, &negate)) {
+    case BaseOp::EQ: return DispatchInt32<BaseOp::EQ>(data, n, literal, negate, bitmap, kernel);
+    case BaseOp::GT: return DispatchInt32<BaseOp::GT>(data, n, literal, negate, bitmap, kernel);
+    case BaseOp::LT: return DispatchInt32<BaseOp::LT>(data, n, literal, negate, bitmap, kernel);
+    }
+}
+
+void FilterString(const uint32_t *offsets, const char *chars, size_t n, CompareOp op, std::string_view literal,
+                  uint64_t *bitmap) {
+    bool negate;
+    switch (Decompose(op, &negate)) {
+    case BaseOp::EQ: return ScalarString<BaseOp::EQ>(offsets, chars, n, literal, negate, bitmap);
+    case BaseOp::GT: return ScalarString<BaseOp::GT>(offsets, chars, n, literal, negate, bitmap);
+    case BaseOp::LT: return ScalarString<BaseOp::LT>(offsets, chars, n, literal, negate, bitmap);
+    }
+}
+
+} // namespace simpledb
@@ -0,0 +1,145 @@
+#include "storage/column_store.h"
+#include <algorithm>
+#include <deque>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+
+namespace simpledb {
+
+namespace {
+
+// Distinct values of a VARCHAR column in the order they first appear, while it is encoded.
+struct DictionaryBuilder {
+    std::deque<std::string> values;                        // by code; never moved, so
+    std::unordered_map<std::string_view, int32_t> codes;   // these views stay valid
+};
+
+} // namespace
+
+ColumnStore::ColumnStore(const Schema *schema) : schema_(schema), columns_(schema->GetColumnCount()) {}
+
+void ColumnStore::Refresh(TableHeap *heap) {
+    uint64_t version = heap->GetVersion();
+    if (version == version_) return;
+
+    rids_.clear();
+    std::vector<DictionaryBuilder> builders(columns_.size());
+    for (uint32_t i = 0; i < columns_.size(); ++i) {
+        Column &column = columns_[i];
+        column.ints.clear();
+        column.offsets.assign(1, 0);
+        column.chars.clear();
+        column.dictionary.clear();
+        column.encoded = schema_->GetColumn(i).GetType() == TypeId::VARCHAR;
+    }
+    for (auto it = heap->Begin(); it != heap->End(); ++it) {
+        rids_.push_back(it.GetRID());
+        for (uint32_t i = 0; i < columns_.size(); ++i) {
+            const Value &value = it->GetValue(schema_, i);
+            Column &column = columns_[i];
+            if (schema_->GetColumn(i).GetType() == TypeId::INTEGER) {
+                column.ints.push_back(value.GetAsInt());
+                continue;
+            }
+            std::string_view s = value.GetAsString();
+            if (column.encoded) {
+                DictionaryBuilder &builder = builders[i];
+                auto found = builder.codes.find(s);
+                int32_t code;
+                if (found != builder.codes.end()) {
+                    code = found->second;
+                } else {
+                    code = static_cast<int32_t>(builder.values.size());
+                    builder.values.emplace_back(s);
+                    builder.codes.emplace(builder.values.back(), code);
+                }
+                if (builder.values.size() <= COLUMN_DICTIONARY_MAX_ENTRIES) {
+                    column.ints.push_back(code);
+                    continue;
+                }
+                // Too many distinct values: spell out the rows so far and store the rest plainly.
+                for (int32_t earlier_code : column.ints) {
+                    const std::string &earlier = builder.values[earlier_code];
+                    column.chars.insert(column.chars.end(), earlier.begin(), earlier.end());
+                    column.offsets.push_back(static_cast<uint32_t>(column.chars.size()));
+                }
+                std::vector<int32_t>().swap(column.ints);
+                builder = DictionaryBuilder();
+                column.encoded = false;
+            }
+            column.chars.insert(column.chars.end(), s.begin(), s.end());
+            column.offsets.push_back(static_cast<uint32_t>(column.chars.size()));
+        }
+    }
+
+    // Renumber each dictionary in byte order, so that codes compare like the strings.
+    for (uint32_t i = 0; i < columns_.size(); ++i) {
+        Column &column = columns_[i];
+        if (!column.encoded) continue;
+        const std::deque<std::string> &values = builders[i].values;
+        std::vector<int32_t> order(values.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int32_t a, int32_t b) { return values[a] < values[b]; });
+        std::vector<int32_t> recode(values.size());
+        column.dictionary.reserve(values.size());
+        for (size_t code = 0; code < order.size(); ++code) {
+            recode[order[code]] = static_cast<int32_t>(code);
+            column.dictionary.emplace_back(values[order[code]]);
+        }
+        for (int32_t &code : column.ints) code = recode[code];
+        std::vector<uint32_t>().swap(column.offsets);
+    }
+    version_ = version;
+}
+
+void ColumnStore::Filter(uint32_t col, CompareOp op, const Value &literal, uint64_t *bitmap) const {
+    const Column &column = columns_[col];
+    if (schema_->GetColumn(col).GetType() == TypeId::INTEGER) {
+        FilterInt32(column.ints.data(), rids_.size(), op, literal.GetAsInt(), bitmap);
+    } else if (column.encoded) {
+        FilterDictionary(column, op, literal.GetAsString(), bitmap);
+    } else {
+        FilterString(column.offsets.data(), column.chars.data(), rids_.size(), op, literal.GetAsString(), bitmap);
+    }
+}
+
+void ColumnStore::FilterDictionary(const Column &column, CompareOp op, std::string_view literal,
+                                   uint64_t *bitmap) const {
+    // Codes below lower hold values less than literal; upper is lower + 1 if literal itself
+    // has a code, and lower otherwise.
+    auto less = [](const Value &value, std::string_view s) { return value.GetAsString() < s; };
+    const std::vector<Value> &dictionary = column.dictionary;
+    int32_t lower = static_cast<int32_t>(
+        std::lower_bound(dictionary.begin(), dictionary.end(), literal, less) - dictionary.begin());
+    bool present = lower < static_cast<int32_t>(dictionary.size()) && dictionary[lower].GetAsString() == literal;
+    int32_t upper = lower + (present ? 1 : 0);
+    const int32_t *codes = column.ints.data();
+    size_t n = rids_.size();
+    switch (op) {
+    case CompareOp::EQ: return FilterInt32(codes, n, CompareOp::EQ, present ? lower : -1, bitmap);
+    case CompareOp::NE: return FilterInt32(codes, n, CompareOp::NE, present ? lower : -1, bitmap);
+    case CompareOp::LT: return FilterInt32(codes, n, CompareOp::LT, lower, bitmap);
+    case CompareOp::LE: return FilterInt32(codes, n, CompareOp::LT, upper, bitmap);
+    case CompareOp::GT: return FilterInt32(codes, n, CompareOp::GE, upper, bitmap);
+    case CompareOp::GE: return FilterInt32(codes, n, CompareOp::GE, lower, bitmap);
+    }
+}
+
+Tuple ColumnStore::GetTuple(size_t row) const {
+    std::vector<Value> values;
+    values.reserve(columns_.size());
+    for (uint32_t i = 0; i < columns_.size(); ++i) {
+        const Column &column = columns_[i];
+        if (schema_->GetColumn(i).GetType() == TypeId::INTEGER) {
+            values.emplace_back(column.ints[row]);
+        } else if (column.encoded) {
+            values.push_back(column.dictionary[column.ints[row]]);
+        } else {
+            values.emplace_back(GetString(i, row));
+        }
+    }
+    return Tuple(std::move(values));
+}
+
+} // namespace simpledb
@@ -0,0 +1,256 @@
+#include "storage/csv_loader.h"
+#include "storage/table_page.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace simpledb {
+
+namespace {
+
+// End of the last complete row in text, or 0 if it holds none. text starts at a row
+// boundary, so quote state is known from the first byte.
+size_t RowBoundary(const std::string &text) {
+    if (text.find('"') == std::string::npos) {
+        size_t last = text.rfind('\n');
+        return last == std::string::npos ? 0 : last + 1;
+    }
+    size_t cut = 0;
+    bool quoted = false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '"') {
+            quoted = !quoted;
+        } else if (text[i] == '\n' && !quoted) {
+            cut = i + 1;
+        }
+    }
+    return cut;
+}
+
+} // namespace
+
+CsvLoader::CsvLoader(const Schema *schema, size_t num_threads)
+    : schema_(schema), num_threads_(std::max<size_t>(num_threads, 1)) {}
+
+bool CsvLoader::IsHeader(const std::vector<std::string> &fields, size_t count) const {
+    if (count != schema_->GetColumnCount()) return false;
+    for (size_t i = 0; i < count; ++i) {
+        if (fields[i] != schema_->GetColumn(static_cast<uint32_t>(i)).GetName()) return false;
+    }
+    return true;
+}
+
+void CsvLoader::ParseChunk(const Chunk &chunk, Result *result) const {
+    const std::string &text = chunk.text;
+    const uint32_t column_count = schema_->GetColumnCount();
+    std::vector<TypeId> types;
+    for (uint32_t i = 0; i < column_count; ++i) types.push_back(schema_->GetColumn(i).GetType());
+
+    Batch &batch = result->batch;
+    auto fail = [&](size_t line, const std::string &message) {
+        result->ok = false;
+        result->error = "Line " + std::to_string(line) + ": " + message;
+    };
+
+    std::vector<std::string> fields;
+    std::string row;
+    size_t pos = 0;
+    size_t line = chunk.first_line;
+    bool first_row = chunk.seq == 0;
+    while (pos < text.size()) {
+        size_t row_line = line;
+        if (text[pos] == '\n' || (text[pos] == '\r' && pos + 1 < text.size() && text[pos + 1] == '\n')) {
+            pos += text[pos] == '\n' ? 1 : 2;
+            line++;
+            continue;
+        }
+
+        // Split the row into fields.
+        size_t count = 0;
+        while (true) {
+            if (count == fields.size()) fields.emplace_back();
+            std::string &field = fields[count++];
+            field.clear();
+            if (pos < text.size() && text[pos] == '"') {
+                ++pos;
+                while (true) {
+                    if (pos >= text.size()) return fail(row_line, "unterminated quoted field.");
+                    char c = text[pos++];
+                    if (c == '"') {
+                        if (pos < text.size() && text[pos] == '"') {
+                            field += '"';
+                            ++pos;
+                            continue;
+                        }
+                        break;
+                    }
+                    if (c == '\n') line++;
+                    field += c;
+                }
+                if (pos < text.size() && text[pos] == '\r') ++pos;
+                if (pos < text.size() && text[pos] != ',' && text[pos] != '\n') {
+                    return fail(row_line, "unexpected text after a quoted field.");
+                }
+            } else {
+                size_t end = text.find_first_of(",\n", pos);
+                if (end == std::string::npos) end = text.size();
+                field.assign(text, pos, end - pos);
+                pos = end;
+                if ((pos == text.size() || text[pos] == '\n') && !field.empty() && field.back() == '\r') {
+                    field.pop_back();
+                }
+            }
+            if (pos < text.size() && text[pos] == ',') {
+                ++pos;
+                continue;
+            }
+            if (pos < text.size()) {
+                ++pos;
+                line++;
+            }
+            break;
+        }
+
+        if (first_row) {
+            first_row = false;
+            if (IsHeader(fields, count)) continue;
+        }
+        if (count != column_count) {
+            return fail(row_line, "expected " + std::to_string(column_count) + " values, found " +
+                                  std::to_string(count) + ".");
+        }
+
+        // Serialize in the on-page tuple layout (see Tuple::SerializeTo).
+        row.clear();
+        for (uint32_t i = 0; i < column_count; ++i) {
+            const std::string &field = fields[i];
+            if (types[i] == TypeId::INTEGER) {
+                size_t begin = field.find_first_not_of(' ');
+                size_t end = field.find_last_not_of(' ') + 1;
+                int32_t v = 0;
+                auto [ptr, ec] = begin == std::string::npos
+                                     ? std::from_chars_result{field.data(), std::errc::invalid_argument}
+                                     : std::from_chars(field.data() + begin, field.data() + end, v);
+                if (ec != std::errc() || ptr != field.data() + end) {
+                    return fail(row_line, "'" + field + "' is not an integer for column '" +
+                                          schema_->GetColumn(i).GetName() + "'.");
+                }
+                row.append(reinterpret_cast<const char *>(&v), sizeof(int32_t));
+            } else {
+                uint32_t len = static_cast<uint32_t>(field.size());
+                row.append(reinterpret_cast<const char *>(&len), sizeof(uint32_t));
+                row.append(field);
+            }
+        }
+        uint32_t size = static_cast<uint32_t>(row.size());
+        if (size > TablePage::MAX_TUPLE_SIZE) {
+            return fail(row_line, "row of " + std::to_string(size) + " bytes does not fit in a page.");
+        }
+
+        uint32_t slot;
+        if (batch.page_count == 0 || !TablePage(batch.GetPage(batch.page_count - 1)).InsertTuple(row.data(), size, &slot)) {
+            batch.pages.resize((batch.page_count + 1) * PAGE_SIZE);
+            TablePage page(batch.GetPage(batch.page_count++));
+            page.Init();
+            page.InsertTuple(row.data(), size, &slot);
+        }
+        batch.row_count++;
+    }
+}
+
+bool CsvLoader::Load(const std::string &path, const BatchSink &sink) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        LOG_ERROR("Cannot open '" << path << "'.");
+        return false;
+    }
+
+    std::mutex latch;
+    std::condition_variable cv;
+    std::deque<Chunk> queue;
+    std::map<size_t, Result> done;
+    bool stop = false;
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < num_threads_; ++i) {
+        workers.emplace_back([&] {
+            std::unique_lock<std::mutex> lock(latch);
+            while (true) {
+                cv.wait(lock, [&] { return stop || !queue.empty(); });
+                if (queue.empty()) return;
+                Chunk chunk = std::move(queue.front());
+                queue.pop_front();
+                lock.unlock();
+                Result result;
+                ParseChunk(chunk, &result);
+                lock.lock();
+                done.emplace(chunk.seq, std::move(result));
+                cv.notify_all();
+            }
+        });
+    }
+
+    // The calling thread reads ahead a few chunks per worker and consumes results in order.
+    std::vector<char> buf(LOAD_CHUNK_BYTES);
+    std::string carry;
+    size_t submitted = 0;
+    size_t consumed = 0;
+    size_t line = 1;
+    bool eof = false;
+    bool ok = true;
+    while (ok) {
+        while (!eof && submitted - consumed < 2 * num_threads_) {
+            in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+            if (in.bad()) {
+                LOG_ERROR("Failed to read '" << path << "'.");
+                ok = false;
+                break;
+            }
+            eof = in.eof();
+            carry.append(buf.data(), static_cast<size_t>(in.gcount()));
+            size_t cut = eof ? carry.size() : RowBoundary(carry);
+            if (cut == 0) continue;
+
+            Chunk chunk{submitted++, line, carry.substr(0, cut)};
+            line += std::count(chunk.text.begin(), chunk.text.end(), '\n');
+            carry.erase(0, cut);
+            std::lock_guard<std::mutex> guard(latch);
+            queue.push_back(std::move(chunk));
+            cv.notify_all();
+        }
+        if (!ok || consumed == submitted) break;
+
+        Result result;
+        {
+            std::unique_lock<std::mutex> lock(latch);
+            cv.wait(lock, [&] { return done.count(consumed) > 0; });
+            result = std::move(done[consumed]);
+            done.erase(consumed);
+        }
+        consumed++;
+        if (!result.ok) {
+            LOG_ERROR(result.error);
+            ok = false;
+        } else if (result.batch.page_count > 0 && !sink(result.batch)) {
+            ok = false;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(latch);
+        stop = true;
+        queue.clear();
+    }
+    cv.notify_all();
+    for (auto &worker : workers) worker.join();
+    return ok;
+}
+
+} // namespace simpledb
@@ -1,72 +1,302 @@
 #include "storage/disk_manager.h"
+#include "common/crc32.h"
 #include "common/logger.h"
-#include <filesystem>
+#include "common/serialize.h"
+#include <chrono>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace simpledb {
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-        db_io_.clear();
-        // create file
-        db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-        db_io_.close();
-        // re-open
-        db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-        if (!db_io_.is_open()) {
-            LOG_ERROR("Failed to open db file: " << db_file);
-        }
+namespace {
+
+constexpr char SWAP_MANIFEST_MAGIC[] = "SDBSWAP1";
+
+int OpenFile(const std::string &path, bool truncate) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : 0), _S_IREAD | _S_IWRITE);
+#else
+    return open(path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+#endif
+}
+
+void CloseFile(int fd) {
+    if (fd < 0) return;
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+bool SyncFile(int fd) {
+#ifdef _WIN32
+    return _commit(fd) == 0;
+#else
+    return fsync(fd) == 0;
+#endif
+}
+
+bool TruncateFile(int fd) {
+#ifdef _WIN32
+    return _chsize_s(fd, 0) == 0;
+#else
+    return ftruncate(fd, 0) == 0;
+#endif
+}
+
+} // namespace
+
+DiskManager::DiskManager(const std::string &db_file, bool use_swap)
+    : file_name_(db_file), use_swap_(use_swap), swap_file_(db_file + ".swap"),
+      manifest_file_(db_file + ".swap.manifest") {
+    fd_ = OpenFile(db_file, false);
+    if (fd_ < 0) {
+        LOG_ERROR("Failed to open db file: " << db_file);
     }
-    
-    // Determine the next page id
-    db_io_.seekp(0, std::ios::end);
-    next_page_id_ = db_io_.tellp() / PAGE_SIZE;
+
+    struct stat st;
+    size_t size = (fd_ >= 0 && fstat(fd_, &st) == 0) ? static_cast<size_t>(st.st_size) : 0;
+    file_size_ = size;
+    if (use_swap_) RecoverSwap();
+
+    // Determine the next page id; page 0 is never allocated.
+    next_page_id_ = std::max<page_id_t>(1, static_cast<page_id_t>(file_size_ / PAGE_SIZE));
 }
 
 DiskManager::~DiskManager() {
-    if (db_io_.is_open()) {
-        db_io_.close();
+    CloseFile(fd_);
+    CloseFile(swap_fd_);
+}
+
+bool DiskManager::WriteAt(int fd, const char *data, size_t offset) {
+#ifdef _WIN32
+    std::lock_guard<std::mutex> guard(io_latch_);
+    return _lseeki64(fd, offset, SEEK_SET) >= 0 && _write(fd, data, PAGE_SIZE) == PAGE_SIZE;
+#else
+    size_t written = 0;
+    while (written < PAGE_SIZE) {
+        ssize_t n = pwrite(fd, data + written, PAGE_SIZE - written, offset + written);
+        if (n <= 0) return false;
+        written += static_cast<size_t>(n);
     }
+    return true;
+#endif
 }
 
-void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
+bool DiskManager::ReadAt(int fd, char *data, size_t offset, size_t *bytes_read) {
+    *bytes_read = 0;
+#ifdef _WIN32
+    std::lock_guard<std::mutex> guard(io_latch_);
+    if (_lseeki64(fd, offset, SEEK_SET) < 0) return false;
+    int n = _read(fd, data, PAGE_SIZE);
+    if (n < 0) return false;
+    *bytes_read = static_cast<size_t>(n);
+#else
+    while (*bytes_read < PAGE_SIZE) {
+        ssize_t n = pread(fd, data + *bytes_read, PAGE_SIZE - *bytes_read, offset + *bytes_read);
+        if (n < 0) return false;
+        if (n == 0) break;
+        *bytes_read += static_cast<size_t>(n);
+    }
+#endif
+    return true;
+}
+
+bool DiskManager::WritePage(page_id_t page_id, const char *page_data) {
     size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-    db_io_.seekp(offset);
-    db_io_.write(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
-        LOG_ERROR("I/O error while writing to disk");
-        return;
+    if (use_swap_) {
+        if (!WriteAt(swap_fd_, page_data, offset)) {
+            LOG_ERROR("I/O error while writing page " << page_id << " to swap file");
+            return false;
+        }
+        {
+            std::shared_lock<std::shared_mutex> guard(swap_latch_);
+            if (swapped_.count(page_id) != 0) return true;
+        }
+        std::unique_lock<std::shared_mutex> guard(swap_latch_);
+        swapped_.insert(page_id);
+        return true;
+    }
+
+    if (!WriteAt(fd_, page_data, offset)) {
+        LOG_ERROR("I/O error while writing page " << page_id);
+        return false;
     }
-    db_io_.flush();
+
+    // Grow the tracked size monotonically; concurrent writers past the end race benignly.
+    size_t end = offset + PAGE_SIZE;
+    size_t size = file_size_.load();
+    while (size < end && !file_size_.compare_exchange_weak(size, end)) {
+    }
+    return true;
 }
 
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+bool DiskManager::ReadPage(page_id_t page_id, char *page_data) {
     size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-    // Check if reading past file
-    db_io_.seekg(0, std::ios::end);
-    auto file_size = db_io_.tellg();
-    if (offset >= static_cast<size_t>(file_size)) {
-        LOG_WARN("Read past end of file for page " << page_id);
+    int fd = fd_;
+    if (use_swap_) {
+        std::shared_lock<std::shared_mutex> guard(swap_latch_);
+        if (swapped_.count(page_id) != 0) fd = swap_fd_;
+    }
+    if (fd == fd_ && offset >= file_size_.load()) {
+        memset(page_data, 0, PAGE_SIZE);
+        return true;
+    }
+
+    size_t read_count;
+    if (!ReadAt(fd, page_data, offset, &read_count)) {
+        LOG_ERROR("I/O error while reading page " << page_id);
+        return false;
     }
 
-    db_io_.seekg(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    
     // If exact page size is not read (e.g. at end of file)
-    size_t read_count = db_io_.gcount();
     if (read_count < PAGE_SIZE) {
-        db_io_.clear();
         memset(page_data + read_count, 0, PAGE_SIZE - read_count);
     }
+    return true;
 }
 
 page_id_t DiskManager::AllocatePage() {
     return next_page_id_++;
 }
 
+void DiskManager::ReservePage(page_id_t page_id) {
+    page_id_t next = next_page_id_.load();
+    while (next <= page_id && !next_page_id_.compare_exchange_weak(next, page_id + 1)) {
+    }
+}
+
+bool DiskManager::Sync() {
+    return SyncFile(fd_);
+}
+
+int DiskManager::PublishSwap() {
+    if (!use_swap_) return Sync() ? 0 : -1;
+    std::unique_lock<std::shared_mutex> guard(swap_latch_);
+    if (swapped_.empty()) return 0;
+
+    // 1. Make the swapped pages durable, then record which they are. Once the manifest
+    //    is in place the publish counts as done: a crash from here on is finished by
+    //    RecoverSwap on the next open.
+    std::string manifest(SWAP_MANIFEST_MAGIC, sizeof(SWAP_MANIFEST_MAGIC) - 1);
+    std::string ids;
+    for (page_id_t page_id : swapped_) PutValue(&ids, page_id);
+    PutValue<uint32_t>(&manifest, static_cast<uint32_t>(swapped_.size()));
+    manifest += ids;
+    PutValue<uint32_t>(&manifest, Crc32(ids.data(), ids.size()));
+
+    std::string tmp_file = manifest_file_ + ".tmp";
+    int manifest_fd = OpenFile(tmp_file, true);
+    bool ok = SyncFile(swap_fd_) && manifest_fd >= 0;
+#ifdef _WIN32
+    ok = ok && _write(manifest_fd, manifest.data(), static_cast<unsigned>(manifest.size())) ==
+                   static_cast<int>(manifest.size());
+#else
+    ok = ok && write(manifest_fd, manifest.data(), manifest.size()) == static_cast<ssize_t>(manifest.size());
+#endif
+    ok = ok && SyncFile(manifest_fd);
+    CloseFile(manifest_fd);
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmp_file, manifest_file_, ec);
+    if (!ok || ec) {
+        LOG_ERROR("Failed to write swap manifest " << manifest_file_);
+        std::filesystem::remove(tmp_file, ec);
+        return -1;
+    }
+
+    // 2. Copy the pages into the database file.
+    std::vector<char> page(PAGE_SIZE);
+    for (page_id_t page_id : swapped_) {
+        size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
+        size_t read_count;
+        if (!ReadAt(swap_fd_, page.data(), offset, &read_count) || read_count != PAGE_SIZE ||
+            !WriteAt(fd_, page.data(), offset)) {
+            LOG_ERROR("I/O error while publishing page " << page_id);
+            return -1;
+        }
+        file_size_ = std::max(file_size_.load(), offset + PAGE_SIZE);
+    }
+    if (!SyncFile(fd_)) return -1;
+
+    // 3. Retire the manifest and start a fresh swap file.
+    int published = static_cast<int>(swapped_.size());
+    std::filesystem::remove(manifest_file_, ec);
+    swapped_.clear();
+    TruncateFile(swap_fd_);
+    return published;
+}
+
+void DiskManager::RecoverSwap() {
+    swap_fd_ = OpenFile(swap_file_, false);
+    if (swap_fd_ < 0) {
+        LOG_ERROR("Failed to open swap file: " << swap_file_);
+        return;
+    }
+
+    std::ifstream in(manifest_file_, std::ios::binary);
+    std::string manifest((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    size_t magic_size = sizeof(SWAP_MANIFEST_MAGIC) - 1;
+    uint32_t count = 0;
+    ByteReader reader{manifest.data(), manifest.data() + manifest.size()};
+    bool valid = manifest.size() >= magic_size && memcmp(manifest.data(), SWAP_MANIFEST_MAGIC, magic_size) == 0;
+    reader.pos += valid ? magic_size : 0;
+    valid = valid && reader.Get(&count) && manifest.size() == magic_size + 8 + count * sizeof(page_id_t);
+    if (valid) {
+        uint32_t crc;
+        memcpy(&crc, manifest.data() + manifest.size() - 4, sizeof(uint32_t));
+        valid = Crc32(reader.pos, count * sizeof(page_id_t)) == crc;
+    }
+
+    if (valid) {
+        std::vector<char> page(PAGE_SIZE);
+        for (uint32_t i = 0; i < count; ++i) {
+            page_id_t page_id = INVALID_PAGE_ID;
+            if (!reader.Get(&page_id)) {
+                LOG_ERROR("Checkpoint manifest is truncated");
+                return;
+            }
+            size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
+            size_t read_count;
+            if (ReadAt(swap_fd_, page.data(), offset, &read_count) && read_count == PAGE_SIZE &&
+                WriteAt(fd_, page.data(), offset)) {
+                file_size_ = std::max(file_size_.load(), offset + PAGE_SIZE);
+            } else {
+                LOG_ERROR("I/O error while finishing an interrupted checkpoint");
+                return;
+            }
+        }
+        SyncFile(fd_);
+        LOG_INFO("Finished an interrupted checkpoint of " << count << " pages.");
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(manifest_file_, ec);
+    std::filesystem::remove(manifest_file_ + ".tmp", ec);
+    TruncateFile(swap_fd_);
+}
+
 int DiskManager::GetNumPages() const {
     return next_page_id_;
 }
 
+std::string DiskManager::TempFileName(const std::string &prefix) {
+    static std::atomic<uint64_t> counter{0};
+    std::string name = prefix + "-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+                       "-" + std::to_string(counter++) + ".tmp";
+    std::error_code ec;
+    std::filesystem::path dir = std::filesystem::temp_directory_path(ec);
+    return ec ? name : (dir / name).string();
+}
+
 } // namespace simpledb
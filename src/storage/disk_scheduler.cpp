@@ -0,0 +1,54 @@
+#include "storage/disk_scheduler.h"
+
+namespace simpledb {
+
+DiskScheduler::DiskScheduler(DiskManager *disk_manager, size_t num_workers) : disk_manager_(disk_manager) {
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers_.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+DiskScheduler::~DiskScheduler() {
+    {
+        std::lock_guard<std::mutex> guard(latch_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) worker.join();
+}
+
+std::future<bool> DiskScheduler::Submit(bool is_write, page_id_t page_id, char *data) {
+    DiskRequest request{is_write, page_id, data, std::promise<bool>()};
+    std::future<bool> future = request.done.get_future();
+    if (workers_.empty()) {
+        request.done.set_value(Execute(request));
+        return future;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(latch_);
+        queue_.push_back(std::move(request));
+    }
+    cv_.notify_one();
+    return future;
+}
+
+bool DiskScheduler::Execute(const DiskRequest &request) {
+    if (request.is_write) return disk_manager_->WritePage(request.page_id, request.data);
+    return disk_manager_->ReadPage(request.page_id, request.data);
+}
+
+void DiskScheduler::WorkerLoop() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(latch_);
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        // Drain outstanding requests before exiting so no caller waits forever.
+        if (queue_.empty()) return;
+        DiskRequest request = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        request.done.set_value(Execute(request));
+    }
+}
+
+} // namespace simpledb
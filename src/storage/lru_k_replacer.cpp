@@ -0,0 +1,111 @@
+#include "storage/lru_k_replacer.h"
+
+namespace simpledb {
+
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k)
+    : k_(k == 0 ? 1 : k), frames_(num_frames), history_(num_frames * k_) {
+    heap_.reserve(num_frames);
+}
+
+bool LRUKReplacer::EvictsBefore(frame_id_t a, frame_id_t b) const {
+    const FrameState &fa = frames_[a];
+    const FrameState &fb = frames_[b];
+    // Scanned only, then fewer than K accesses, then the rest.
+    auto tier = [&](const FrameState &f) { return f.access_count == 0 ? 0 : (f.access_count < k_ ? 1 : 2); };
+    int ta = tier(fa), tb = tier(fb);
+    if (ta != tb) return ta < tb;
+    if (ta < 2) return fa.first_access < fb.first_access;
+    // The ring slot written next holds the K-th most recent access.
+    return history_[a * k_ + fa.access_count % k_] < history_[b * k_ + fb.access_count % k_];
+}
+
+void LRUKReplacer::Place(size_t index, frame_id_t frame_id) {
+    heap_[index] = frame_id;
+    frames_[frame_id].heap_index = static_cast<int32_t>(index);
+}
+
+void LRUKReplacer::SiftUp(size_t index) {
+    frame_id_t frame_id = heap_[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!EvictsBefore(frame_id, heap_[parent])) break;
+        Place(index, heap_[parent]);
+        index = parent;
+    }
+    Place(index, frame_id);
+}
+
+void LRUKReplacer::SiftDown(size_t index) {
+    frame_id_t frame_id = heap_[index];
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= heap_.size()) break;
+        if (child + 1 < heap_.size() && EvictsBefore(heap_[child + 1], heap_[child])) child++;
+        if (!EvictsBefore(heap_[child], frame_id)) break;
+        Place(index, heap_[child]);
+        index = child;
+    }
+    Place(index, frame_id);
+}
+
+void LRUKReplacer::HeapPush(frame_id_t frame_id) {
+    heap_.push_back(frame_id);
+    SiftUp(heap_.size() - 1);
+}
+
+void LRUKReplacer::HeapErase(frame_id_t frame_id) {
+    int32_t index = frames_[frame_id].heap_index;
+    if (index < 0) return;
+    frames_[frame_id].heap_index = -1;
+    frame_id_t last = heap_.back();
+    heap_.pop_back();
+    if (last == frame_id) return;
+    Place(index, last);
+    SiftUp(index);
+    SiftDown(frames_[last].heap_index);
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+    // Pinned frames are dropped from the heap lazily, when they reach the top.
+    while (!heap_.empty()) {
+        frame_id_t top = heap_.front();
+        if (frames_[top].evictable) {
+            Remove(top);
+            *frame_id = top;
+            return true;
+        }
+        HeapErase(top);
+    }
+    return false;
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, AccessType type) {
+    FrameState &f = frames_[frame_id];
+    now_++;
+    if (f.first_access == 0) f.first_access = now_;
+    if (type == AccessType::SCAN) return;
+    history_[frame_id * k_ + f.access_count % k_] = now_;
+    f.access_count++;
+    // An access only moves a frame later in eviction order.
+    if (f.heap_index >= 0) SiftDown(f.heap_index);
+}
+
+void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool evictable) {
+    FrameState &f = frames_[frame_id];
+    if (f.evictable == evictable) return;
+    f.evictable = evictable;
+    if (evictable) {
+        size_++;
+        if (f.heap_index < 0) HeapPush(frame_id);
+    } else {
+        size_--;
+    }
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+    if (frames_[frame_id].evictable) size_--;
+    HeapErase(frame_id);
+    frames_[frame_id] = FrameState();
+}
+
+} // namespace simpledb
@@ -0,0 +1,528 @@
+#include "storage/table_heap.h"
+#include "storage/table_page.h"
+#include "common/logger.h"
+#include <cstring>
+
+namespace simpledb {
+
+TableHeap::TableHeap(BufferPoolManager *bpm, const Schema *schema, table_oid_t table_oid, LogManager *log_manager)
+    : bpm_(bpm), schema_(schema), table_oid_(table_oid), log_manager_(log_manager) {
+    Page *page = bpm_->NewPage(&first_page_id_);
+    if (page == nullptr) {
+        LOG_ERROR("Buffer pool exhausted while creating table heap");
+        first_page_id_ = INVALID_PAGE_ID;
+        last_page_id_ = INVALID_PAGE_ID;
+        return;
+    }
+    page->WLatch();
+    TablePage(page).Init();
+    LogChange(page, LogRecord::NewPage(table_oid_, INVALID_PAGE_ID, first_page_id_));
+    page->WUnlatch();
+    bpm_->UnpinPage(first_page_id_, true);
+    last_page_id_ = first_page_id_;
+}
+
+TableHeap::TableHeap(BufferPoolManager *bpm, const Schema *schema, table_oid_t table_oid, page_id_t first_page_id)
+    : bpm_(bpm), schema_(schema), table_oid_(table_oid), first_page_id_(first_page_id),
+      last_page_id_(first_page_id) {
+    while (last_page_id_ != INVALID_PAGE_ID) {
+        Page *page = bpm_->FetchPage(last_page_id_);
+        if (page == nullptr) break;
+        page->RLatch();
+        page_id_t next = TablePage(page).GetNextPageId();
+        page->RUnlatch();
+        bpm_->UnpinPage(last_page_id_, false);
+        if (next == INVALID_PAGE_ID) break;
+        last_page_id_ = next;
+    }
+}
+
+bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid) {
+    uint32_t size = tuple.GetSerializedSize(*schema_);
+    if (size > TablePage::MAX_TUPLE_SIZE) {
+        LOG_ERROR("Tuple of " << size << " bytes does not fit in a page");
+        return false;
+    }
+    std::vector<char> buf(size);
+    tuple.SerializeTo(*schema_, buf.data());
+
+    // Appends are serialized so concurrent inserters agree on the last page.
+    std::lock_guard<std::mutex> guard(append_latch_);
+    Page *page = bpm_->FetchPage(last_page_id_);
+    if (page == nullptr) return false;
+
+    uint32_t slot;
+    page->WLatch();
+    if (!TablePage(page).InsertTuple(buf.data(), size, &slot)) {
+        page = ChainNewPage(page);
+        if (page == nullptr) return false;
+        TablePage(page).InsertTuple(buf.data(), size, &slot);
+    }
+    rid->Set(last_page_id_, slot);
+    LogChange(page, LogRecord::Insert(table_oid_, *rid, buf.data(), size));
+    page->WUnlatch();
+    bpm_->UnpinPage(last_page_id_, true);
+    version_++;
+    return true;
+}
+
+bool TableHeap::InsertTuples(const std::vector<Tuple> &tuples, RID *rids, Arena *scratch) {
+    Arena local;
+    if (scratch == nullptr) scratch = &local;
+
+    // Serialize every tuple into one buffer up front.
+    uint32_t *offsets = scratch->AllocateArray<uint32_t>(tuples.size() + 1);
+    offsets[0] = 0;
+    for (size_t i = 0; i < tuples.size(); ++i) {
+        uint32_t size = tuples[i].GetSerializedSize(*schema_);
+        if (size > TablePage::MAX_TUPLE_SIZE) {
+            LOG_ERROR("Tuple of " << size << " bytes does not fit in a page");
+            return false;
+        }
+        offsets[i + 1] = offsets[i] + size;
+    }
+    char *buf = scratch->AllocateArray<char>(offsets[tuples.size()]);
+    for (size_t i = 0; i < tuples.size(); ++i) tuples[i].SerializeTo(*schema_, buf + offsets[i]);
+
+    std::lock_guard<std::mutex> guard(append_latch_);
+    Page *page = bpm_->FetchPage(last_page_id_);
+    if (page == nullptr) return false;
+    page->WLatch();
+    size_t next = 0;
+    while (true) {
+        // Fill the last page, then log everything that landed on it as one record.
+        batch_log_.clear();
+        TablePage table_page(page);
+        uint32_t slot;
+        for (; next < tuples.size(); ++next) {
+            uint32_t size = offsets[next + 1] - offsets[next];
+            if (!table_page.InsertTuple(buf + offsets[next], size, &slot)) break;
+            rids[next].Set(last_page_id_, slot);
+            LogRecord::AppendBatchTuple(&batch_log_, slot, buf + offsets[next], size);
+        }
+        if (!batch_log_.empty()) {
+            LogRecord record = LogRecord::InsertBatch(table_oid_, last_page_id_, std::move(batch_log_));
+            LogChange(page, record);
+            batch_log_ = record.ReleaseTupleData();   // keep the buffer for the next batch
+            version_++;
+        }
+        if (next == tuples.size()) break;
+        page = ChainNewPage(page);
+        if (page == nullptr) return false;
+    }
+    page->WUnlatch();
+    bpm_->UnpinPage(last_page_id_, true);
+    return true;
+}
+
+Page *TableHeap::ChainNewPage(Page *last) {
+    page_id_t new_page_id;
+    Page *new_page = bpm_->NewPage(&new_page_id);
+    if (new_page == nullptr) {
+        last->WUnlatch();
+        bpm_->UnpinPage(last_page_id_, false);
+        LOG_ERROR("Buffer pool exhausted while extending table heap");
+        return nullptr;
+    }
+    new_page->WLatch();
+    TablePage(new_page).Init();
+    lsn_t link_lsn = LogChange(new_page, LogRecord::NewPage(table_oid_, last_page_id_, new_page_id));
+
+    TablePage(last).SetNextPageId(new_page_id);
+    if (link_lsn != INVALID_LSN) TablePage(last).SetLSN(link_lsn);
+    last->WUnlatch();
+    bpm_->UnpinPage(last_page_id_, true);
+
+    last_page_id_ = new_page_id;
+    return new_page;
+}
+
+bool TableHeap::DeleteTuple(const RID &rid) {
+    Page *page = bpm_->FetchPage(rid.GetPageId());
+    if (page == nullptr) return false;
+    page->WLatch();
+    bool ok = TablePage(page).DeleteTuple(rid.GetSlotNum());
+    if (ok) LogChange(page, LogRecord::Delete(table_oid_, rid));
+    page->WUnlatch();
+    if (ok) {
+        version_++;
+        MarkForVacuum(rid.GetPageId());
+    }
+    bpm_->UnpinPage(rid.GetPageId(), ok);
+    return ok;
+}
+
+size_t TableHeap::DeleteTuples(const std::vector<RID> &rids, std::vector<bool> *deleted) {
+    if (deleted != nullptr) deleted->assign(rids.size(), false);
+    size_t count = 0;
+    size_t i = 0;
+    while (i < rids.size()) {
+        page_id_t page_id = rids[i].GetPageId();
+        Page *page = bpm_->FetchPage(page_id);
+        if (page == nullptr) return count;
+        page->WLatch();
+        TablePage table_page(page);
+        size_t page_count = 0;
+        for (; i < rids.size() && rids[i].GetPageId() == page_id; ++i) {
+            if (!table_page.DeleteTuple(rids[i].GetSlotNum())) continue;
+            LogChange(page, LogRecord::Delete(table_oid_, rids[i]));
+            if (deleted != nullptr) (*deleted)[i] = true;
+            page_count++;
+        }
+        page->WUnlatch();
+        bpm_->UnpinPage(page_id, page_count > 0);
+        if (page_count > 0) {
+            version_++;
+            MarkForVacuum(page_id);
+        }
+        count += page_count;
+    }
+    return count;
+}
+
+bool TableHeap::UpdateTuple(const Tuple &tuple, RID *rid) {
+    uint32_t size = tuple.GetSerializedSize(*schema_);
+    if (size > TablePage::MAX_TUPLE_SIZE) {
+        LOG_ERROR("Tuple of " << size << " bytes does not fit in a page");
+        return false;
+    }
+    std::vector<char> buf(size);
+    tuple.SerializeTo(*schema_, buf.data());
+
+    Page *page = bpm_->FetchPage(rid->GetPageId());
+    if (page == nullptr) return false;
+    page->WLatch();
+    TablePage table_page(page);
+    uint32_t old_size = 0;
+    table_page.GetTuple(rid->GetSlotNum(), &old_size);
+    bool ok = table_page.UpdateTuple(rid->GetSlotNum(), buf.data(), size);
+    if (ok) LogChange(page, LogRecord::Update(table_oid_, *rid, buf.data(), size));
+    page->WUnlatch();
+    bpm_->UnpinPage(rid->GetPageId(), ok);
+    if (ok) {
+        version_++;
+        if (size != old_size) MarkForVacuum(rid->GetPageId());
+        return true;
+    }
+
+    // Not enough room on the page: relocate the tuple.
+    if (!DeleteTuple(*rid)) return false;
+    return InsertTuple(tuple, rid);
+}
+
+bool TableHeap::GetTuple(const RID &rid, Tuple *tuple) {
+    Page *page = bpm_->FetchPage(rid.GetPageId(), AccessType::LOOKUP);
+    if (page == nullptr) return false;
+    uint32_t size;
+    page->RLatch();
+    const char *data = TablePage(page).GetTuple(rid.GetSlotNum(), &size);
+    if (data != nullptr) tuple->DeserializeFrom(*schema_, data);
+    page->RUnlatch();
+    bpm_->UnpinPage(rid.GetPageId(), false);
+    return data != nullptr;
+}
+
+page_id_t TableHeap::GetNextPageId(page_id_t page_id) {
+    Page *page = bpm_->FetchPage(page_id, AccessType::SCAN);
+    if (page == nullptr) {
+        LOG_ERROR("Failed to fetch page " << page_id << " during table scan");
+        return INVALID_PAGE_ID;
+    }
+    page->RLatch();
+    page_id_t next_page_id = TablePage(page).GetNextPageId();
+    page->RUnlatch();
+    bpm_->UnpinPage(page_id, false);
+    return next_page_id;
+}
+
+page_id_t TableHeap::ScanPage(page_id_t page_id, std::vector<RID> *rids, std::vector<Tuple> *tuples) {
+    Page *page = bpm_->FetchPage(page_id, AccessType::SCAN);
+    if (page == nullptr) {
+        LOG_ERROR("Failed to fetch page " << page_id << " during table scan");
+        return INVALID_PAGE_ID;
+    }
+    page->RLatch();
+    TablePage table_page(page);
+    uint32_t slot_count = table_page.GetSlotCount();
+    for (uint32_t slot = 0; slot < slot_count; ++slot) {
+        uint32_t size;
+        const char *data = table_page.GetTuple(slot, &size);
+        if (data == nullptr) continue;
+        rids->emplace_back(page_id, slot);
+        tuples->emplace_back();
+        tuples->back().DeserializeFrom(*schema_, data);
+    }
+    page_id_t next_page_id = table_page.GetNextPageId();
+    page->RUnlatch();
+    bpm_->UnpinPage(page_id, false);
+    return next_page_id;
+}
+
+bool TableHeap::AppendPage(const char *image, page_id_t *page_id) {
+    std::lock_guard<std::mutex> guard(append_latch_);
+    Page *last = bpm_->FetchPage(last_page_id_);
+    if (last == nullptr) return false;
+    Page *page = bpm_->NewPage(page_id);
+    if (page == nullptr) {
+        bpm_->UnpinPage(last_page_id_, false);
+        LOG_ERROR("Buffer pool exhausted while extending table heap");
+        return false;
+    }
+    page->WLatch();
+    memcpy(page->GetData(), image, PAGE_SIZE);
+    TablePage(page).SetNextPageId(INVALID_PAGE_ID);
+    lsn_t lsn = LogChange(page, LogRecord::LoadPage(table_oid_, last_page_id_, *page_id, page->GetData()));
+    page->WUnlatch();
+    bpm_->UnpinPage(*page_id, true);
+
+    last->WLatch();
+    TablePage(last).SetNextPageId(*page_id);
+    if (lsn != INVALID_LSN) TablePage(last).SetLSN(lsn);
+    last->WUnlatch();
+    bpm_->UnpinPage(last_page_id_, true);
+
+    last_page_id_ = *page_id;
+    version_++;
+    return true;
+}
+
+void TableHeap::MarkForVacuum(page_id_t page_id) {
+    std::lock_guard<std::mutex> guard(vacuum_latch_);
+    vacuum_pages_.insert(page_id);
+}
+
+bool TableHeap::NeedsVacuum() {
+    std::lock_guard<std::mutex> guard(vacuum_latch_);
+    return !vacuum_pages_.empty();
+}
+
+bool TableHeap::CompactPage(page_id_t page_id, size_t *bytes_reclaimed, page_id_t *next_page_id) {
+    Page *page = bpm_->FetchPage(page_id);
+    if (page == nullptr) {
+        if (next_page_id != nullptr) *next_page_id = INVALID_PAGE_ID;
+        return false;
+    }
+    page->WLatch();
+    TablePage table_page(page);
+    if (next_page_id != nullptr) *next_page_id = table_page.GetNextPageId();
+    uint32_t reclaimable = table_page.GetReclaimableSpace();
+    if (reclaimable > 0) {
+        table_page.Compact();
+        LogChange(page, LogRecord::VacuumPage(table_oid_, page_id));
+    }
+    page->WUnlatch();
+    bpm_->UnpinPage(page_id, reclaimable > 0);
+    if (bytes_reclaimed != nullptr) *bytes_reclaimed += reclaimable;
+    return reclaimable > 0;
+}
+
+size_t TableHeap::VacuumStep(size_t max_pages, size_t *bytes_reclaimed) {
+    std::vector<page_id_t> pages;
+    {
+        std::lock_guard<std::mutex> guard(vacuum_latch_);
+        while (!vacuum_pages_.empty() && pages.size() < max_pages) {
+            pages.push_back(*vacuum_pages_.begin());
+            vacuum_pages_.erase(vacuum_pages_.begin());
+        }
+    }
+    size_t compacted = 0;
+    for (page_id_t page_id : pages) {
+        if (CompactPage(page_id, bytes_reclaimed)) compacted++;
+    }
+    return compacted;
+}
+
+size_t TableHeap::VacuumAll(size_t *bytes_reclaimed) {
+    {
+        std::lock_guard<std::mutex> guard(vacuum_latch_);
+        vacuum_pages_.clear();
+    }
+    size_t compacted = 0;
+    for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+        if (CompactPage(page_id, bytes_reclaimed, &page_id)) compacted++;
+    }
+    return compacted;
+}
+
+lsn_t TableHeap::LogChange(Page *page, const LogRecord &record) {
+    if (log_manager_ == nullptr) return INVALID_LSN;
+    lsn_t lsn = log_manager_->AppendRecord(record);
+    TablePage(page).SetLSN(lsn);
+    return lsn;
+}
+
+bool TableHeap::RedoNewPage(page_id_t prev_page_id, page_id_t page_id, lsn_t lsn, const char *image,
+                            bool *applied) {
+    Page *page = bpm_->FetchPage(page_id);
+    if (page == nullptr) return false;
+    page->WLatch();
+    TablePage table_page(page);
+    bool apply = table_page.GetLSN() < lsn;
+    if (apply) {
+        if (image != nullptr) {
+            memcpy(page->GetData(), image, PAGE_SIZE);
+            table_page.SetNextPageId(INVALID_PAGE_ID);
+        } else {
+            table_page.Init();
+        }
+        table_page.SetLSN(lsn);
+    }
+    page->WUnlatch();
+    bpm_->UnpinPage(page_id, apply);
+    if (apply && image != nullptr) version_++;
+    if (applied != nullptr) *applied = apply;
+
+    if (prev_page_id == INVALID_PAGE_ID) {
+        first_page_id_ = page_id;
+    } else {
+        Page *prev = bpm_->FetchPage(prev_page_id);
+        if (prev == nullptr) return false;
+        prev->WLatch();
+        TablePage prev_page(prev);
+        bool link = prev_page.GetLSN() < lsn;
+        if (link) {
+            prev_page.SetNextPageId(page_id);
+            prev_page.SetLSN(lsn);
+        }
+        prev->WUnlatch();
+        bpm_->UnpinPage(prev_page_id, link);
+    }
+    last_page_id_ = page_id;
+    return true;
+}
+
+bool TableHeap::RedoInsert(const RID &rid, const std::string &tuple_data, lsn_t lsn, bool *applied) {
+    Page *page = bpm_->FetchPage(rid.GetPageId());
+    if (page == nullptr) return false;
+    page->WLatch();
+    TablePage table_page(page);
+    bool apply = table_page.GetLSN() < lsn;
+    bool ok = !apply || table_page.InsertTupleAt(rid.GetSlotNum(), tuple_data.data(),
+                                                 static_cast<uint32_t>(tuple_data.size()));
+    if (apply && ok) table_page.SetLSN(lsn);
+    page->WUnlatch();
+    bpm_->UnpinPage(rid.GetPageId(), apply && ok);
+    if (apply && ok) version_++;
+    if (applied != nullptr) *applied = apply && ok;
+    return ok;
+}
+
+bool TableHeap::RedoVacuumPage(page_id_t page_id, lsn_t lsn) {
+    Page *page = bpm_->FetchPage(page_id);
+    if (page == nullptr) return false;
+    page->WLatch();
+    TablePage table_page(page);
+    bool apply = table_page.GetLSN() < lsn;
+    if (apply) {
+        table_page.Compact();
+        table_page.SetLSN(lsn);
+    }
+    page->WUnlatch();
+    bpm_->UnpinPage(page_id, apply);
+    return true;
+}
+
+bool TableHeap::RedoInsertBatch(page_id_t page_id, const std::vector<std::pair<uint32_t, std::string>> &tuples,
+                                lsn_t lsn, bool *applied) {
+    Page *page = bpm_->FetchPage(page_id);
+    if (page == nullptr) return false;
+    page->WLatch();
+    TablePage table_page(page);
+    bool apply = table_page.GetLSN() < lsn;
+    bool ok = true;
+    for (size_t i = 0; apply && ok && i < tuples.size(); ++i) {
+        ok = table_page.InsertTupleAt(tuples[i].first, tuples[i].second.data(),
+                                      static_cast<uint32_t>(tuples[i].second.size()));
+    }
+    if (apply && ok) table_page.SetLSN(lsn);
+    page->WUnlatch();
+    bpm_->UnpinPage(page_id, apply);
+    if (apply && ok) version_++;
+    if (applied != nullptr) *applied = apply && ok;
+    return ok;
+}
+
+bool TableHeap::RedoDelete(const RID &rid, lsn_t lsn, bool *applied, std::string *old_data) {
+    return RedoUpdate(rid, std::string(), lsn, applied, old_data);
+}
+
+bool TableHeap::RedoUpdate(const RID &rid, const std::string &tuple_data, lsn_t lsn, bool *applied,
+                           std::string *old_data) {
+    Page *page = bpm_->FetchPage(rid.GetPageId());
+    if (page == nullptr) return false;
+    page->WLatch();
+    TablePage table_page(page);
+    bool apply = table_page.GetLSN() < lsn;
+    bool ok = true;
+    if (apply) {
+        uint32_t size;
+        const char *old = table_page.GetTuple(rid.GetSlotNum(), &size);
+        if (old != nullptr && old_data != nullptr) old_data->assign(old, size);
+        // An empty image means the tuple was deleted.
+        if (tuple_data.empty()) {
+            ok = table_page.DeleteTuple(rid.GetSlotNum());
+        } else {
+            ok = table_page.UpdateTuple(rid.GetSlotNum(), tuple_data.data(), static_cast<uint32_t>(tuple_data.size()));
+        }
+        if (ok) table_page.SetLSN(lsn);
+    }
+    page->WUnlatch();
+    bpm_->UnpinPage(rid.GetPageId(), apply && ok);
+    if (apply && ok) {
+        version_++;
+        MarkForVacuum(rid.GetPageId());
+    }
+    if (applied != nullptr) *applied = apply && ok;
+    return ok;
+}
+
+TableIterator TableHeap::Begin() {
+    return TableIterator(this, first_page_id_);
+}
+
+TableIterator TableHeap::End() {
+    return TableIterator(this, INVALID_PAGE_ID);
+}
+
+TableIterator::TableIterator(TableHeap *heap, page_id_t page_id) : heap_(heap), page_id_(page_id) {
+    LoadPage();
+}
+
+TableIterator &TableIterator::operator++() {
+    if (++pos_ >= page_tuples_.size()) {
+        page_id_ = next_page_id_;
+        LoadPage();
+    }
+    return *this;
+}
+
+void TableIterator::LoadPage() {
+    pos_ = 0;
+    page_tuples_.clear();
+    while (page_id_ != INVALID_PAGE_ID) {
+        Page *page = heap_->bpm_->FetchPage(page_id_, AccessType::SCAN);
+        if (page == nullptr) {
+            LOG_ERROR("Failed to fetch page " << page_id_ << " during table scan");
+            page_id_ = INVALID_PAGE_ID;
+            break;
+        }
+        page->RLatch();
+        TablePage table_page(page);
+        uint32_t slot_count = table_page.GetSlotCount();
+        for (uint32_t slot = 0; slot < slot_count; ++slot) {
+            uint32_t size;
+            const char *data = table_page.GetTuple(slot, &size);
+            if (data == nullptr) continue;
+            page_tuples_.emplace_back(RID(page_id_, slot), Tuple());
+            page_tuples_.back().second.DeserializeFrom(*heap_->schema_, data);
+        }
+        next_page_id_ = table_page.GetNextPageId();
+        page->RUnlatch();
+        heap_->bpm_->UnpinPage(page_id_, false);
+
+        if (!page_tuples_.empty()) break;
+        page_id_ = next_page_id_;
+    }
+}
+
+} // namespace simpledb
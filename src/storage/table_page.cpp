@@ -0,0 +1,205 @@
+#include "storage/table_page.h"
+#include <cstring>
+
+namespace simpledb {
+
+void TablePage::Init(page_id_t next_page_id) {
+    SetNextPageId(next_page_id);
+    SetFreeSpacePtr(PAGE_SIZE);
+    SetSlotCount(0);
+    SetLSN(0);
+}
+
+page_id_t TablePage::GetNextPageId() const {
+    page_id_t id;
+    memcpy(&id, data_ + OFFSET_NEXT_PAGE_ID, sizeof(page_id_t));
+    return id;
+}
+
+void TablePage::SetNextPageId(page_id_t next_page_id) {
+    memcpy(data_ + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+}
+
+uint32_t TablePage::GetSlotCount() const {
+    uint32_t count;
+    memcpy(&count, data_ + OFFSET_SLOT_COUNT, sizeof(uint32_t));
+    return count;
+}
+
+void TablePage::SetSlotCount(uint32_t count) {
+    memcpy(data_ + OFFSET_SLOT_COUNT, &count, sizeof(uint32_t));
+}
+
+lsn_t TablePage::GetLSN() const {
+    lsn_t lsn;
+    memcpy(&lsn, data_ + OFFSET_LSN, sizeof(lsn_t));
+    return lsn;
+}
+
+void TablePage::SetLSN(lsn_t lsn) {
+    memcpy(data_ + OFFSET_LSN, &lsn, sizeof(lsn_t));
+}
+
+uint32_t TablePage::GetFreeSpacePtr() const {
+    uint32_t ptr;
+    memcpy(&ptr, data_ + OFFSET_FREE_SPACE, sizeof(uint32_t));
+    return ptr;
+}
+
+void TablePage::SetFreeSpacePtr(uint32_t ptr) {
+    memcpy(data_ + OFFSET_FREE_SPACE, &ptr, sizeof(uint32_t));
+}
+
+uint32_t TablePage::GetSlotOffset(uint32_t slot_num) const {
+    uint32_t offset;
+    memcpy(&offset, data_ + HEADER_SIZE + slot_num * SLOT_SIZE, sizeof(uint32_t));
+    return offset;
+}
+
+uint32_t TablePage::GetSlotSize(uint32_t slot_num) const {
+    uint32_t size;
+    memcpy(&size, data_ + HEADER_SIZE + slot_num * SLOT_SIZE + 4, sizeof(uint32_t));
+    return size;
+}
+
+void TablePage::SetSlot(uint32_t slot_num, uint32_t offset, uint32_t size) {
+    memcpy(data_ + HEADER_SIZE + slot_num * SLOT_SIZE, &offset, sizeof(uint32_t));
+    memcpy(data_ + HEADER_SIZE + slot_num * SLOT_SIZE + 4, &size, sizeof(uint32_t));
+}
+
+uint32_t TablePage::GetFreeSpace() const {
+    return GetFreeSpacePtr() - HEADER_SIZE - GetSlotCount() * SLOT_SIZE;
+}
+
+bool TablePage::InsertTuple(const char *tuple_data, uint32_t size, uint32_t *slot_num) {
+    if (size == 0) return false;
+
+    uint32_t slot_count = GetSlotCount();
+    uint32_t slot = slot_count;
+    for (uint32_t i = 0; i < slot_count; ++i) {
+        if (GetSlotSize(i) == 0) {
+            slot = i;
+            break;
+        }
+    }
+
+    uint32_t needed = size + (slot == slot_count ? SLOT_SIZE : 0);
+    if (GetFreeSpace() < needed) {
+        if (GetFreeSpace() + GetReclaimableSpace() < needed) return false;
+        Compact();
+        return InsertTuple(tuple_data, size, slot_num);
+    }
+
+    uint32_t offset = GetFreeSpacePtr() - size;
+    memcpy(data_ + offset, tuple_data, size);
+    SetFreeSpacePtr(offset);
+    SetSlot(slot, offset, size);
+    if (slot == slot_count) SetSlotCount(slot_count + 1);
+
+    *slot_num = slot;
+    return true;
+}
+
+bool TablePage::InsertTupleAt(uint32_t slot_num, const char *tuple_data, uint32_t size) {
+    uint32_t slot_count = GetSlotCount();
+    if (size == 0) return false;
+    if (slot_num < slot_count && GetSlotSize(slot_num) != 0) {
+        // A tombstone in the slot means the original insert compacted the page first.
+        if ((GetSlotSize(slot_num) & TOMBSTONE) == 0) return false;
+        Compact();
+        return InsertTupleAt(slot_num, tuple_data, size);
+    }
+
+    uint32_t new_slots = slot_num < slot_count ? 0 : slot_num + 1 - slot_count;
+    if (GetFreeSpace() < size + new_slots * SLOT_SIZE) {
+        // Mirror InsertTuple, which compacts a page before giving up on it.
+        if (GetReclaimableSpace() == 0) return false;
+        Compact();
+        return InsertTupleAt(slot_num, tuple_data, size);
+    }
+    for (uint32_t i = slot_count; i < slot_num; ++i) SetSlot(i, 0, 0);
+
+    uint32_t offset = GetFreeSpacePtr() - size;
+    memcpy(data_ + offset, tuple_data, size);
+    SetFreeSpacePtr(offset);
+    SetSlot(slot_num, offset, size);
+    if (new_slots > 0) SetSlotCount(slot_num + 1);
+    return true;
+}
+
+bool TablePage::DeleteTuple(uint32_t slot_num) {
+    if (slot_num >= GetSlotCount()) return false;
+    uint32_t size = GetSlotSize(slot_num);
+    if (size == 0 || (size & TOMBSTONE) != 0) return false;
+    SetSlot(slot_num, GetSlotOffset(slot_num), size | TOMBSTONE);
+    return true;
+}
+
+bool TablePage::UpdateTuple(uint32_t slot_num, const char *tuple_data, uint32_t size) {
+    if (slot_num >= GetSlotCount() || size == 0) return false;
+    uint32_t old_size = GetSlotSize(slot_num);
+    if (old_size == 0 || (old_size & TOMBSTONE) != 0) return false;
+
+    // Shrinking or same-size images overwrite the old bytes; the unused tail is left for Compact.
+    if (size <= old_size) {
+        memcpy(data_ + GetSlotOffset(slot_num), tuple_data, size);
+        SetSlot(slot_num, GetSlotOffset(slot_num), size);
+        return true;
+    }
+    if (GetFreeSpace() < size) {
+        if (GetFreeSpace() + GetReclaimableSpace() + old_size < size) return false;
+        // Drop the old image along with any other dead bytes, then place the new one.
+        SetSlot(slot_num, GetSlotOffset(slot_num), old_size | TOMBSTONE);
+        Compact();
+    }
+
+    uint32_t offset = GetFreeSpacePtr() - size;
+    memcpy(data_ + offset, tuple_data, size);
+    SetFreeSpacePtr(offset);
+    SetSlot(slot_num, offset, size);
+    if (slot_num >= GetSlotCount()) SetSlotCount(slot_num + 1);
+    return true;
+}
+
+uint32_t TablePage::GetReclaimableSpace() const {
+    uint32_t live = 0;
+    uint32_t slot_count = GetSlotCount();
+    for (uint32_t i = 0; i < slot_count; ++i) {
+        uint32_t size = GetSlotSize(i);
+        if ((size & TOMBSTONE) == 0) live += size;
+    }
+    return PAGE_SIZE - GetFreeSpacePtr() - live;
+}
+
+void TablePage::Compact() {
+    // Move live tuples to a scratch page in slot order, then copy the data region back.
+    char scratch[PAGE_SIZE];
+    uint32_t free_ptr = PAGE_SIZE;
+    uint32_t slot_count = GetSlotCount();
+    for (uint32_t i = 0; i < slot_count; ++i) {
+        uint32_t size = GetSlotSize(i);
+        if (size == 0 || (size & TOMBSTONE) != 0) {
+            SetSlot(i, 0, 0);
+            continue;
+        }
+        free_ptr -= size;
+        memcpy(scratch + free_ptr, data_ + GetSlotOffset(i), size);
+        SetSlot(i, free_ptr, size);
+    }
+    memcpy(data_ + free_ptr, scratch + free_ptr, PAGE_SIZE - free_ptr);
+    SetFreeSpacePtr(free_ptr);
+
+    // Trailing empty slots are dropped so the directory does not grow without bound.
+    while (slot_count > 0 && GetSlotSize(slot_count - 1) == 0) slot_count--;
+    SetSlotCount(slot_count);
+}
+
+const char *TablePage::GetTuple(uint32_t slot_num, uint32_t *size) const {
+    if (slot_num >= GetSlotCount()) return nullptr;
+    uint32_t s = GetSlotSize(slot_num);
+    if (s == 0 || (s & TOMBSTONE) != 0) return nullptr;
+    *size = s;
+    return data_ + GetSlotOffset(slot_num);
+}
+
+} // namespace simpledb
@@ -0,0 +1,49 @@
+#include "storage/vacuum_manager.h"
+#include <algorithm>
+#include <chrono>
+
+namespace simpledb {
+
+VacuumManager::VacuumManager(Catalog *catalog, LogManager *log_manager, std::shared_mutex *statement_latch)
+    : catalog_(catalog), log_manager_(log_manager), statement_latch_(statement_latch) {}
+
+VacuumManager::~VacuumManager() {
+    {
+        std::lock_guard<std::mutex> guard(background_latch_);
+        stop_ = true;
+    }
+    background_cv_.notify_all();
+    if (background_thread_.joinable()) background_thread_.join();
+}
+
+size_t VacuumManager::Step(size_t max_pages) {
+    std::unique_lock<std::shared_mutex> guard(*statement_latch_);
+    std::vector<std::string> names = catalog_->GetTableNames();
+    std::sort(names.begin(), names.end());
+
+    size_t compacted = 0;
+    for (size_t i = 0; i < names.size() && compacted < max_pages; ++i) {
+        TableHeap *heap = catalog_->GetTable(names[(next_table_ + i) % names.size()])->table_.get();
+        if (heap->NeedsVacuum()) compacted += heap->VacuumStep(max_pages - compacted);
+    }
+    if (!names.empty()) next_table_ = (next_table_ + 1) % names.size();
+    if (compacted > 0 && log_manager_ != nullptr) log_manager_->Commit(log_manager_->AppendRecord(LogRecord::Commit()));
+    return compacted;
+}
+
+void VacuumManager::StartBackground(size_t pages_per_step) {
+    background_thread_ = std::thread([this, pages_per_step] { BackgroundLoop(pages_per_step); });
+}
+
+void VacuumManager::BackgroundLoop(size_t pages_per_step) {
+    std::unique_lock<std::mutex> lock(background_latch_);
+    while (!stop_) {
+        background_cv_.wait_for(lock, std::chrono::milliseconds(VACUUM_POLL_MS), [&] { return stop_; });
+        if (stop_) break;
+        lock.unlock();
+        Step(pages_per_step);
+        lock.lock();
+    }
+}
+
+} // namespace simpledb